@@ -11,8 +11,14 @@
 #include "progressbar.hpp"
 #include "tpu_mlir/Support/Float8.h"
 #include "tpu_mlir/Support/GmemAllocator.h"
+#include "tpu_mlir/Interfaces/FlopsInterface.h"
 #include "tpu_mlir/Support/MathUtils.h"
+#include "llvm/Support/JSON.h"
+#include "omp.h"
 #include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <set>
 #define DEBUG_TYPE "interpreter"
 
 static const int64_t MAX_COUNT_LIMIT = 0x100000000ll;
@@ -64,6 +70,7 @@ bool ModuleInterpreter::is_no_mem_op(Operation *op) {
 }
 
 void ModuleInterpreter::allocate_resources() {
+  loop_plans.clear();
   switch (mem_mode) {
   case mem_mode_t::ALL_TENSOR_IN_MEM:
     allocate_all_tensor_in_mem();
@@ -666,293 +673,81 @@ void ModuleInterpreter::invoke_all_in_mem(bool express_type) {
         call_after_hook(name);
         return WalkResult::advance();
       } else if (isa<top::LoopOp, tpu::LoopOp>(op)) {
-        if (isa<top::NoneOp>(op->getOperand(0).getDefiningOp())) {
-          if (isa<top::WeightOp>(op->getOperand(1).getDefiningOp()) &&
-              cast<top::WeightOp>(op->getOperand(1).getDefiningOp())
-                      .read_as_float()
-                      ->data()[0] == 1.0f) {
-            flag = 3; // do_while
-          } else
-            flag = 4; // while
-        }
-
-        if (isa<top::NoneOp>(op->getOperand(1).getDefiningOp())) {
-          flag = 5; // for
-        }
-
-        if (!isa<top::NoneOp>(op->getOperand(0).getDefiningOp()) &&
-            !isa<top::NoneOp>(op->getOperand(0).getDefiningOp())) {
-          /* input (trip_count, cond)
-             int trip_count = ...;
-             bool cond = ...;
-             for (int i=0; i < trip_count && cond; ++i) {
-                  cond = ...;
-             }
-          */
-          flag = 6;
-        }
-
-        if (isa<top::NoneOp>(op->getOperand(0).getDefiningOp()) &&
-            isa<top::NoneOp>(op->getOperand(0).getDefiningOp())) {
-          /* input (\"\", \"\"):
-            for (int i=0; ; ++i) {
-              cond = ... // Note this value is ignored, but is required in the
-            body
-            }
-          */
-          flag = 7; // loop forerver
-          llvm_unreachable(
-              "fatal error(loop forerver), please modify the origin model");
-        }
-
         loop_name = name;
-        Block *bodyBlock;
-        // Block &bodyBlock = cast<top::LoopOp>(op).getBody().front();
-
-        TypeSwitch<Operation *>(op).Case<top::LoopOp, tpu::LoopOp>(
-            [&](auto op_) { bodyBlock = &(op_.getBody().front()); });
-
-        auto result_index = [&](Operation *op, int k) -> std::size_t {
-          int index = 0;
-          const auto &results = op->getOperand(k).getDefiningOp()->getResults();
-          if (results.size() >= 2) {
-            for (int i = 0; i < results.size(); i++) {
-              if (results[i] == op->getOperand(k)) {
-                index = i;
-              }
-            }
-          }
-          return index;
-        };
-
-        using NEW_TYPE =
-            std::vector<std::pair<std::size_t, std::unique_ptr<float[]>>>;
-        auto execute_body = [&](Block &bodyBlock, std::size_t &cond,
-                                const std::string &loop_name, const int l,
-                                Operation *const &op,
-                                NEW_TYPE &backup) -> void {
-          bodyBlock.walk<WalkOrder::PreOrder>([&](Operation *op_) {
-            if (auto infer_op = dyn_cast<InferenceInterface>(op_)) {
-              std::string op_name;
-              if (op_->getLoc().isa<NameLoc>() ||
-                  op_->getLoc().isa<FusedLoc>()) {
-                op_name = module::getName(op_).str();
-              }
-              LLVM_DEBUG(llvm::dbgs() << "compute: '" << op_ << "'\n");
-              call_before_hook(name);
-              if (failed(infer_op.inference(*inference_map[op_name]))) {
-                infer_op.dump();
-                llvm_unreachable("invoke failed!!");
-              }
-              call_after_hook(name);
-            }
+        auto &plan = get_loop_plan(op);
+        flag = plan.mode;
+        auto &param = *inference_map[loop_name];
 
-            // move data to LoopOp's result
-            if (isa<tpu::YieldOp, top::YieldOp>(op_)) {
-              for (int k = 0; k < op_->getNumOperands(); k++) {
-                if (!k) {
-                  if (!isa<BlockArgument>(op_->getOperand(k))) {
-                    auto name =
-                        module::getName(op_->getOperand(k).getDefiningOp())
-                            .str();
-                    cond = inference_map[name]->outputs[0][0];
-                  }
-                } else {
-                  auto num_element = module::getNumElements(op_->getOperand(k));
-                  // can return the argument
-                  if (isa<BlockArgument>(op_->getOperand(k))) {
-                    auto index =
-                        op_->getOperand(k).cast<BlockArgument>().getArgNumber();
-#pragma omp parallel for schedule(static, omp_schedule(num_element))
-                    for (int i = 0; i < num_element; i++) {
-                      inference_map[loop_name]->outputs[k - 1][i] =
-                          inference_map[loop_name]->inputs[index][i];
-                    }
-                  } else {
-                    // Op maybe have more than 2 results
-                    auto index = result_index(op_, k);
-                    auto name =
-                        module::getName(op_->getOperand(k).getDefiningOp())
-                            .str();
-#pragma omp parallel for schedule(static, omp_schedule(num_element))
-                    for (int i = 0; i < num_element; i++) {
-                      inference_map[loop_name]->outputs[k - 1][i] =
-                          inference_map[name]->outputs[index][i];
-                    }
-                  }
-                }
-              }
-
-              /* update the argument because of
-                 loop-carried-dependency for next iteration */
-              int Initial_V_size = 0;
-              TypeSwitch<Operation *>(op).Case<top::LoopOp, tpu::LoopOp>(
-                  [&](auto Op) { Initial_V_size = Op.getVInitial().size(); });
-
-              for (int k = 0; k < Initial_V_size; k++) {
-                if (!l) {
-                  // backup the data, for later compare
-                  if (!isa<BlockArgument>(op_->getOperand(k + 1)) &&
-                      !isa<top::WeightOp>(
-                          op->getOperand(k + 2).getDefiningOp())) {
-                    auto name =
-                        module::getName(op->getOperand(k + 2).getDefiningOp())
-                            .str();
-                    auto num_element =
-                        module::getNumElements(op_->getOperand(k + 1));
-                    std::unique_ptr<float[]> data{
-                        std::make_unique<float[]>(num_element)};
-                    auto index = result_index(op, k + 2);
-#pragma omp parallel for schedule(static, omp_schedule(num_element))
-                    for (int m = 0; m < num_element; m++) {
-                      data[m] = inference_map[name]->outputs[index][m];
-                    }
-                    backup.emplace_back(k, std::move(data));
-                  }
-                }
-
-                if (!isa<BlockArgument>(op_->getOperand(k + 1))) {
-                  // update the data for next iteration
-                  auto src_name =
-                      module::getName(op_->getOperand(k + 1).getDefiningOp())
-                          .str();
-                  auto src_index = result_index(op_, k + 1);
-                  auto num_element =
-                      module::getNumElements(op_->getOperand(k + 1));
-
-                  Value::user_iterator begin =
-                      bodyBlock.getArgument(k + 2).user_begin();
-                  Value::user_iterator end =
-                      bodyBlock.getArgument(k + 2).user_end();
-                  for (; begin != end; begin++) {
-                    auto dst_name = module::getName(*begin).str();
-
-                    std::size_t dst_index = 0;
-                    for (int p = 0; p < (*begin)->getOperands().size(); p++) {
-                      if ((*begin)->getOperand(p) ==
-                          bodyBlock.getArgument(k + 2)) {
-                        dst_index = p;
-                      }
-                    }
-
-#pragma omp parallel for schedule(static, omp_schedule(num_element))
-                    for (int m = 0; m < num_element; m++) {
-                      inference_map[dst_name]->inputs[dst_index][m] =
-                          inference_map[src_name]->outputs[src_index][m];
-                    }
-                  }
-                }
-              }
-            }
-            return WalkResult::advance();
-          });
-        };
-
-        auto restore_data =
-            [&](NEW_TYPE &backup,
-                std::map<std::string, std::shared_ptr<InferenceParameter>>
-                    &inference_map) {
-              // restore the data
-              for (int kk = 0; kk < backup.size(); kk++) {
-                std::size_t operand_index;
-                std::unique_ptr<float[]> data;
-                std::tie(operand_index, data) = std::move(backup[kk]);
-                auto dst_name =
-                    module::getName(
-                        op->getOperand(operand_index).getDefiningOp())
-                        .str();
-                auto num_element =
-                    module::getNumElements(op->getOperand(operand_index));
-                auto dst_index = result_index(op, operand_index);
-#pragma omp parallel for schedule(static, omp_schedule(num_element))
-                for (int m = 0; m < num_element; m++) {
-                  inference_map[dst_name]->outputs[dst_index][m] = data[m];
-                }
-              }
-            };
-
-        auto no_loop_handle = [&](Operation *op, const std::string &loop_name) {
+        auto no_loop_handle = [&](Operation *op) {
           int number = op->getResults().size() > (op->getNumOperands() - 2)
                            ? (op->getNumOperands() - 2)
                            : op->getResults().size();
           for (int32_t i = 0; i < number; i++) {
             auto num_element = module::getNumElements(op->getOperand(i + 2));
-#pragma omp parallel for schedule(static, omp_schedule(num_element))
-            for (int k = 0; k < num_element; k++) {
-              inference_map[loop_name]->outputs[i][k] =
-                  inference_map[loop_name]->inputs[i + 2][k];
-            }
+            std::copy_n(param.inputs[i + 2], num_element, param.outputs[i]);
           }
         };
 
+        // backup the data overwritten by loop-carried values, for later use
+        for (int i = 0; i < plan.backup.size(); i++) {
+          auto &b = plan.backup[i];
+          std::copy_n(b.src, b.num, plan.backup_data[i].data());
+        }
         if (flag == 3) {
-          std::size_t cond =
-              (std::size_t)((*inference_map[loop_name]).inputs[1][0]);
-          NEW_TYPE backup;
-          int l = 0;
+          std::size_t cond = (std::size_t)(param.inputs[1][0]);
           do {
-            execute_body(*bodyBlock, cond, loop_name, l, op, backup);
-            l = 1;
+            run_loop_body(plan, cond, loop_name);
           } while (cond);
-          restore_data(backup, inference_map);
         } else if (flag == 4) {
-          std::size_t cond =
-              (std::size_t)((*inference_map[loop_name]).inputs[1][0]);
-          NEW_TYPE backup;
-          int l = 0;
+          std::size_t cond = (std::size_t)(param.inputs[1][0]);
           int no_loop = cond ? 0 : 1;
           while (cond) {
-            execute_body(*bodyBlock, cond, loop_name, l, op, backup);
-            l = 1;
+            run_loop_body(plan, cond, loop_name);
           };
 
           // align with onnxruntime
           if (no_loop) {
-            no_loop_handle(op, loop_name);
+            no_loop_handle(op);
           }
-
-          restore_data(backup, inference_map);
         } else if (flag == 5) {
-          std::size_t trip_count = (*inference_map[loop_name]).inputs[0][0];
+          std::size_t trip_count = param.inputs[0][0];
           std::size_t cond = 1;
-          NEW_TYPE backup;
           int no_loop = trip_count ? 0 : 1;
           for (int l = 0; l < trip_count; l++) {
-            execute_body(*bodyBlock, cond, loop_name, l, op, backup);
+            run_loop_body(plan, cond, loop_name);
           }
 
           // align with onnxruntime
           if (no_loop) {
-            no_loop_handle(op, loop_name);
+            no_loop_handle(op);
           }
-
-          restore_data(backup, inference_map);
         } else if (flag == 6) {
-          std::size_t trip_count = (*inference_map[loop_name]).inputs[0][0];
-          std::size_t cond =
-              (std::size_t)((*inference_map[loop_name]).inputs[1][0]);
-          NEW_TYPE backup;
+          std::size_t trip_count = param.inputs[0][0];
+          std::size_t cond = (std::size_t)(param.inputs[1][0]);
           int no_loop = (cond && trip_count) ? 0 : 1;
           for (int l = 0; l < trip_count && cond; l++) {
-            execute_body(*bodyBlock, cond, loop_name, l, op, backup);
+            run_loop_body(plan, cond, loop_name);
           }
 
           // align with onnxruntime
           if (no_loop) {
-            no_loop_handle(op, loop_name);
+            no_loop_handle(op);
           }
-
-          restore_data(backup, inference_map);
         } else {
           llvm_unreachable("other loop mode: Todo");
         }
+        // restore the data
+        for (int i = 0; i < plan.backup.size(); i++) {
+          auto &b = plan.backup[i];
+          std::copy_n(plan.backup_data[i].data(), b.num, b.dst);
+        }
         // other loop mode: Todo
         return WalkResult::advance();
       } else if (isa<tpu_mlir::InferenceInterface>(op) && 0 == flag) {
         bar.update();
         auto infer_op = dyn_cast<InferenceInterface>(op);
         call_before_hook(name);
-        if (failed(infer_op.inference(*inference_map[name]))) {
+        if (failed(run_inference(infer_op, *inference_map[name]))) {
           infer_op.dump();
           llvm_unreachable("invoke failed!!");
         }
@@ -960,7 +755,7 @@ void ModuleInterpreter::invoke_all_in_mem(bool express_type) {
       } else if (flag && op->getParentRegion()->getRegionNumber() == flag - 1) {
         if (auto infer_op = dyn_cast<InferenceInterface>(op)) {
           call_before_hook(name);
-          if (failed(infer_op.inference(*inference_map[name]))) {
+          if (failed(run_inference(infer_op, *inference_map[name]))) {
             infer_op.dump();
             llvm_unreachable("invoke failed!!");
           }
@@ -1005,6 +800,341 @@ void ModuleInterpreter::invoke_all_in_mem(bool express_type) {
   }
 }
 
+ModuleInterpreter::LoopPlan &ModuleInterpreter::get_loop_plan(Operation *op) {
+  auto it = loop_plans.find(op);
+  if (it != loop_plans.end()) {
+    return *it->second;
+  }
+  auto plan = std::make_unique<LoopPlan>();
+  int flag = 0;
+  if (isa<top::NoneOp>(op->getOperand(0).getDefiningOp())) {
+    if (isa<top::WeightOp>(op->getOperand(1).getDefiningOp()) &&
+        cast<top::WeightOp>(op->getOperand(1).getDefiningOp())
+                .read_as_float()
+                ->data()[0] == 1.0f) {
+      flag = 3; // do_while
+    } else
+      flag = 4; // while
+  }
+
+  if (isa<top::NoneOp>(op->getOperand(1).getDefiningOp())) {
+    flag = 5; // for
+  }
+
+  if (!isa<top::NoneOp>(op->getOperand(0).getDefiningOp()) &&
+      !isa<top::NoneOp>(op->getOperand(0).getDefiningOp())) {
+    /* input (trip_count, cond)
+       int trip_count = ...;
+       bool cond = ...;
+       for (int i=0; i < trip_count && cond; ++i) {
+            cond = ...;
+       }
+    */
+    flag = 6;
+  }
+
+  if (isa<top::NoneOp>(op->getOperand(0).getDefiningOp()) &&
+      isa<top::NoneOp>(op->getOperand(0).getDefiningOp())) {
+    /* input (\"\", \"\"):
+      for (int i=0; ; ++i) {
+        cond = ... // Note this value is ignored, but is required in the
+      body
+      }
+    */
+    flag = 7; // loop forerver
+    llvm_unreachable(
+        "fatal error(loop forerver), please modify the origin model");
+  }
+  plan->mode = flag;
+
+  Block *bodyBlock;
+  int Initial_V_size = 0;
+  TypeSwitch<Operation *>(op).Case<top::LoopOp, tpu::LoopOp>([&](auto op_) {
+    bodyBlock = &(op_.getBody().front());
+    Initial_V_size = op_.getVInitial().size();
+  });
+
+  // Op maybe have more than 2 results
+  auto result_index = [&](Operation *op, int k) -> std::size_t {
+    int index = 0;
+    const auto &results = op->getOperand(k).getDefiningOp()->getResults();
+    if (results.size() >= 2) {
+      for (int i = 0; i < results.size(); i++) {
+        if (results[i] == op->getOperand(k)) {
+          index = i;
+        }
+      }
+    }
+    return index;
+  };
+  auto output_of = [&](Operation *op, int k) -> float * {
+    auto name = module::getName(op->getOperand(k).getDefiningOp()).str();
+    return inference_map[name]->outputs[result_index(op, k)];
+  };
+
+  auto &loop_param = *inference_map[module::getName(op).str()];
+  bodyBlock->walk<WalkOrder::PreOrder>([&](Operation *op_) {
+    if (auto infer_op = dyn_cast<InferenceInterface>(op_)) {
+      std::string op_name;
+      if (op_->getLoc().isa<NameLoc>() || op_->getLoc().isa<FusedLoc>()) {
+        op_name = module::getName(op_).str();
+      }
+      plan->body.emplace_back(infer_op, inference_map[op_name].get());
+    }
+  });
+
+  auto yield = bodyBlock->getTerminator();
+  assert((isa<tpu::YieldOp, top::YieldOp>(yield)));
+  for (int k = 0; k < yield->getNumOperands(); k++) {
+    auto opd = yield->getOperand(k);
+    if (!k) {
+      if (!isa<BlockArgument>(opd)) {
+        auto name = module::getName(opd.getDefiningOp()).str();
+        plan->cond = inference_map[name]->outputs[0];
+      }
+      continue;
+    }
+    // move data to LoopOp's result, can return the argument
+    const float *src =
+        isa<BlockArgument>(opd)
+            ? loop_param.inputs[opd.cast<BlockArgument>().getArgNumber()]
+            : output_of(yield, k);
+    plan->results.push_back(
+        {src, loop_param.outputs[k - 1], module::getNumElements(opd)});
+  }
+
+  /* update the argument because of
+     loop-carried-dependency for next iteration */
+  for (int k = 0; k < Initial_V_size; k++) {
+    auto opd = yield->getOperand(k + 1);
+    if (isa<BlockArgument>(opd)) {
+      continue;
+    }
+    auto num_element = module::getNumElements(opd);
+    std::set<float *> dsts;
+    for (auto user : bodyBlock->getArgument(k + 2).getUsers()) {
+      auto dst_name = module::getName(user).str();
+      auto iter = inference_map.find(dst_name);
+      if (iter == inference_map.end()) {
+        continue;
+      }
+      for (int p = 0; p < user->getNumOperands(); p++) {
+        if (user->getOperand(p) == bodyBlock->getArgument(k + 2)) {
+          dsts.insert(iter->second->inputs[p]);
+        }
+      }
+    }
+    for (auto dst : dsts) {
+      plan->carried.push_back({output_of(yield, k + 1), dst, num_element});
+    }
+    if (!isa<top::WeightOp>(op->getOperand(k + 2).getDefiningOp())) {
+      auto outer = output_of(op, k + 2);
+      plan->backup.push_back({outer, outer, num_element});
+      plan->backup_data.emplace_back(num_element);
+    }
+  }
+  return *(loop_plans[op] = std::move(plan));
+}
+
+void ModuleInterpreter::run_loop_body(LoopPlan &plan, std::size_t &cond,
+                                      const std::string &loop_name) {
+  for (auto &it : plan.body) {
+    LLVM_DEBUG(llvm::dbgs() << "compute: '" << it.first.getOperation()
+                            << "'\n");
+    call_before_hook(loop_name);
+    if (failed(run_inference(it.first, *it.second))) {
+      it.first.dump();
+      llvm_unreachable("invoke failed!!");
+    }
+    call_after_hook(loop_name);
+  }
+  if (plan.cond) {
+    cond = plan.cond[0];
+  }
+  for (auto &c : plan.results) {
+#pragma omp parallel for schedule(static, omp_schedule(c.num))
+    for (int64_t i = 0; i < c.num; i++) {
+      c.dst[i] = c.src[i];
+    }
+  }
+  for (auto &c : plan.carried) {
+#pragma omp parallel for schedule(static, omp_schedule(c.num))
+    for (int64_t i = 0; i < c.num; i++) {
+      c.dst[i] = c.src[i];
+    }
+  }
+}
+
+static double process_cpu_us() {
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static double wall_us() {
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration<double, std::micro>(now).count();
+}
+
+LogicalResult ModuleInterpreter::run_inference(InferenceInterface infer_op,
+                                               InferenceParameter &p) {
+  if (!profile_enable) {
+    return infer_op.inference(p);
+  }
+  auto op = infer_op.getOperation();
+  double cpu_start = process_cpu_us();
+  double start = wall_us();
+  auto ret = infer_op.inference(p);
+  double end = wall_us();
+  double cpu_end = process_cpu_us();
+
+  ProfileRecord record;
+  record.name = module::getName(op).str();
+  record.type = op->getName().getStringRef().str();
+  record.start_us = start;
+  record.time_us = end - start;
+  record.cpu_us = cpu_end - cpu_start;
+  record.flops = 0;
+  if (auto flops_op = dyn_cast<FlopsInterface>(op)) {
+    record.flops = flops_op.getFLOPs();
+  }
+  // interpreter keeps every tensor as float
+  record.bytes = 0;
+  for (auto v : op->getOperands()) {
+    if (!module::isNone(v)) {
+      record.bytes += module::getNumElements(v) * sizeof(float);
+    }
+  }
+  for (auto v : op->getResults()) {
+    if (!module::isNone(v)) {
+      record.bytes += module::getNumElements(v) * sizeof(float);
+    }
+  }
+  profile_records.push_back(std::move(record));
+  return ret;
+}
+
+void ModuleInterpreter::set_profile(bool enable) {
+  profile_enable = enable;
+  profile_records.clear();
+}
+
+void ModuleInterpreter::dump_profile(const std::string &json_file,
+                                     const std::string &trace_file) {
+  struct Summary {
+    int64_t count = 0;
+    double time_us = 0;
+    double cpu_us = 0;
+    int64_t flops = 0;
+    int64_t bytes = 0;
+  };
+  // keep layers in invoking order, loop body ops are merged
+  std::vector<std::string> layer_order;
+  std::map<std::string, Summary> layers;
+  std::map<std::string, std::string> layer_types;
+  std::map<std::string, Summary> op_types;
+  Summary total;
+  for (auto &r : profile_records) {
+    if (layers.find(r.name) == layers.end()) {
+      layer_order.push_back(r.name);
+      layer_types[r.name] = r.type;
+    }
+    for (auto s : {&layers[r.name], &op_types[r.type], &total}) {
+      s->count++;
+      s->time_us += r.time_us;
+      s->cpu_us += r.cpu_us;
+      s->flops += r.flops;
+      s->bytes += r.bytes;
+    }
+  }
+  int threads = omp_get_max_threads();
+  auto write_summary = [&](llvm::json::OStream &J, const Summary &s) {
+    double sec = s.time_us / 1e6;
+    J.attribute("count", s.count);
+    J.attribute("time_us", s.time_us);
+    J.attribute("flops", s.flops);
+    J.attribute("bytes", s.bytes);
+    J.attribute("gflops", sec > 0 ? s.flops / sec / 1e9 : 0.);
+    J.attribute("gbps", sec > 0 ? s.bytes / sec / 1e9 : 0.);
+    J.attribute("thread_util",
+                s.time_us > 0 ? s.cpu_us / (s.time_us * threads) : 0.);
+  };
+
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(json_file, EC);
+  if (EC) {
+    llvm::errs() << "open " << json_file << " failed: " << EC.message()
+                 << "\n";
+    return;
+  }
+  llvm::json::OStream J(OS, 2);
+  J.objectBegin();
+  J.attribute("threads", threads);
+  J.attributeBegin("total");
+  J.objectBegin();
+  write_summary(J, total);
+  J.objectEnd();
+  J.attributeEnd();
+  J.attributeBegin("op_types");
+  J.arrayBegin();
+  for (auto &it : op_types) {
+    J.objectBegin();
+    J.attribute("type", it.first);
+    write_summary(J, it.second);
+    J.objectEnd();
+  }
+  J.arrayEnd();
+  J.attributeEnd();
+  J.attributeBegin("layers");
+  J.arrayBegin();
+  for (auto &name : layer_order) {
+    J.objectBegin();
+    J.attribute("name", name);
+    J.attribute("type", layer_types[name]);
+    write_summary(J, layers[name]);
+    J.objectEnd();
+  }
+  J.arrayEnd();
+  J.attributeEnd();
+  J.objectEnd();
+
+  if (trace_file.empty()) {
+    return;
+  }
+  llvm::raw_fd_ostream TOS(trace_file, EC);
+  if (EC) {
+    llvm::errs() << "open " << trace_file << " failed: " << EC.message()
+                 << "\n";
+    return;
+  }
+  // chrome://tracing or perfetto complete events
+  double base = profile_records.empty() ? 0 : profile_records[0].start_us;
+  llvm::json::OStream T(TOS);
+  T.objectBegin();
+  T.attributeBegin("traceEvents");
+  T.arrayBegin();
+  for (auto &r : profile_records) {
+    T.objectBegin();
+    T.attribute("name", r.name);
+    T.attribute("cat", r.type);
+    T.attribute("ph", "X");
+    T.attribute("ts", r.start_us - base);
+    T.attribute("dur", r.time_us);
+    T.attribute("pid", 0);
+    T.attribute("tid", 0);
+    T.attributeBegin("args");
+    T.objectBegin();
+    T.attribute("flops", r.flops);
+    T.attribute("bytes", r.bytes);
+    T.objectEnd();
+    T.attributeEnd();
+    T.objectEnd();
+  }
+  T.arrayEnd();
+  T.attributeEnd();
+  T.objectEnd();
+}
+
 void ModuleInterpreter::value_to_disk(const std::string &filename,
                                       const std::string &name,
                                       std::vector<float> &data,
@@ -1079,7 +1209,7 @@ void ModuleInterpreter::invoke_to_disk(const std::string &filename,
         llvm_unreachable("init failed!!");
       }
       LLVM_DEBUG(llvm::dbgs() << "compute: '" << infer_op << "'\n");
-      if (failed(infer_op.inference(p))) {
+      if (failed(run_inference(infer_op, p))) {
         infer_op.dump();
         llvm_unreachable("invoke failed!!");
       }
@@ -1106,7 +1236,7 @@ void ModuleInterpreter::invoke_part_in_mem(bool express_type) {
       auto name = module::getName(infer_op).str();
       LLVM_DEBUG(llvm::dbgs() << "compute: '" << infer_op << "'\n");
       if (inference_map.find(name) != inference_map.end()) {
-        if (failed(infer_op.inference(*inference_map[name]))) {
+        if (failed(run_inference(infer_op, *inference_map[name]))) {
           infer_op.dump();
           llvm_unreachable("invoke failed!!");
         }
@@ -1164,7 +1294,7 @@ void ModuleInterpreter::invoke_part_in_mem(bool express_type) {
           llvm_unreachable("init failed!!");
         }
         LLVM_DEBUG(llvm::dbgs() << "compute: '" << infer_op << "'\n");
-        if (failed(infer_op.inference(p))) {
+        if (failed(run_inference(infer_op, p))) {
           infer_op.dump();
           llvm_unreachable("invoke failed!!");
         }
@@ -1216,7 +1346,7 @@ ModuleInterpreter::invoke_at(const std::string op_name) {
   auto infer_op = cast<InferenceInterface>(op);
   LLVM_DEBUG(llvm::dbgs() << "invoke at: '" << infer_op << "'\n");
   call_before_hook(op_name);
-  if (failed(infer_op.inference(*inference_map[op_name]))) {
+  if (failed(run_inference(infer_op, *inference_map[op_name]))) {
     infer_op.dump();
     llvm_unreachable("infer_op.inference failed!!");
   }
@@ -1236,7 +1366,7 @@ void ModuleInterpreter::invoke_from(const std::string op_name) {
       LLVM_DEBUG(llvm::dbgs() << "invoke: '" << infer_op << "'\n");
       if (start_run) {
         call_before_hook(name);
-        if (failed(infer_op.inference(*inference_map[name]))) {
+        if (failed(run_inference(infer_op, *inference_map[name]))) {
           infer_op.dump();
           llvm_unreachable("invoke failed!!");
         }
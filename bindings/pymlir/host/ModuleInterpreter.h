@@ -68,6 +68,11 @@ public:
   bool is_no_mem_op(Operation *op);
   // void add_before_forward(CallBack* hook);
   void clear_hooks();
+  // record time, flops and bytes of every op while invoking
+  void set_profile(bool enable);
+  // write per layer and per op type summary as json, and chrome trace events
+  void dump_profile(const std::string &json_file,
+                    const std::string &trace_file = "");
 
 private:
   void allocate_part_tensor_in_mem();
@@ -84,6 +89,39 @@ private:
   void call_before_hook(std::string layer_name);
   void call_after_hook(std::string layer_name);
 
+  // LoopOp body resolved to raw buffers once, replayed by every iteration
+  struct LoopPlan {
+    struct Copy {
+      const float *src;
+      float *dst;
+      int64_t num;
+    };
+    int mode; // 3: do_while, 4: while, 5: for, 6: for with cond
+    std::vector<std::pair<InferenceInterface, InferenceParameter *>> body;
+    const float *cond = nullptr; // nullptr if cond is yielded by argument
+    std::vector<Copy> results;   // yield operands to LoopOp results
+    std::vector<Copy> carried;   // yield operands to loop-carried arguments
+    std::vector<Copy> backup;    // outer values overwritten by carried data
+    std::vector<std::vector<float>> backup_data;
+  };
+  LoopPlan &get_loop_plan(Operation *op);
+  LogicalResult run_inference(InferenceInterface infer_op,
+                              InferenceParameter &p);
+
+  struct ProfileRecord {
+    std::string name;
+    std::string type;
+    double start_us; // since the first record
+    double time_us;  // wall time
+    double cpu_us;   // cpu time of all threads
+    int64_t flops;
+    int64_t bytes; // input and output buffers touched
+  };
+  bool profile_enable = false;
+  std::vector<ProfileRecord> profile_records;
+  void run_loop_body(LoopPlan &plan, std::size_t &cond,
+                     const std::string &loop_name);
+
 public:
   std::vector<std::string> input_names;
   std::vector<std::string> output_names;
@@ -102,6 +140,7 @@ private:
   std::map<std::string, Value> value_map;
   std::map<std::string, std::shared_ptr<InferenceParameter>> inference_map;
   std::map<std::string, std::shared_ptr<std::vector<float>>> mem_map;
+  std::map<Operation *, std::unique_ptr<LoopPlan>> loop_plans;
   // std::vector<float> gMem;
   std::map<std::string, std::pair<uint64_t, uint32_t>> activation_offset;
 };
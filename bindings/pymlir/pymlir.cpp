@@ -113,6 +113,8 @@ PYBIND11_MODULE(pymlir, m) {
       .def("before_invoke", &py_module::before_invoke, "add a before hook")
       .def("after_invoke", &py_module::after_invoke, "add a before hook")
       .def("clear_hooks", &py_module::clear_hooks, "clear hooks")
+      .def("set_profile", &py_module::set_profile, py::arg("enable")=true, "record time, flops and bytes of each op")
+      .def("dump_profile", &py_module::dump_profile, py::arg("json_file"), py::arg("trace_file")="", "dump profile json and chrome trace")
       .def_readonly("input_names", &py_module::input_names)
       .def_readonly("output_names", &py_module::output_names)
       .def_readonly("all_tensor_names", &py_module::all_tensor_names)
@@ -138,6 +138,13 @@ void py_module::invoke(bool fixed_to_float) {
 }
 void py_module::fake_quant_weight() { interpreter_->fake_quant_weight(); }
 
+void py_module::set_profile(bool enable) { interpreter_->set_profile(enable); }
+
+void py_module::dump_profile(const std::string json_file,
+                             const std::string trace_file) {
+  interpreter_->dump_profile(json_file, trace_file);
+}
+
 py::array py_module::invoke_at(const std::string name) {
   auto tensor = interpreter_->invoke_at(name);
   auto shape = interpreter_->getTensorShape(name);
@@ -52,6 +52,9 @@ public:
 
   void invoke_from(const std::string name);
 
+  void set_profile(bool enable);
+  void dump_profile(const std::string json_file, const std::string trace_file);
+
 public:
   py::list all_tensor_names;
   py::list all_weight_names;
@@ -31,6 +31,9 @@ public:
   static int64_t LMEM_BYTES;
   static int64_t LMEM_BANKS;
   static int64_t LMEM_BANK_BYTES;
+  // int8 MACs of TIU per cycle, and bytes of GDMA per cycle
+  static int64_t TIU_MACS;
+  static int64_t GDMA_BYTES;
   static llvm::StringRef LIB_BACKEND_NAME;
   static bool ALIGN_4N;
   static module::Chip chip;
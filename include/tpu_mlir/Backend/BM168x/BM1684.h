@@ -465,6 +465,9 @@ protected:
     EU_BYTES = 128;       // only for int8; 128 for fp32
     LMEM_BYTES = 1 << 19; // 512KB
     LMEM_BANKS = 8;
+    // peak estimation, only for roofline cycle model
+    TIU_MACS = 16384;
+    GDMA_BYTES = 32;
     ALIGNMENT = 0x1000;
     GMEM_START_ADDR = 0x100000000ull;
     L2_SRAM_START_ADDR = 0x10000000 + 0x22000 + 0x80000;
@@ -103,6 +103,9 @@ protected:
     EU_BYTES = 64;
     LMEM_BYTES = 1 << 18; // 256KB
     LMEM_BANKS = 16;
+    // peak estimation, only for roofline cycle model
+    TIU_MACS = 16384;
+    GDMA_BYTES = 64;
     IC_PARALLEL = 64;
     ALIGNMENT = 0x1000;
     GMEM_START_ADDR = 0x100000000ull;
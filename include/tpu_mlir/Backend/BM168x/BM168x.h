@@ -11,6 +11,7 @@
 
 #include "tpu_mlir/Backend/Arch.h"
 #include "tpu_mlir/Backend/BM168x/Param.h"
+#include <mutex>
 
 typedef int (*cmodel_init)(int node_idx, uint64_t global_mem_size);
 typedef void (*cmodel_deinit)(int node_idx);
@@ -339,6 +340,19 @@ public:
     assert(code && "Please initialize the command buffer.");
     return code.get();
   }
+  // Lock held for the whole of one cycle query. Backends bind a global id
+  // node or shared id counters in start_env and issue into the code buffer,
+  // so cycle queries from different threads run one at a time.
+  class CycleQueryLock {
+  public:
+    CycleQueryLock() : lock_(global_mutex()) {}
+
+  private:
+    std::lock_guard<std::recursive_mutex> lock_;
+  };
+  // guards backend state shared by all threads: the code buffer, issue flags
+  // and statistics
+  static std::recursive_mutex &global_mutex();
   std::map<int, uint32_t> net_cpu_mem_size;
   llvm::sys::DynamicLibrary cpuopDL;
   llvm::StringRef libcpuop = "libcpuop.so";
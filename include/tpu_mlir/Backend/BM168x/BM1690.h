@@ -107,6 +107,9 @@ protected:
     EU_BYTES = 64;        // vector length 512bit
     LMEM_BYTES = 1 << 18; // 256KB
     LMEM_BANKS = 16;
+    // peak estimation, only for roofline cycle model
+    TIU_MACS = 8192;
+    GDMA_BYTES = 64;
     IC_PARALLEL = 64;
     ALIGNMENT = 0x1000;
     LMEM_BANK_BYTES = LMEM_BYTES / LMEM_BANKS;
@@ -105,6 +105,9 @@ protected:
     EU_BYTES = (EU_NUM_test_fp16)*2; // origin=16;
     LMEM_BYTES = 1 << LOCAL_MEM_SHIFT; // 128KB
     LMEM_BANKS = 16;
+    // peak estimation, only for roofline cycle model
+    TIU_MACS = 2048;
+    GDMA_BYTES = 16;
     IC_PARALLEL = (IC_PARALLEL_test_fp16)*2; // origin=32;
     ALIGNMENT = 0x1000;
     LMEM_BANK_BYTES = LMEM_BYTES / LMEM_BANKS;
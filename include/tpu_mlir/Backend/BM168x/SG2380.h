@@ -78,6 +78,9 @@ protected:
     EU_BYTES = 16;
     LMEM_BYTES = 1 << 17; // 128KB
     LMEM_BANKS = 16;
+    // peak estimation, only for roofline cycle model
+    TIU_MACS = 4096;
+    GDMA_BYTES = 32;
     IC_PARALLEL = 32;
     ALIGNMENT = 0x1000;
     LMEM_BANK_BYTES = LMEM_BYTES / LMEM_BANKS;
@@ -11,9 +11,11 @@
 #define LIBBMODEL_HPP_
 
 #include <stdint.h>
+#include <cstdio>
 #include <fstream>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "tpu_mlir/Builder/BM168x/bmodel_generated.h"
 
@@ -59,10 +61,17 @@ public:
   } CASCADE_INFO_T;
 
 public:
-  ModelGen(uint32_t reserved_size = 0x1000000);
+  // file_backed keeps the binary in a temp file instead of memory, so large
+  // coeffs are streamed out and only copied behind the flatbuffer at Save.
+  // The temp file is in binary_dir, or TMPDIR or /tmp if it is empty
+  ModelGen(uint32_t reserved_size = 0x1000000, bool file_backed = false,
+           const std::string &binary_dir = "");
   virtual ~ModelGen();
   flatbuffers::FlatBufferBuilder &Builder();
   Binary WriteBinary(size_t size, uint8_t *data);
+  // same as above with content hash computed by caller, see HashBinary
+  Binary WriteBinary(size_t size, uint8_t *data, uint64_t hash);
+  static uint64_t HashBinary(const uint8_t *data, size_t size);
 
   // add model elements
   void AddChip(const std::string &arch_name);
@@ -92,6 +101,9 @@ private:
   IsTensorConflict(const flatbuffers::Vector<flatbuffers::Offset<Tensor>> *,
                    const flatbuffers::Vector<flatbuffers::Offset<Tensor>> *);
   bool IsShapeSame(const Shape *, const Shape *);
+  void ReadBinary(uint64_t start, uint8_t *buffer, uint64_t size);
+  bool IsBinarySame(const Binary &binary, const uint8_t *data);
+  void SaveBinary(std::ostream &out);
 
   typedef struct {
     std::string name;
@@ -114,7 +126,11 @@ private:
   int num_device_;
   flatbuffers::FlatBufferBuilder builder_;
   std::vector<uint8_t> binary_;
+  FILE *binary_file_;    // binary in temp file when file backed
+  uint64_t binary_size_; // binary size of both modes
   std::vector<Binary> binary_vector_;
+  // content hash -> index in binary_vector_
+  std::unordered_multimap<uint64_t, size_t> binary_index_;
   std::vector<NET_INFO_T> net_vector_;
   std::vector<flatbuffers::Offset<bmodel::Net>> nets_;
   uint64_t max_neuron_size_;
@@ -125,7 +141,9 @@ private:
 
 class ModelCtx {
 public:
-  ModelCtx(const std::string &filename);
+  // the file is opened read-only unless writable, which is needed only by
+  // write_binary
+  ModelCtx(const std::string &filename, bool writable = false);
   ModelCtx(const void *bmodel_data, size_t size);
   virtual ~ModelCtx();
   operator bool();
@@ -142,6 +160,10 @@ public:
   void write_binary(const bmodel::Binary *binary, uint64_t offset,
                     uint8_t *buffer, uint64_t size);
 
+  // pointer to binary data in the mapped file or user buffer, no copy;
+  // NULL if the bmodel can only be accessed by read_binary
+  const uint8_t *binary_data(const bmodel::Binary *binary) const;
+
   // model buffer data for parse
   const void *data() const;
 
@@ -162,7 +184,10 @@ private:
   void *model_buffer_;
   uint32_t binary_offset_;
   std::fstream file_;          // bmodel in file
-  const void *bmodel_pointer_; // bmodel in buffer
+  const void *bmodel_pointer_; // bmodel in buffer or mapped file
+  void *mmap_addr_;            // mapped file, NULL if not mapped
+  size_t mmap_size_;
+  bool writable_;              // write_binary allowed
 };
 
 } // namespace bmodel
@@ -0,0 +1,73 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// TPU-MLIR is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "tpu_mlir/Dialect/Tpu/IR/TpuOps.h"
+#include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/LayerGroupDefs.h"
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace tpu_mlir {
+namespace tpu {
+
+typedef enum {
+  CYCLE_LOCAL_LAYER = 0, // CycleCalculator::getLocalLayerCycle
+  CYCLE_LOAD = 1,        // CycleCalculator::getLoadCycle
+  CYCLE_STORE = 2,       // CycleCalculator::getStoreCycle
+  CYCLE_KIND_NUM = 3,
+} cycle_kind_t;
+
+typedef std::vector<uintptr_t> cycle_key_t;
+
+/// Memoize cycles of backend queries during layer group searching.
+/// A local layer is keyed by op kind, attributes (including the fake
+/// LayerGroupAttr), operand and result types and local_sec_info_t; a gdma
+/// tensor by its type, max slice and load/store mode. Types carry the global
+/// address, so the key covers everything the codegen reads. Like
+/// GroupCostCache, it must be cleared when the MLIRContext changes.
+class CycleCache {
+public:
+  static CycleCache &getInstance() {
+    static CycleCache instance;
+    return instance;
+  }
+
+  static void get_local_key(cycle_key_t &key, Operation *op,
+                            const local_sec_info_t &sec_info,
+                            bool calc_bdc_slack);
+  // return false if the cycle depends on more than the key, e.g. 3ic
+  static bool get_load_key(cycle_key_t &key, Value v,
+                           const slice_info_t &si,
+                           const tensor_info_t &tensor_info,
+                           group_type_t group_type);
+  static void get_store_key(cycle_key_t &key, Value v,
+                            const slice_info_t &si, group_type_t group_type);
+
+  bool find(const cycle_key_t &key, int64_t &cycle);
+  void insert(const cycle_key_t &key, int64_t cycle);
+  void clear();
+  void show_statistics();
+
+private:
+  CycleCache() { clear_statistics(); }
+  void clear_statistics();
+
+  struct KeyHash {
+    size_t operator()(const cycle_key_t &key) const;
+  };
+  std::mutex mutex_;
+  std::unordered_map<cycle_key_t, int64_t, KeyHash> cache_;
+  int64_t hit_num_[CYCLE_KIND_NUM];
+  int64_t miss_num_[CYCLE_KIND_NUM];
+};
+
+} // namespace tpu
+} // namespace tpu_mlir
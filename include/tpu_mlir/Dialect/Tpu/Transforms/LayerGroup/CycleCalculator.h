@@ -83,5 +83,32 @@ private:
   bool check_lmem(Operation *op, const TensorInfo &tesnor_info,
                   group_type_t group_type);
 };
+
+/// Estimate cycles by roofline: max of TIU time from FLOPs and GDMA time from
+/// tensor bytes, with peak throughput of Arch. It is much faster than
+/// simulating backend commands, but only a rough estimation.
+class RooflineCycleCalculator : public CycleCalculator {
+public:
+  RooflineCycleCalculator() {}
+  ~RooflineCycleCalculator() {}
+  int64_t getGlobalLayerCycle(Operation *op) override;
+  int64_t getLocalLayerCycle(Operation *op, TensorInfo &tensor_infos,
+                             group_type_t group_type,
+                             bool calc_bdc_slack) override;
+  int64_t getGdmaCycle(Value v, tensor_info_t &tensor_info,
+                       group_type_t group_type,
+                       Operation *owner_op = nullptr, int mode = 0) override;
+  int64_t getLoadCycle(Value v, tensor_info_t &tensor_info,
+                       group_type_t group_type,
+                       Operation *owner_op = nullptr) override;
+  int64_t getStoreCycle(Value v, const tensor_info_t &tensor_info,
+                        group_type_t group_type) override;
+  // group computes all ops and moves group ins/outs and weights at least once
+  int64_t getGroupBound(const LgInfo &lg_info);
+
+  static int64_t getFLOPs(Operation *op);
+  static int64_t getTiuCycle(Operation *op, double ratio = 1.0);
+  static int64_t getDmaCycle(int64_t bytes);
+};
 } // namespace tpu
 } // namespace tpu_mlir
@@ -0,0 +1,70 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// TPU-MLIR is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "tpu_mlir/Dialect/Tpu/IR/TpuOps.h"
+#include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/LayerGroupDefs.h"
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace tpu_mlir {
+namespace tpu {
+
+typedef enum {
+  GROUP_COST_VALID = 0, // GroupMethod::is_layer_group_valid
+  GROUP_COST_CYCLE = 1, // GroupMethod::get_group_cycle
+} group_cost_kind_t;
+
+typedef struct group_cost_info {
+  bool valid;
+  bool has_cost;
+  int64_t cost;
+  group_cost_info() : valid(false), has_cost(false), cost(0) {}
+} group_cost_info_t;
+
+typedef std::vector<uintptr_t> group_cost_key_t;
+
+/// Memoize cost of layer groups during layer group searching.
+/// The key is the structure of the group: op kinds, attributes, value types,
+/// connections inside the group, which results leave the group and the group
+/// type. So identical sub-groups, such as repeated blocks of transformer,
+/// share one evaluation. Types and attributes are uniqued by MLIRContext, the
+/// cache must be cleared when the context changes. It is thread safe, groups
+/// may be evaluated in parallel.
+class GroupCostCache {
+public:
+  static GroupCostCache &getInstance() {
+    static GroupCostCache instance;
+    return instance;
+  }
+
+  static void get_key(group_cost_key_t &key, const LgInfo &lg_info,
+                      group_cost_kind_t kind, RunMode run_mode);
+
+  bool find(const group_cost_key_t &key, group_cost_info_t &info);
+  void insert(const group_cost_key_t &key, const group_cost_info_t &info);
+  void clear();
+  void show_statistics();
+
+private:
+  GroupCostCache() : hit_num_(0), miss_num_(0) {}
+
+  struct KeyHash {
+    size_t operator()(const group_cost_key_t &key) const;
+  };
+  std::mutex mutex_;
+  std::unordered_map<group_cost_key_t, group_cost_info_t, KeyHash> cache_;
+  int64_t hit_num_;
+  int64_t miss_num_;
+};
+
+} // namespace tpu
+} // namespace tpu_mlir
@@ -0,0 +1,57 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// TPU-MLIR is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "tpu_mlir/Dialect/Tpu/IR/TpuOps.h"
+#include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/LayerGroupDefs.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace tpu_mlir {
+namespace tpu {
+
+/// Save cut results of base groups to a file, so that later compiles of the
+/// same subgraph reuse them instead of searching again. Unlike
+/// GroupCostCache, the key must be stable between processes, so it is a MD5
+/// of the printed structure of the base group: op names, attributes, value
+/// types, connections, which results leave the base group, and the options
+/// and chip the search depends on.
+class GroupDecisionCache {
+public:
+  static GroupDecisionCache &getInstance() {
+    static GroupDecisionCache instance;
+    return instance;
+  }
+
+  static std::string get_key(const std::vector<Operation *> &base_group,
+                             RunMode run_mode);
+
+  // disabled if file is empty, a missing file is an empty cache
+  void load(const std::string &file);
+  void save();
+  void clear();
+  bool enabled() const { return !file_.empty(); }
+
+  bool find(const std::string &key, std::vector<int64_t> &cut_result);
+  void insert(const std::string &key, const std::vector<int64_t> &cut_result);
+
+private:
+  GroupDecisionCache() : dirty_(false), hit_num_(0), miss_num_(0) {}
+
+  std::string file_;
+  std::map<std::string, std::vector<int64_t>> cache_;
+  bool dirty_;
+  int64_t hit_num_;
+  int64_t miss_num_;
+};
+
+} // namespace tpu
+} // namespace tpu_mlir
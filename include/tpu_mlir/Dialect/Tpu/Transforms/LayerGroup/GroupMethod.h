@@ -50,8 +50,10 @@ public:
   void get_group_clusters(std::vector<std::pair<int64_t, int64_t>> &clusters,
                           const std::vector<Operation *> &base_group);
 
+  // memoized by GroupCostCache
   bool is_layer_group_valid(LgInfo &lg_info, bool calc_cost,
                             int64_t *group_cost);
+  bool check_layer_group(LgInfo &lg_info, bool calc_cost, int64_t *group_cost);
   bool group_one_layer_proc(const LgInfo &lg_info, bool calc_cost,
                             int64_t *group_cost);
 
@@ -62,9 +64,20 @@ public:
 
   int64_t cost_add(int64_t cost0, int64_t cost1);
 
+  // roofline estimation of lg_info is not better than other_cost
+  bool is_roofline_worse(const LgInfo &lg_info, int64_t other_cost);
+  // skip exact cost only under CostModel::ROOFLINE
+  bool roofline_prune(bool roofline_worse);
+  void record_roofline(bool roofline_worse, bool exact_worse);
+  void show_roofline_statistics();
+
   void sweep_for_min_cost(int64_t *group_cost, int64_t *optimal_point,
                           int64_t start, int64_t end,
                           const std::vector<std::vector<int64_t>> &cost_table);
+  bool is_valid_cut_result(const std::vector<int64_t> &cut_result,
+                           int64_t layer_num);
+  // cut results of base group reused from GroupDecisionCache
+  bool is_cut_cached(size_t base_group_idx);
   void
   get_layer_cut_result(std::vector<int64_t> &cut_result,
                        const std::vector<std::pair<int64_t, int64_t>> &clusters,
@@ -89,7 +102,9 @@ public:
   std::vector<int> get_sec_per_cores(const shape_secs_t& shape_secs,
                                                   std::vector<std::vector<int64_t>>& vec_ncdhw,
                                                   int core_num, TensorInfo& tensor_infos);
+  // memoized by GroupCostCache
   int64_t get_group_cycle(LgInfo *sub_group);
+  int64_t calc_group_cycle(LgInfo *sub_group);
   Operation* cut_this_group_is_better(LgInfo *sub_group);
   void try_cut_some_group(LgPassIR *pass_ir, std::vector<std::vector<Operation *>> &base_groups);
   void l2m_process(LgPassIR *pass_ir, int grp_idx, std::vector<std::pair<Value, int64_t>>& value_size);
@@ -103,7 +118,12 @@ protected:
   BasicTimeStepPtr time_step_;
   std::shared_ptr<LmemAllocator> lmem_allocator_;
   std::shared_ptr<CycleCalculator> cycle_calculator_;
+  std::shared_ptr<RooflineCycleCalculator> roofline_calculator_;
+  int64_t roofline_check_num_;
+  int64_t roofline_agree_num_;
+  int64_t roofline_prune_num_;
   std::vector<std::vector<int64_t>> cut_results_;
+  std::vector<bool> cut_cached_;
   int64_t group_cost_;
   int64_t MAX_COST;
   int64_t opt_;
@@ -49,6 +49,25 @@ typedef struct mem_struct {
 //  std::string mnemonic_name;
 } mem_struct;
 
+// key of a lmem allocation, the tensor of one slice or the buffer of the op
+// defining it
+typedef struct lmem_key {
+  Value value;
+  int slice_idx;
+  bool is_buffer;
+  lmem_key(Value value = Value(), int slice_idx = 0, bool is_buffer = false)
+      : value(value), slice_idx(slice_idx), is_buffer(is_buffer) {}
+  bool operator<(const lmem_key &other) const {
+    if (value.getImpl() != other.value.getImpl()) {
+      return value.getImpl() < other.value.getImpl();
+    }
+    if (slice_idx != other.slice_idx) {
+      return slice_idx < other.slice_idx;
+    }
+    return is_buffer < other.is_buffer;
+  }
+} lmem_key_t;
+
 typedef struct ilp_var_info {
  int ts_idx;
  int slice_idx;
@@ -89,7 +108,7 @@ typedef struct ts_move_info {
 typedef struct mem_alloc_req_info {
   int slice_idx;
   int size;
-  std::string name;
+  lmem_key_t key;
   Value value;
   mem_alloc_req_info()
       : slice_idx(0), size(0) {}
@@ -109,18 +128,18 @@ typedef struct constraint_info {
 class ILPTimeStep;
 class lmem_alloc {
 public:
-  lmem_alloc(std::map<std::string, std::vector<std::string>>& banked_tensors, ILPTimeStep* pILPTimeStep, int ts_count);
+  lmem_alloc(std::map<Value, std::vector<Value>, value_compare>& banked_tensors, ILPTimeStep* pILPTimeStep, int ts_count);
   virtual ~lmem_alloc();
 
-  std::shared_ptr<std::vector<std::pair<std::string, mem_struct>>> show_mem(int& total_free_size, int& max_free_mem_idx, int& max_free_mem_size);
-  bool alloc(int ts_idx, int slice_idx, const std::string& name, Value value, int size);
-  bool alloc2(int ts_idx, int slice_idx, const std::string& name, Value value, int addr, int size);
-  bool free(const std::string& name, std::vector<std::pair<int,int>>* vec_pre_ts_free_mem = nullptr);
-  bool get_mem_struct(const std::string& key, mem_struct& mem_s);
+  std::shared_ptr<std::vector<std::pair<lmem_key_t, mem_struct>>> show_mem(int& total_free_size, int& max_free_mem_idx, int& max_free_mem_size);
+  bool alloc(int ts_idx, const lmem_key_t& key, Value value, int size);
+  bool alloc2(int ts_idx, const lmem_key_t& key, Value value, int addr, int size);
+  bool free(const lmem_key_t& key, std::vector<std::pair<int,int>>* vec_pre_ts_free_mem = nullptr);
+  bool get_mem_struct(const lmem_key_t& key, mem_struct& mem_s);
 
 // private:
-  std::vector<int> get_bank(const std::string& name);
-  bool _alloc(int slice_idx, const std::string& name, Value value, int size, std::vector<int>& ret_bank_id,
+  std::vector<int> get_bank(const lmem_key_t& key);
+  bool _alloc(const lmem_key_t& key, Value value, int size, std::vector<int>& ret_bank_id,
                         int& free_addr, int& confict_size, bool force_not_care_bank = false);
   bool alloc_multi(int ts_idx, std::vector<mem_alloc_req_info>& vec_mem_req, bool sort_by_size);
 
@@ -129,11 +148,11 @@ public:
   int m_ts_count;
   // int bank_size;
   bool* lmem_buf;
-  std::map<std::string, mem_struct> mem_dict;
-  std::map<std::string, his_mem_struct> vec_mem_alloc_his;
+  std::map<lmem_key_t, mem_struct> mem_dict;
+  std::map<lmem_key_t, his_mem_struct> vec_mem_alloc_his;
   int bank_num[16];
   int bank_area_start_addr[17];
-  std::map<std::string, std::vector<std::string>>& banked_tensors_;
+  std::map<Value, std::vector<Value>, value_compare>& banked_tensors_;
   ILPTimeStep* m_pILPTimeStep;
   bool rehearsal = false;
 };
@@ -176,12 +195,15 @@ public:
   // static ILPTimeStep& combine_mult_ilp_timestep(
   //   const std::vector<ILPTimeStep&> other_ilp_timesteps) {};
 
-  void addBinaryVar(int ts_idx, int slice_idx, int mode, std::string varName, Value value, tensor_info_t& info, int64_t lmem_bytes);
-  void addTimestepGdmaCycle(int ts_idx, int cycle, std::string varName);
-  void addTimestepMemUse(int ts_idx, int mem_size, std::vector<std::string>& varNames);
-  void addNewOutIntoReturnOp(std::vector<std::string> var_names, Value value);
-  void addRowConstraint(int ts_idx, Value load_tensor, std::vector<std::string> var_names);
-  void setVarExpectValue(std::string var_name, int expect_value);
+  // returns the var id, varName is only given to solver for detail log
+  int addBinaryVar(int ts_idx, int slice_idx, int mode, const std::string& varName, Value value, tensor_info_t& info, int64_t lmem_bytes);
+  int addVarInfo(const ilp_var_info& var_info);
+  void addTimestepGdmaCycle(int ts_idx, int cycle, int var_id);
+  void addTimestepMemUse(int ts_idx, int mem_size, const std::vector<int>& var_ids);
+  void addNewOutIntoReturnOp(std::vector<int> var_ids, Value value);
+  void addRowConstraint(int ts_idx, Value load_tensor, const std::vector<int>& var_ids);
+  void setVarExpectValue(int var_id, int expect_value);
+  void addVarHint(int var_id, double hint_value);
   bool run();
   bool mem_alloc(mem_alloc_status& alloc_status, std::vector<std::pair<Value, int64_t>>& value_size,
                 TensorInfo& tensor_infos);
@@ -195,8 +217,8 @@ public:
   void addTensorSize(int ts_idx, Value value, int lmem_size);
   void addTensorCycle(int ts_idx, Value value, int cycle);
   void addOpInfo(int ts_idx, Operation* op, int buffer_size, int mem_size_for_load, int bdc_cycle);
-  void addValueInfo(int slice_idx, Value value, std::string varName);
-  MPVariable* getMPVarByName(std::string varName);
+  void addValueInfo(int slice_idx, Value value, int var_id);
+  MPVariable* getMPVar(int var_id);
   void addSliceNcdhwSteps(int core_id, std::vector<int64_t> ncdhw);
   void resideOpInValue(Operation* op, Value value);
   void showTimeStepInfo(int debug_cmd = 0);
@@ -210,21 +232,23 @@ public:
   std::vector<TimestepRow2> timestep_table_;
   std::vector<TimestepRow2> timestep_table_new;
   std::map<int64_t, ts_move_info> inserted_timestep_table_;
-  std::map<std::string, ilp_var_info> mapILPVarInfo;
-  std::vector<std::vector<std::pair<int, std::string>>> cycle_contrains;
-  std::vector<std::vector<std::pair<int, std::string>>> mem_contrains;
-  std::vector<std::vector<std::pair<int, std::string>>> cycle_contrains_new;
-  std::vector<std::vector<std::pair<int, std::string>>> mem_contrains_new;
+  std::vector<ilp_var_info> mapILPVarInfo; //indexed by var id
+  std::vector<std::vector<std::pair<int, int>>> cycle_contrains; //<cycle, var id>
+  std::vector<std::vector<std::pair<int, int>>> mem_contrains; //<mem size, var id>
+  std::vector<std::vector<std::pair<int, int>>> cycle_contrains_new;
+  std::vector<std::vector<std::pair<int, int>>> mem_contrains_new;
   MPObjective* objective;
   lmem_alloc_Ptr lmem_alloc_ptr;
   std::vector<l2m_value_info> vec_l2m_value_info; //Value + ts_idx > 加载ts号
-  std::map<Value, std::map<int, std::vector<std::string>>, value_compare> mapValueInfo;
+  std::map<Value, std::map<int, std::vector<int>>, value_compare> mapValueInfo;
   std::vector<constraint_info> vec_constraints;
+  // initial solution for solver, such as the loads and stores of BasicTimeStep
+  std::vector<std::pair<int, double>> var_hints; //<var id, hint value>
 
   std::vector<int64_t> core_ids;
   std::map<int, std::vector<std::vector<int64_t>>> ncdhw_steps;
   std::map<Operation*, std::vector<Value>> reside_in_tensor; //分叉的输出因为远处的user靠得太近，不必要store/load，故直接驻留
-  std::map<Value, std::vector<std::string>, value_compare> values_need_store_to_grpout;
+  std::map<Value, std::vector<int>, value_compare> values_need_store_to_grpout;
   std::map<Value, reside_value_info, value_compare> map_reside_value_info;
 // private:
   int ts_count;
@@ -161,7 +161,7 @@ typedef struct {
 } TimestepRow;
 
 typedef struct ts_var_t {
-  std::string varName;
+  int var_id;
   int var_value;
   int slice_idx;
 
@@ -169,7 +169,7 @@ typedef struct ts_var_t {
   int lmem_bytes;
   tensor_info_t info;
   ts_var_t()
-      : var_value(0), lmem_bytes(0), slice_idx(-1) {}
+      : var_id(-1), var_value(0), lmem_bytes(0), slice_idx(-1) {}
 } ts_var_t;
 
 struct op_related_info_t {
@@ -178,7 +178,7 @@ struct op_related_info_t {
   int buffer_size;
   int bdc_cycle;
   int mem_size_for_load;
-  std::map<Value, std::vector<std::string>, value_compare> need_load_var;
+  std::map<Value, std::vector<int>, value_compare> need_load_var;
   std::map<Value, int, value_compare> tensor_size;
   std::map<Value, int, value_compare> load_tensor_cycles;
   std::vector<ts_var_t>  ada_var_for_free_mem; //在本op执行后可以释放的自动驻留输入tensor
@@ -227,12 +227,14 @@ struct LgInfo {
     this->group_ops.clear();
     this->group_ins.clear();
     this->group_outs.clear();
+    this->group_op_outs.clear();
     this->type = GROUP_NORMAL;
   }
 
   void update_group_io(int opt = 2) {
     this->group_ins.clear();
     this->group_outs.clear();
+    this->group_op_outs.clear();
 
     for (auto op : group_ops) {
       // update group_ins
@@ -281,8 +283,8 @@ struct LgInfo {
       if (op->getNumOperands() > 1) {
         auto pre_op = op->getOperand(1).getDefiningOp();
         if ((pre_op == nullptr || !isa<top::NoneOp>(pre_op))) {
-          auto opd0 = module::getName(op->getOperand(0)).str();
-          auto opd1 = module::getName(op->getOperand(1)).str();
+          auto opd0 = op->getOperand(0);
+          auto opd1 = op->getOperand(1);
           group_banked_tensors[opd0].push_back(opd1);
           group_banked_tensors[opd1].push_back(opd0);
         }
@@ -291,20 +293,20 @@ struct LgInfo {
       for (int i = 0; i < op->getNumOperands(); i++) {
         auto pre_op = op->getOperand(i).getDefiningOp();
         if (pre_op == nullptr || !isa<top::NoneOp>(pre_op)) {
-          auto opd = module::getName(op->getOperand(i)).str();
+          auto opd = op->getOperand(i);
           for (int j = 0; j < op->getNumResults(); j++) {
-            auto res = module::getName(op->getResult(j)).str();
+            auto res = op->getResult(j);
             group_banked_tensors[opd].push_back(res);
           }
         }
       }
 
       for (int i = 0; i < op->getNumResults(); i++) {
-        auto res = module::getName(op->getResult(i)).str();
+        auto res = op->getResult(i);
         for (int j = 0; j < op->getNumOperands(); j++) {
           auto pre_op = op->getOperand(j).getDefiningOp();
           if (pre_op == nullptr || !isa<top::NoneOp>(pre_op)) {
-            auto opd = module::getName(op->getOperand(j)).str();
+            auto opd = op->getOperand(j);
             group_banked_tensors[res].push_back(opd);
           }
         }
@@ -345,7 +347,7 @@ struct LgInfo {
   int group_id = 0;
 
   std::vector<int> free_cores;
-  std::map<std::string, std::vector<std::string>> group_banked_tensors;
+  std::map<Value, std::vector<Value>, value_compare> group_banked_tensors;
 };
 
 } // namespace tpu
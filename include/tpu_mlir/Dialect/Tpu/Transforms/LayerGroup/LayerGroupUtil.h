@@ -24,6 +24,26 @@ namespace tpu {
 class ILPTimeStep;
 class dot_graph;
 typedef std::pair<int64_t, int64_t> slice_pair_t; // idx and slice
+
+// stream of the layer group search logs, llvm::errs() unless the calling
+// thread collects them into a LgLogBuffer
+llvm::raw_ostream &lg_errs();
+
+// While alive, the logs of the calling thread go into this buffer, so the
+// logs of groups searched in parallel can be emitted in group order.
+class LgLogBuffer {
+public:
+  LgLogBuffer();
+  ~LgLogBuffer();
+  // returns the logs collected so far and clears them
+  std::string take();
+
+private:
+  std::string buffer_;
+  llvm::raw_string_ostream os_;
+  llvm::raw_ostream *prev_;
+};
+
 shape_secs_t get_group_max_secs(const LgInfo &lg_info, std::vector<std::pair<Operation*, int>>& vec_op_hsecs);
 bool init_group_data_secs(const LgInfo &lg_info, shape_secs_t &shape_secs,
                           std::vector<std::pair<Value, int64_t>>& value_size);
@@ -22,11 +22,21 @@ enum class NnvlcMode {
     ALL = 3
 };
 
+// EXACT: simulate backend commands for all group costs.
+// ROOFLINE: skip groups whose roofline estimation can not beat the known
+// alternative, only simulate the rest.
+enum class CostModel {
+    EXACT = 0,
+    ROOFLINE = 1
+};
+
 typedef struct {
   bool dyn_compile;
   int64_t opt;
   bool group_by_cores;
   NnvlcMode nnvlc_mode;
+  CostModel cost_model;
+  int64_t ilp_time_limit; // seconds for each ILP solve, 0 means no limit
 } LgOptions;
 
 struct LgPassIR {
@@ -31,9 +31,12 @@ typedef struct membuf_sort_standard {
 
 using MemBufSortStd = std::pair<mem_buffer_key_t, membuf_sort_std_t>;
 
+// bit i is set if lmem bank i is used, banks are no more than 64
+typedef uint64_t bank_mask_t;
+
 typedef struct {
   std::list<MemBlock> avail_lmems;
-  std::set<int64_t> exclude_banks;
+  bank_mask_t exclude_banks;
 } avail_space_t;
 using BufferAvailSpace = std::map<mem_buffer_key_t, avail_space_t>;
 
@@ -46,10 +49,10 @@ public:
   bool assignLmemAddr(const LgInfo &lg_info, BasicTimeStepPtr &time_step,
                       const shape_secs_t &shape_secs);
 
-  void find_used_banks(std::set<int64_t> &used_banks, int64_t local_addr,
+  void find_used_banks(bank_mask_t &used_banks, int64_t local_addr,
                        int64_t local_size);
 
-  void update_exclude_banks(std::set<int64_t> &exclude_banks,
+  void update_exclude_banks(bank_mask_t &exclude_banks,
                             const mem_buffer_key_t &buffer_key,
                             const mem_buffer_value_t &buffer_value,
                             const mem_buffer_key_t &recent_buffer_allocated,
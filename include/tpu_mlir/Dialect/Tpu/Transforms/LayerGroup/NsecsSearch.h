@@ -0,0 +1,66 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// TPU-MLIR is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace tpu_mlir {
+namespace tpu {
+
+/// Find the smallest nsecs below max_nsecs whose lmem secs needed,
+/// get_secs(nsecs), is not more than nsecs, or max_nsecs if there is none.
+/// This is the nsecs found by trying nsecs = 1, 2, ... in turn, but as the
+/// secs needed never increase with nsecs it is found by bisection.
+///
+/// On entry secs is get_secs(1), the last call made by the caller. On return
+/// secs is get_secs(nsecs) and that is the last call, so state the caller
+/// keeps for the last call belongs to the returned nsecs. get_secs fails by
+/// returning a value <= 0, and a failing nsecs is taken to fail for every
+/// larger nsecs too. Returns -1 if the one by one search would meet a failing
+/// nsecs before its result.
+template <typename GetSecsFn>
+int64_t search_min_nsecs(int64_t max_nsecs, int64_t &secs,
+                         GetSecsFn &&get_secs) {
+  if (secs <= 1 || max_nsecs <= 1) {
+    return 1;
+  }
+  int64_t lo = 2;
+  int64_t hi = std::min(secs, max_nsecs - 1);
+  int64_t best = max_nsecs;
+  int64_t fail = max_nsecs + 1;
+  int64_t probe = 1;
+  while (lo <= hi) {
+    probe = lo + (hi - lo) / 2;
+    secs = get_secs(probe);
+    if (secs <= 0) {
+      fail = probe;
+      hi = probe - 1;
+    } else if (secs <= probe) {
+      best = probe;
+      hi = probe - 1;
+    } else {
+      lo = probe + 1;
+    }
+  }
+  if (best >= fail) {
+    return -1;
+  }
+  if (probe != best) {
+    secs = get_secs(best);
+    if (secs <= 0) {
+      return -1;
+    }
+  }
+  return best;
+}
+
+} // namespace tpu
+} // namespace tpu_mlir
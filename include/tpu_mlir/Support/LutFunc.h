@@ -50,6 +50,14 @@ Value create_lookup_table(Operation *owner, const std::vector<int> &table);
 
 Value create_lookup_table_fp(Value in, Value out, activate_f &&func);
 
+// apply 256-entry table, input holds int8/uint8 value stored in float
+void lut_int8(const float *input, float *output, int64_t size,
+              const float *table);
+
+// apply per-channel 256-entry tables, table is [channel, 256]
+void lut_int8_per_channel(const float *input, float *output, int64_t outer,
+                          int64_t channel, int64_t inner, const float *table);
+
 void bf16_gen_base_slope_table(float *base_table, float *slope_table,
                                float range_start, float range_end,
                                activate_f &&func);
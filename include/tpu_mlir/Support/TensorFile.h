@@ -19,9 +19,12 @@
 #include "mlir/IR/OpDefinition.h"
 #include "mlir/Support/LogicalResult.h"
 #include "llvm/ADT/Twine.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
 
 #include <atomic>
 #include <ctime>
@@ -30,6 +33,7 @@
 #include <string>
 #include <system_error>
 #include <type_traits>
+#include <unordered_map>
 
 #include <iomanip>
 
@@ -100,9 +104,27 @@ private:
   /// load the file
   LogicalResult load(void);
 
+  /// check if the name is used, either in memory or in the mapped file
+  bool exist(llvm::StringRef name);
+
+  /// get the in-memory array of a tensor, pulling it out of the mapped file
+  /// on first touch; keep_data = false skips copying data to be overwritten
+  /// return nullptr if the name is not found
+  cnpy::NpyArray *getArray(llvm::StringRef name, bool keep_data = true);
+
+  /// let arr share the data of an identical tensor already in memory,
+  /// otherwise record its data for later tensors
+  void shareBlob(cnpy::NpyArray &arr);
+
   std::string filename;
   bool readOnly;
+  /// tensors held in memory, new or modified ones
   cnpy::npz_t map;
+  /// stored npz is mapped and indexed, untouched tensors are read in place
+  std::unique_ptr<llvm::MemoryBuffer> mapped;
+  cnpy::npz_index_t lazy;
+  /// content hash to tensor data in memory, shared copy-on-write
+  std::unordered_multimap<uint64_t, std::weak_ptr<std::vector<char>>> blobs;
   std::atomic<int> cnt_del = {0};
   std::atomic<int> cnt_add = {0};
   std::atomic<int> cnt_update = {0};
@@ -21,6 +21,8 @@ int64_t Arch::EU_BYTES = 0;
 int64_t Arch::LMEM_BYTES = 0;
 int64_t Arch::LMEM_BANKS = 0;
 int64_t Arch::LMEM_BANK_BYTES = 0;
+int64_t Arch::TIU_MACS = 4096;
+int64_t Arch::GDMA_BYTES = 32;
 bool Arch::ALIGN_4N = false;
 llvm::StringRef Arch::LIB_BACKEND_NAME = "";
 module::Chip Arch::chip;
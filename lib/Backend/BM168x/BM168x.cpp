@@ -632,6 +632,7 @@ void BM168x::after_codegen(int64_t flops) {
 }
 
 void BM168x::set_command_issue_flag(bool value) {
+  std::lock_guard<std::recursive_mutex> lock(global_mutex());
   really_issue_command = value;
   if (really_issue_command) {
     dl_allow_store_cmd();
@@ -659,3 +660,8 @@ int64_t BM168x::get_bdc_cycle() { return dl_get_cmd_id_cycle(code->bdc_node); }
 int64_t BM168x::get_cmd_cycle() {
   return dl_get_cmd_id_cycle(code->cmdid_node);
 }
+
+std::recursive_mutex &BM168x::global_mutex() {
+  static std::recursive_mutex mutex;
+  return mutex;
+}
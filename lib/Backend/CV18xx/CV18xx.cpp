@@ -674,6 +674,9 @@ CV18xx::CV18xx(module::Chip chip) {
   LMEM_BYTES = cvk_ctx_->info.lmem_size;
   LMEM_BANKS = cvk_ctx_->info.lmem_banks;
   LMEM_BANK_BYTES = LMEM_BYTES / LMEM_BANKS;
+  // peak estimation, only for roofline cycle model
+  TIU_MACS = NPU_NUM * EU_BYTES;
+  GDMA_BYTES = 16;
 }
 
 CV18xx::~CV18xx() {
@@ -8,7 +8,13 @@
 //===----------------------------------------------------------------------===//
 
 #include "tpu_mlir/Builder/BM168x/bmodel.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
 #include <iostream>
+#include <sys/mman.h>
+#include <unistd.h>
 
 using bmodel::Binary;
 using bmodel::Model;
@@ -41,30 +47,131 @@ const uint32_t BMODEL_MAGIC = 0xFF55AAEE;
     }                                                                          \
   } while (0)
 
-ModelGen::ModelGen(uint32_t reserved_size) {
-  binary_.reserve(reserved_size);
+ModelGen::ModelGen(uint32_t reserved_size, bool file_backed,
+                   const string &binary_dir) {
+  binary_file_ = NULL;
+  binary_size_ = 0;
+  if (file_backed) {
+    // tmpfile() always uses /tmp, often tmpfs, so create the file by name in
+    // binary_dir and unlink it at once, it is removed when closed
+    string dir = binary_dir;
+    if (dir.empty()) {
+      const char *tmp_dir = getenv("TMPDIR");
+      dir = (tmp_dir != NULL && tmp_dir[0] != '\0') ? tmp_dir : "/tmp";
+    }
+    string path = dir + "/bmodel_binary_XXXXXX";
+    int fd = mkstemp(&path[0]);
+    if (fd < 0) {
+      BMODEL_LOG(FATAL) << "can't create binary temp file in " << dir
+                        << std::endl;
+      exit(-1);
+    }
+    unlink(path.c_str());
+    binary_file_ = fdopen(fd, "w+b");
+    ASSERT(binary_file_ != NULL);
+  } else {
+    binary_.reserve(reserved_size);
+  }
   max_neuron_size_ = 0;
   num_device_ = 0;
 }
 
 FlatBufferBuilder &ModelGen::Builder() { return builder_; }
 
-ModelGen::~ModelGen() { builder_.Release(); }
+ModelGen::~ModelGen() {
+  builder_.Release();
+  if (binary_file_ != NULL) {
+    fclose(binary_file_);
+  }
+}
+
+static const uint64_t BINARY_CHUNK = 64 << 20;
+
+void ModelGen::ReadBinary(uint64_t start, uint8_t *buffer, uint64_t size) {
+  if (binary_file_ == NULL) {
+    memcpy(buffer, binary_.data() + start, size);
+    return;
+  }
+  ASSERT(fseeko(binary_file_, start, SEEK_SET) == 0);
+  ASSERT(fread(buffer, 1, size, binary_file_) == size);
+}
+
+bool ModelGen::IsBinarySame(const Binary &binary, const uint8_t *data) {
+  if (binary_file_ == NULL) {
+    return memcmp(data, binary_.data() + binary.start(), binary.size()) == 0;
+  }
+  std::vector<uint8_t> buffer(std::min<uint64_t>(binary.size(), BINARY_CHUNK));
+  for (uint64_t offset = 0; offset < binary.size(); offset += buffer.size()) {
+    uint64_t size = std::min<uint64_t>(binary.size() - offset, buffer.size());
+    ReadBinary(binary.start() + offset, buffer.data(), size);
+    if (memcmp(data + offset, buffer.data(), size) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ModelGen::SaveBinary(std::ostream &out) {
+  if (binary_file_ == NULL) {
+    out.write((char *)binary_.data(), binary_.size());
+    return;
+  }
+  std::vector<uint8_t> buffer(std::min<uint64_t>(binary_size_, BINARY_CHUNK));
+  for (uint64_t offset = 0; offset < binary_size_; offset += buffer.size()) {
+    uint64_t size = std::min<uint64_t>(binary_size_ - offset, buffer.size());
+    ReadBinary(offset, buffer.data(), size);
+    out.write((char *)buffer.data(), size);
+  }
+}
+
+// 64-bit content hash for binary dedup, mixes 8 bytes per step
+uint64_t ModelGen::HashBinary(const uint8_t *data, size_t size) {
+  const uint64_t m = 0x9E3779B97F4A7C15ull;
+  uint64_t h = size * m;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t k;
+    memcpy(&k, data + i, 8);
+    k *= 0xBF58476D1CE4E5B9ull;
+    k ^= k >> 31;
+    h = (h ^ k) * m;
+  }
+  if (i < size) {
+    uint64_t k = 0;
+    memcpy(&k, data + i, size - i);
+    h = (h ^ k) * m;
+  }
+  h ^= h >> 29;
+  h *= 0x94D049BB133111EBull;
+  h ^= h >> 32;
+  return h;
+}
 
 Binary ModelGen::WriteBinary(size_t size, uint8_t *data) {
   // ASSERT(size != 0 && data != NULL);
-  for (auto &binary : binary_vector_) {
-    if (binary.size() != size) {
-      continue;
-    }
-    if (memcmp(data, binary_.data() + binary.start(), size) == 0) {
+  return WriteBinary(size, data, HashBinary(data, size));
+}
+
+Binary ModelGen::WriteBinary(size_t size, uint8_t *data, uint64_t key) {
+  // the hash covers size and content, only a hit is verified by memcmp
+  auto range = binary_index_.equal_range(key);
+  for (auto it = range.first; it != range.second; ++it) {
+    auto &binary = binary_vector_[it->second];
+    if (binary.size() == size && IsBinarySame(binary, data)) {
       return binary;
     }
   }
-  uint64_t start = binary_.size();
-  binary_.insert(binary_.end(), size, 0);
-  memcpy(binary_.data() + start, data, size);
+  uint64_t start = binary_size_;
+  if (binary_file_ != NULL) {
+    ASSERT(fseeko(binary_file_, start, SEEK_SET) == 0);
+    ASSERT(fwrite(data, 1, size, binary_file_) == size);
+  } else {
+    binary_.insert(binary_.end(), size, 0);
+    memcpy(binary_.data() + start, data, size);
+  }
+  binary_size_ += size;
   Binary new_bin(start, size);
+  binary_index_.emplace(key, binary_vector_.size());
   binary_vector_.push_back(new_bin);
   return new_bin;
 }
@@ -337,7 +444,7 @@ size_t ModelGen::Finish() {
   builder_.Finish(model);
 
   // return size
-  size_t size = sizeof(MODEL_HEADER_T) + builder_.GetSize() + binary_.size();
+  size_t size = sizeof(MODEL_HEADER_T) + builder_.GetSize() + binary_size_;
   return size;
 }
 
@@ -356,10 +463,10 @@ void ModelGen::Save(const string &filename) {
   header.magic = BMODEL_MAGIC;
   header.header_size = sizeof(header);
   header.flatbuffers_size = builder_.GetSize();
-  header.binary_size = binary_.size();
+  header.binary_size = binary_size_;
   fout.write((char *)&header, sizeof(header));
   fout.write((char *)builder_.GetBufferPointer(), builder_.GetSize());
-  fout.write((char *)binary_.data(), binary_.size());
+  SaveBinary(fout);
   fout.close();
 }
 
@@ -370,17 +477,22 @@ void ModelGen::Save(void *buffer) {
   p_header->magic = BMODEL_MAGIC;
   p_header->header_size = sizeof(MODEL_HEADER_T);
   p_header->flatbuffers_size = builder_.GetSize();
-  p_header->binary_size = binary_.size();
+  p_header->binary_size = binary_size_;
   uint8_t *p_flb = (uint8_t *)buffer + p_header->header_size;
   memcpy(p_flb, builder_.GetBufferPointer(), p_header->flatbuffers_size);
   uint8_t *p_binary = p_flb + p_header->flatbuffers_size;
-  memcpy(p_binary, binary_.data(), p_header->binary_size);
+  ReadBinary(0, p_binary, binary_size_);
 }
 
-ModelCtx::ModelCtx(const string &filename)
-    : model_gen_(NULL), model_(NULL), bmodel_pointer_(NULL) {
+ModelCtx::ModelCtx(const string &filename, bool writable)
+    : model_gen_(NULL), model_(NULL), bmodel_pointer_(NULL), mmap_addr_(NULL),
+      mmap_size_(0), writable_(writable) {
   // read file
-  file_.open(filename, std::ios::binary | std::ios::in | std::ios::out);
+  auto mode = std::ios::binary | std::ios::in;
+  if (writable) {
+    mode |= std::ios::out;
+  }
+  file_.open(filename, mode);
   if (!file_) {
     BMODEL_LOG(FATAL) << "File[" << filename << "] open failed." << std::endl;
     exit(-1);
@@ -427,11 +539,29 @@ ModelCtx::ModelCtx(const string &filename)
   model_ = bmodel::GetModel(model_buffer_);
   ASSERT(model_ != NULL);
   update_bmodel();
+
+  // map the whole file, so binaries are read (and written back if writable)
+  // in place without seek/read round trips; fall back to the stream if
+  // mapping fails
+  int fd = ::open(filename.c_str(), writable ? O_RDWR : O_RDONLY);
+  if (fd >= 0) {
+    void *addr = writable ? mmap(NULL, length, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED, fd, 0)
+                          : mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr != MAP_FAILED) {
+      mmap_addr_ = addr;
+      mmap_size_ = length;
+      bmodel_pointer_ = addr;
+      file_.close();
+    }
+  }
 }
 
 ModelCtx::ModelCtx(const void *bmodel_data, size_t size)
     : model_gen_(NULL), model_(NULL), model_buffer_(NULL),
-      bmodel_pointer_(NULL) {
+      bmodel_pointer_(NULL), mmap_addr_(NULL), mmap_size_(0),
+      writable_(true) {
   ASSERT(bmodel_data != NULL);
   if (size <= sizeof(header_)) {
     BMODEL_LOG(FATAL) << "Bmodel data is broken ." << std::endl;
@@ -485,10 +615,21 @@ ModelCtx::~ModelCtx() {
   if (model_buffer_ != NULL) {
     free(model_buffer_);
   }
+  if (mmap_addr_ != NULL) {
+    munmap(mmap_addr_, mmap_size_);
+  }
 }
 
 const void *ModelCtx::data() const { return model_buffer_; }
 
+const uint8_t *ModelCtx::binary_data(const Binary *binary) const {
+  ASSERT(binary != NULL);
+  if (bmodel_pointer_ == NULL) { // from file
+    return NULL;
+  }
+  return (const uint8_t *)bmodel_pointer_ + binary_offset_ + binary->start();
+}
+
 const bmodel::MODEL_HEADER_T &ModelCtx::header() const { return header_; }
 
 void ModelCtx::read_binary(const Binary *binary, uint8_t *buffer) {
@@ -517,6 +658,7 @@ void ModelCtx::write_binary(const Binary *binary, uint8_t *buffer) {
 // write buffer to binary offset
 void ModelCtx::write_binary(const Binary *binary, uint64_t offset,
                             uint8_t *buffer, uint64_t size) {
+  ASSERT(writable_);
   ASSERT(binary != NULL);
   ASSERT(buffer != NULL);
   ASSERT(size + offset <= binary->size());
@@ -7,6 +7,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "tpu_mlir/Support/LutFunc.h"
 #include "tpu_mlir/Support/MathUtils.h"
 
 int64_t top::LutOp::getFLOPs() {
@@ -18,15 +19,7 @@ void top::LutOp::deinit(InferenceParameter &p) {}
 
 LogicalResult top::LutOp::inference(InferenceParameter &p) {
   auto num_element = module::getNumElements(getInput());
-#pragma omp parallel for schedule(static, omp_schedule(num_element))
-  for (int i = 0; i < num_element; ++i) {
-    int offset = p.inputs[0][i];
-    if (offset < 0) {
-      offset += 256;
-    }
-    ASSERT_THIS(offset >= 0 && offset <= 255);
-    p.outputs[0][i] = p.inputs[1][offset];
-  }
+  lut_int8(p.inputs[0], p.outputs[0], num_element, p.inputs[1]);
   return success();
 }
 
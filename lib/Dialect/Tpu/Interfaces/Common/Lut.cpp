@@ -19,15 +19,7 @@ void tpu::LutOp::deinit(InferenceParameter &p) {}
 
 LogicalResult tpu::LutOp::inference(InferenceParameter &p) {
   auto num_element = module::getNumElements(getInput());
-#pragma omp parallel for schedule(static, omp_schedule(num_element))
-  for (int i = 0; i < num_element; ++i) {
-    int offset = p.inputs[0][i];
-    if (offset < 0) {
-      offset += 256;
-    }
-    assert(offset >= 0 && offset <= 255);
-    p.outputs[0][i] = p.inputs[1][offset];
-  }
+  lut_int8(p.inputs[0], p.outputs[0], num_element, p.inputs[1]);
   return success();
 }
 
@@ -9,31 +9,18 @@
 
 #include "tpu_mlir/Backend/CV18xx/CV18xx.h"
 
+#include "tpu_mlir/Support/LutFunc.h"
 #include "tpu_mlir/Support/MathUtils.h"
 
-
 LogicalResult tpu::ScaleLutOp::init(InferenceParameter &p) { return success(); }
 void tpu::ScaleLutOp::deinit(InferenceParameter &p) {}
 
 LogicalResult tpu::ScaleLutOp::inference(InferenceParameter &p) {
-  float *input_data = p.inputs[0];
-  float *table = p.inputs[1];
-  float *output_data = p.outputs[0];
   auto input_shape = module::getShape(this->getInput());
-  int n = input_shape[0];
-  int c = input_shape[1];
-  int h = input_shape[2];
-  int w = input_shape[3];
-  for (int ni = 0; ni < n; ++ni) {
-    for (int ci = 0; ci < c; ++ci) {
-      for (int i = 0; i < h * w; ++i) {
-        int index = ni * c * h * w + ci * h * w + i;
-        auto x = input_data[index];
-        auto y = table[(int)(ci * 256 + x)];
-        output_data[index] = y;
-      }
-    }
-  }
+  int64_t n = input_shape[0];
+  int64_t c = input_shape[1];
+  int64_t inner = module::getNumElements(getInput()) / (n * c);
+  lut_int8_per_channel(p.inputs[0], p.outputs[0], n, c, inner, p.inputs[1]);
   return success();
 }
 
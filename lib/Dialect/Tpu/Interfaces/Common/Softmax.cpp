@@ -39,81 +39,81 @@ LogicalResult tpu::SoftmaxOp::inference(InferenceParameter &p) {
       auto qtype = module::getUniformQuantizedType(getInput());
       scale = qtype.getScale();
     }
-    std::vector<float> max_arr(inner_dim);
-    std::vector<float> sum_arr(inner_dim);
-    std::vector<float> sub_arr(channel * inner_dim);
-
     const auto bottom_data = p.inputs[0];
     auto top_data = p.outputs[0];
-
-    for (int i = 0; i < outer_dim; ++i) {
+    bool is_log = getLog();
+    // split inner_dim into blocks, so every task walks channel with
+    // contiguous inner data, and (outer, block) tasks run in parallel
+    const int block = inner_dim == 1 ? 1 : 64;
+    int num_block = (inner_dim + block - 1) / block;
+    int num_task = outer_dim * num_block;
+#pragma omp parallel for schedule(static, omp_schedule(num_task))
+    for (int t = 0; t < num_task; ++t) {
+      int i = t / num_block;
+      int k_start = (t % num_block) * block;
+      int k_num = std::min(block, inner_dim - k_start);
+      const float *src = bottom_data + i * channel * inner_dim + k_start;
+      float *dst = top_data + i * channel * inner_dim + k_start;
+      std::vector<float> max_arr(src, src + k_num);
+      std::vector<float> sum_arr(k_num, 0.0f);
       // find max value accross channel
-      int c_offset = i * channel * inner_dim;
-      memcpy(max_arr.data(), bottom_data + c_offset, inner_dim * sizeof(float));
-      for (int j = 0; j < channel; ++j, c_offset += inner_dim) {
-        for (int k = 0; k < inner_dim; k++) {
-          if (max_arr[k] < bottom_data[c_offset + k])
-            max_arr[k] = bottom_data[c_offset + k];
+      for (int j = 0; j < channel; ++j) {
+        auto row = src + j * inner_dim;
+        for (int k = 0; k < k_num; k++) {
+          max_arr[k] = std::max(max_arr[k], row[k]);
         }
       }
-      c_offset = i * channel * inner_dim;
       if (is_cv18xx) {
         // calculate x - max
-        for (int j = 0; j < channel; ++j, c_offset += inner_dim) {
-          for (int k = 0; k < inner_dim; k++) {
-            auto idx = j * inner_dim + k;
-            sub_arr[idx] = BF16(bottom_data[c_offset + k] - max_arr[k]);
+        std::vector<float> sub_arr(channel * k_num);
+        for (int j = 0; j < channel; ++j) {
+          auto row = src + j * inner_dim;
+          for (int k = 0; k < k_num; k++) {
+            sub_arr[j * k_num + k] = BF16(row[k] - max_arr[k]);
           }
         }
         // e^x
-        std::vector<float> ex_arr(channel * inner_dim);
+        std::vector<float> ex_arr(channel * k_num);
         bf16_lut_slope(sub_arr.data(), ex_arr.data(), sub_arr.size(),
-                       p.inputs[1], p.inputs[2], -EXP_BF16_LUT_RANGE, EXP_BF16_LUT_RANGE);
+                       p.inputs[1], p.inputs[2], -EXP_BF16_LUT_RANGE,
+                       EXP_BF16_LUT_RANGE);
         // sum of (e^x)
         float const_val = BF16(BF16(1.0 * channel) / channel);
-        memset(sum_arr.data(), 0, inner_dim * sizeof(float));
         for (int j = 0; j < channel; ++j) {
-          for (int k = 0; k < inner_dim; k++) {
-            auto idx = j * inner_dim + k;
-            sum_arr[k] += ex_arr[idx] * const_val;
+          for (int k = 0; k < k_num; k++) {
+            sum_arr[k] += ex_arr[j * k_num + k] * const_val;
           }
         }
         // convert to bf16
         BF16(sum_arr.data(), sum_arr.data(), sum_arr.size());
 
-        std::string mehod = getLog() ? "log" : "mantissa";
+        std::string mehod = is_log ? "log" : "mantissa";
         bf16_lut_mantissa(sum_arr.data(), sum_arr.data(), sum_arr.size(),
                           p.inputs[3], p.inputs[4], mehod);
 
-        c_offset = i * channel * inner_dim;
-        for (int j = 0; j < channel; ++j, c_offset += inner_dim) {
-          for (int k = 0; k < inner_dim; k++) {
-            auto idx = j * inner_dim + k;
-            if (getLog()) {
-              top_data[c_offset + k] = sub_arr[idx] - sum_arr[k];
-            } else {
-              top_data[c_offset + k] = ex_arr[idx] * sum_arr[k];
-            }
+        for (int j = 0; j < channel; ++j) {
+          auto row = dst + j * inner_dim;
+          for (int k = 0; k < k_num; k++) {
+            auto idx = j * k_num + k;
+            row[k] = is_log ? sub_arr[idx] - sum_arr[k] : ex_arr[idx] * sum_arr[k];
           }
         }
       } else {
         // calculate exp(x)
-        memset(sum_arr.data(), 0, inner_dim * sizeof(float));
-        for (int j = 0; j < channel; ++j, c_offset += inner_dim) {
-          for (int k = 0; k < inner_dim; k++) {
-            sub_arr[j * inner_dim + k] =
-                (bottom_data[c_offset + k] - max_arr[k]) * scale;
-            top_data[c_offset + k] = std::exp(sub_arr[j * inner_dim + k]);
-            sum_arr[k] += top_data[c_offset + k];
+        for (int j = 0; j < channel; ++j) {
+          auto in_row = src + j * inner_dim;
+          auto out_row = dst + j * inner_dim;
+          for (int k = 0; k < k_num; k++) {
+            out_row[k] = std::exp((in_row[k] - max_arr[k]) * scale);
+            sum_arr[k] += out_row[k];
           }
         }
-
-        c_offset = i * channel * inner_dim;
-        for (int j = 0; j < channel; ++j, c_offset += inner_dim) {
-          for (int k = 0; k < inner_dim; k++) {
-            top_data[c_offset + k] /= sum_arr[k];
-            if (getLog()) {
-              top_data[c_offset + k] = std::log(top_data[c_offset + k]);
+        for (int j = 0; j < channel; ++j) {
+          auto row = dst + j * inner_dim;
+          for (int k = 0; k < k_num; k++) {
+            row[k] /= sum_arr[k];
+            if (is_log) {
+              row[k] = std::log(row[k]);
             }
           }
         }
@@ -132,38 +132,39 @@ LogicalResult tpu::SoftmaxOp::inference(InferenceParameter &p) {
     auto zp = o_qtype.getZeroPoint();
     float scale = o_qtype.getScale();
     // auto round_mode = round_mode_convert(getRoundMode());
-    for (int i = 0; i < outer_dim; ++i) {
-      int64_t out_offset = i * inner_dim * channel;
-#pragma omp parallel for schedule(static, omp_schedule(inner_dim))
-      for (int j = 0; j < inner_dim; ++j) {
-        int max_val = p.inputs[0][out_offset + j];
-        for (int c = 1; c < channel; ++c) {
-          max_val = max_val > p.inputs[0][out_offset + c * inner_dim + j]
-                        ? max_val
-                        : p.inputs[0][out_offset + c * inner_dim + j];
-        }
-        float sum = 0.f;
-        for (int c = 0; c < channel; ++c) {
-          auto offset =
-              to_uint8(max_val - p.inputs[0][out_offset + c * inner_dim + j]);
-          sum += exp_table[offset];
-        }
-        for (int c = 0; c < channel; ++c) {
-          auto offset =
-              to_uint8(max_val - p.inputs[0][out_offset + c * inner_dim + j]);
-          float prob_rescaled = exp_table[offset];
-          prob_rescaled = prob_rescaled / (sum * scale);
-          if (out_type.isSignedInteger(8)) {
-            int prob_rnd = static_cast<int32_t>(std::round(prob_rescaled));
-            p.outputs[0][out_offset + c * inner_dim + j] =
-                to_int8(prob_rnd + zp);
-          } else if (out_type.isUnsignedInteger(8)) {
-            int prob_rnd = static_cast<int32_t>(prob_rescaled + 0.5);
-            p.outputs[0][out_offset + c * inner_dim + j] =
-                to_uint8(prob_rnd + zp);
-          } else {
-            llvm_unreachable("not support type");
-          }
+    int num_task = outer_dim * inner_dim;
+#pragma omp parallel for schedule(static, omp_schedule(num_task))
+    for (int t = 0; t < num_task; ++t) {
+      int i = t / inner_dim;
+      int j = t % inner_dim;
+      int64_t out_offset = (int64_t)i * inner_dim * channel;
+      int max_val = p.inputs[0][out_offset + j];
+      for (int c = 1; c < channel; ++c) {
+        max_val = max_val > p.inputs[0][out_offset + c * inner_dim + j]
+                      ? max_val
+                      : p.inputs[0][out_offset + c * inner_dim + j];
+      }
+      float sum = 0.f;
+      for (int c = 0; c < channel; ++c) {
+        auto offset =
+            to_uint8(max_val - p.inputs[0][out_offset + c * inner_dim + j]);
+        sum += exp_table[offset];
+      }
+      for (int c = 0; c < channel; ++c) {
+        auto offset =
+            to_uint8(max_val - p.inputs[0][out_offset + c * inner_dim + j]);
+        float prob_rescaled = exp_table[offset];
+        prob_rescaled = prob_rescaled / (sum * scale);
+        if (out_type.isSignedInteger(8)) {
+          int prob_rnd = static_cast<int32_t>(std::round(prob_rescaled));
+          p.outputs[0][out_offset + c * inner_dim + j] =
+              to_int8(prob_rnd + zp);
+        } else if (out_type.isUnsignedInteger(8)) {
+          int prob_rnd = static_cast<int32_t>(prob_rescaled + 0.5);
+          p.outputs[0][out_offset + c * inner_dim + j] =
+              to_uint8(prob_rnd + zp);
+        } else {
+          llvm_unreachable("not support type");
         }
       }
     }
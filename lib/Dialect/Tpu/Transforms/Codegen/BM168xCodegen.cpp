@@ -16,6 +16,7 @@
 #include "tpu_mlir/Support/GenericCpuFunc.h"
 #include "tpu_mlir/Support/MathUtils.h"
 #include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
 #include <llvm/Support/SHA256.h>
 
 #define DEBUG_TYPE "bm_codegen"
@@ -78,7 +79,21 @@ void BMCodegen::init(ModuleOp m, const std::string &filename, bool bmodel_only)
   profile_ctx = ProfileCtx(&opToLineCol, !bmodel_only);
   bm168x = BM168x::instance();
   bm168x->set_profile_dump(!bmodel_only);
-  model_gen = std::make_shared<bmodel::ModelGen>();
+  // keep the binary of large models in a temp file instead of memory, next
+  // to the bmodel unless TMPDIR is set, as /tmp is often in memory too
+  int64_t coeff_size = 0;
+  for (auto s : *module::getAllModules()) {
+    coeff_size += module::getCoeffSize(s);
+  }
+  std::string binary_dir;
+  if (getenv("TMPDIR") == nullptr) {
+    binary_dir = sys::path::parent_path(filename).str();
+    if (binary_dir.empty()) {
+      binary_dir = ".";
+    }
+  }
+  model_gen = std::make_shared<bmodel::ModelGen>(
+      0x1000000, coeff_size > (1l << 30), binary_dir);
   // add chip name
   model_gen->AddChip(chip);
   model_gen->AddNumDevice(num_device);
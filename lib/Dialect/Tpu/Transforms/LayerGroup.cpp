@@ -9,6 +9,9 @@
 
 #include "tpu_mlir/Dialect/Tpu/Transforms/Passes.h"
 
+#include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/CycleCache.h"
+#include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/GroupCostCache.h"
+#include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/GroupDecisionCache.h"
 #include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/GroupOps.h"
 
 using namespace llvm;
@@ -44,6 +47,16 @@ NnvlcMode force_nnvlc_mode(const std::string &nnvlc_mode) {
   }
 }
 
+CostModel force_cost_model(const std::string &cost_model) {
+  if (cost_model == "exact") {
+    return CostModel::EXACT;
+  } else if (cost_model == "roofline") {
+    return CostModel::ROOFLINE;
+  } else {
+    llvm_unreachable("Unknown cost model");
+  }
+}
+
 class LayerGroupPass : public LayerGroupBase<LayerGroupPass> {
 public:
   LayerGroupPass() {}
@@ -52,6 +65,17 @@ public:
     LgPass::OPTIONS.opt = opt;
     LgPass::OPTIONS.group_by_cores = force_group_by_cores(group_by_cores);
     LgPass::OPTIONS.nnvlc_mode = force_nnvlc_mode(compress_mode);
+    LgPass::OPTIONS.cost_model = force_cost_model(cost_model);
+    LgPass::OPTIONS.ilp_time_limit = ilp_time_limit;
+
+    // group cost and cycle are shared by all subnets of this compile
+    auto &cost_cache = GroupCostCache::getInstance();
+    auto &cycle_cache = CycleCache::getInstance();
+    cost_cache.clear();
+    cycle_cache.clear();
+    // decisions are shared by later compiles
+    auto &decision_cache = GroupDecisionCache::getInstance();
+    decision_cache.load(cache_file);
 
     // group pass by modules
     auto modules = module::getAllModules();
@@ -64,6 +88,12 @@ public:
         gOps.process(opt);
       }
     }
+    cost_cache.show_statistics();
+    cycle_cache.show_statistics();
+    cost_cache.clear();
+    cycle_cache.clear();
+    decision_cache.save();
+    decision_cache.clear();
   }
 };
 
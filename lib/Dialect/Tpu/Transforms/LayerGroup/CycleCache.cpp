@@ -0,0 +1,135 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// TPU-MLIR is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/CycleCache.h"
+#include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/LayerGroupUtil.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/Support/Format.h"
+#include <cstring>
+
+namespace tpu_mlir {
+namespace tpu {
+
+size_t CycleCache::KeyHash::operator()(const cycle_key_t &key) const {
+  return llvm::hash_combine_range(key.begin(), key.end());
+}
+
+void CycleCache::get_local_key(cycle_key_t &key, Operation *op,
+                               const local_sec_info_t &sec_info,
+                               bool calc_bdc_slack) {
+  key.clear();
+  key.push_back(CYCLE_LOCAL_LAYER);
+  key.push_back(calc_bdc_slack);
+  key.push_back((uintptr_t)op->getName().getAsOpaquePointer());
+  key.push_back((uintptr_t)op->getAttrDictionary().getAsOpaquePointer());
+  key.push_back(op->getNumOperands());
+  for (auto in : op->getOperands()) {
+    key.push_back((uintptr_t)in.getType().getAsOpaquePointer());
+    // weight and none operands are handled differently by codegen
+    auto src_op = in.getDefiningOp();
+    key.push_back(src_op ? (uintptr_t)src_op->getName().getAsOpaquePointer()
+                         : 0);
+  }
+  key.push_back(op->getNumResults());
+  for (auto out : op->getResults()) {
+    key.push_back((uintptr_t)out.getType().getAsOpaquePointer());
+  }
+  // sec_info is memset before filled, padding bytes are zero
+  const size_t num =
+      (sizeof(local_sec_info_t) + sizeof(uintptr_t) - 1) / sizeof(uintptr_t);
+  auto offset = key.size();
+  key.resize(offset + num, 0);
+  memcpy(key.data() + offset, &sec_info, sizeof(local_sec_info_t));
+}
+
+static void push_max_slice(cycle_key_t &key, const slice_info_t &si) {
+  int64_t n_slice, c_slice, h_slice, d_slice, w_slice;
+  get_max_slice_nchdw(si, n_slice, c_slice, h_slice, d_slice, w_slice);
+  key.push_back(n_slice);
+  key.push_back(c_slice);
+  key.push_back(h_slice);
+  key.push_back(d_slice);
+  key.push_back(w_slice);
+}
+
+bool CycleCache::get_load_key(cycle_key_t &key, Value v,
+                              const slice_info_t &si,
+                              const tensor_info_t &tensor_info,
+                              group_type_t group_type) {
+  if (tensor_info.use_3ic_opt != 0) {
+    // depends on the conv user and the slice index
+    return false;
+  }
+  key.clear();
+  key.push_back(CYCLE_LOAD);
+  key.push_back((uintptr_t)v.getType().getAsOpaquePointer());
+  key.push_back(group_type);
+  key.push_back(tensor_info.eu_align);
+  key.push_back(tensor_info.need_bcast);
+  push_max_slice(key, si);
+  return true;
+}
+
+void CycleCache::get_store_key(cycle_key_t &key, Value v,
+                               const slice_info_t &si,
+                               group_type_t group_type) {
+  key.clear();
+  key.push_back(CYCLE_STORE);
+  key.push_back((uintptr_t)v.getType().getAsOpaquePointer());
+  key.push_back(group_type);
+  push_max_slice(key, si);
+}
+
+bool CycleCache::find(const cycle_key_t &key, int64_t &cycle) {
+  auto kind = key[0];
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = cache_.find(key);
+  if (iter == cache_.end()) {
+    miss_num_[kind]++;
+    return false;
+  }
+  hit_num_[kind]++;
+  cycle = iter->second;
+  return true;
+}
+
+void CycleCache::insert(const cycle_key_t &key, int64_t cycle) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cache_[key] = cycle;
+}
+
+void CycleCache::clear_statistics() {
+  for (int i = 0; i < CYCLE_KIND_NUM; ++i) {
+    hit_num_[i] = 0;
+    miss_num_[i] = 0;
+  }
+}
+
+void CycleCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cache_.clear();
+  clear_statistics();
+}
+
+void CycleCache::show_statistics() {
+  static const char *names[CYCLE_KIND_NUM] = {"local layer", "load", "store"};
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (int i = 0; i < CYCLE_KIND_NUM; ++i) {
+    auto total = hit_num_[i] + miss_num_[i];
+    if (total == 0) {
+      continue;
+    }
+    llvm::errs() << llvm::format(
+        "cycle cache(%s): %ld queries, %ld hits (%.1f%%)\n", names[i], total,
+        hit_num_[i], 100.0 * hit_num_[i] / total);
+  }
+}
+
+} // namespace tpu
+} // namespace tpu_mlir
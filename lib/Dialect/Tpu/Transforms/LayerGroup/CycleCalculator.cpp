@@ -7,12 +7,15 @@
 //
 //===----------------------------------------------------------------------===//
 #include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/CycleCalculator.h"
+#include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/CycleCache.h"
 #include "tpu_mlir/Backend/CV18xx/CV18xx_local_api.h"
 #include "tpu_mlir/Backend/CV18xx/CV18xx_profiling.hpp"
 #include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/LayerGroupUtil.h"
+#include "tpu_mlir/Interfaces/FlopsInterface.h"
 #include "tpu_mlir/Support/MathUtils.h"
 #include "tpu_mlir/Backend/BM168x/BM1684.h"
 #include <llvm/Support/Debug.h>
+#include <mutex>
 
 #define DEBUG_TYPE "layer-group"
 
@@ -236,9 +239,15 @@ int64_t CycleCalculator::getGroupCycle(BasicTimeStepPtr &time_step,
   return total_cycle;
 }
 
+// The backends issue into one global command buffer, so BM168x queries hold
+// a BM168x::CycleQueryLock and CV18xx queries hold cv18xx_mutex, and run one
+// at a time. The issue flag is cleared once by LgPassManager::run before
+// searching.
+static std::recursive_mutex cv18xx_mutex;
+
 int64_t Bm168xCycleCalculator::getGlobalLayerCycle(Operation *op) {
+  BM168x::CycleQueryLock query_lock;
   auto bm168x = BM168x::instance();
-  bm168x->set_command_issue_flag(false);
   bm168x->reset_cmd_id_node();
 
   // generate_fake_global_addr(op);
@@ -254,14 +263,19 @@ int64_t Bm168xCycleCalculator::getLocalLayerCycle(Operation *op,
                                                   TensorInfo &tensor_infos,
                                                   group_type_t group_type,
                                                   bool calc_bdc_slack) {
-  auto bm168x = BM168x::instance();
   int64_t cycle = 0;
   local_sec_info_t sec_info;
   set_local_sec_info(sec_info, op, tensor_infos, group_type);
+  auto &cycle_cache = CycleCache::getInstance();
+  cycle_key_t key;
+  CycleCache::get_local_key(key, op, sec_info, calc_bdc_slack);
+  if (cycle_cache.find(key, cycle)) {
+    return cycle;
+  }
   auto lgOp = dyn_cast<LocalGenInterface>(op);
-  // #pragma omp critical
   {
-    bm168x->set_command_issue_flag(false);
+    BM168x::CycleQueryLock query_lock;
+    auto bm168x = BM168x::instance();
     bm168x->reset_cmd_id_node();
 
     // set_local_layer_io_addr(op);
@@ -276,14 +290,15 @@ int64_t Bm168xCycleCalculator::getLocalLayerCycle(Operation *op,
     }
     bm168x->dl_sg_stas_reset();
   }
+  cycle_cache.insert(key, cycle);
   return cycle;
 }
 
 int64_t Bm168xCycleCalculator::getGdmaCycle(Value v,
                                             tensor_info_t &tensor_info,
                                             group_type_t group_type, Operation* owner_op, int mode) {
+  BM168x::CycleQueryLock query_lock;
   auto bm168x = BM168x::instance();
-  bm168x->set_command_issue_flag(false);
   bm168x->reset_cmd_id_node();
 
   // because LoadOp/StoreOp are not created during LayerGroup
@@ -325,6 +340,14 @@ int64_t Bm168xCycleCalculator::getLoadCycle(Value v,
   if (owner_op) {
     si = tensor_info.slice_infos[owner_op];
   }
+  auto &cycle_cache = CycleCache::getInstance();
+  cycle_key_t key;
+  bool use_cache =
+      CycleCache::get_load_key(key, v, si, tensor_info, group_type);
+  int64_t cached_cycle;
+  if (use_cache && cycle_cache.find(key, cached_cycle)) {
+    return cached_cycle;
+  }
   get_max_slice_nchdw(si, n_slice, c_slice, h_slice, d_slice, w_slice);
   std::vector<slice_pair_t> slice_idx = get_max_slice_nchdw_and_idx(si, n_slice, c_slice, h_slice, d_slice, w_slice);
   int64_t use_3ic = tensor_info.use_3ic_opt;
@@ -458,6 +481,9 @@ int64_t Bm168xCycleCalculator::getLoadCycle(Value v,
   }
   int64_t gdma_cycle = bm168x->dl_get_cmd_id_cycle(pid_node);
   bm168x->dl_destroy_cmd_id_node(pid_node);
+  if (use_cache) {
+    cycle_cache.insert(key, gdma_cycle);
+  }
   return gdma_cycle;
 }
 
@@ -470,6 +496,13 @@ int64_t Bm168xCycleCalculator::getStoreCycle(Value v,
   auto bm168x = BM168x::instance();
   int64_t n_slice, c_slice, h_slice, d_slice, w_slice;
   auto &si = tensor_info.slice_info;
+  auto &cycle_cache = CycleCache::getInstance();
+  cycle_key_t key;
+  CycleCache::get_store_key(key, v, si, group_type);
+  int64_t cached_cycle;
+  if (cycle_cache.find(key, cached_cycle)) {
+    return cached_cycle;
+  }
   get_max_slice_nchdw(si, n_slice, c_slice, h_slice, d_slice, w_slice);
   auto pid_node = (CMD_ID_NODE *)bm168x->dl_create_cmd_id_node();
   bm168x->dl_reset_cmd_id(pid_node);
@@ -515,10 +548,12 @@ int64_t Bm168xCycleCalculator::getStoreCycle(Value v,
 
   int64_t gdma_cycle = bm168x->dl_get_cmd_id_cycle(pid_node);
   bm168x->dl_destroy_cmd_id_node(pid_node);
+  cycle_cache.insert(key, gdma_cycle);
   return gdma_cycle;
 }
 
 int64_t Cv18xxCycleCalculator::getGlobalLayerCycle(Operation *op) {
+  std::lock_guard<std::recursive_mutex> lock(cv18xx_mutex);
   std::vector<uint8_t> cmdbuf;
   auto castOp = dyn_cast<GlobalGenInterface>(op);
   castOp.codegen_global_cv18xx(0);
@@ -575,6 +610,7 @@ int64_t Cv18xxCycleCalculator::getLocalLayerCycle(Operation *op,
                                                   TensorInfo &tensor_infos,
                                                   group_type_t group_type,
                                                   bool calc_bdc_slack) {
+  std::lock_guard<std::recursive_mutex> lock(cv18xx_mutex);
   if (!check_lmem(op, tensor_infos, group_type)) {
     return std::numeric_limits<int64_t>::max() / 100;
   }
@@ -604,6 +640,7 @@ int64_t Cv18xxCycleCalculator::getGdmaCycle(Value v,
 int64_t Cv18xxCycleCalculator::getLoadCycle(Value v,
                                             tensor_info_t &tensor_info,
                                             group_type_t group_type, Operation* owner_op) {
+  std::lock_guard<std::recursive_mutex> lock(cv18xx_mutex);
   int64_t n_slice, c_slice, h_slice, d_slice, w_slice;
   auto &si = tensor_info.slice_info;
   get_max_slice_nchdw(si, n_slice, c_slice, h_slice, d_slice, w_slice);
@@ -660,6 +697,7 @@ int64_t Cv18xxCycleCalculator::getLoadCycle(Value v,
 int64_t Cv18xxCycleCalculator::getStoreCycle(Value v,
                                              const tensor_info_t &tensor_info,
                                              group_type_t group_type) {
+  std::lock_guard<std::recursive_mutex> lock(cv18xx_mutex);
   int64_t n_slice, c_slice, h_slice, d_slice, w_slice;
   auto &si = tensor_info.slice_info;
   get_max_slice_nchdw(si, n_slice, c_slice, h_slice, d_slice, w_slice);
@@ -704,5 +742,144 @@ int64_t Cv18xxCycleCalculator::getStoreCycle(Value v,
   return cycle;
 }
 
+int64_t RooflineCycleCalculator::getFLOPs(Operation *op) {
+  if (auto flops_op = dyn_cast<FlopsInterface>(op)) {
+    return flops_op.getFLOPs();
+  }
+  auto out_num = module::getNumElements(op->getResult(0));
+  if (auto conv_op = dyn_cast<tpu::Conv2DOp>(op)) {
+    auto attr = conv_op.parseParam();
+    return out_num * attr.kh * attr.kw * attr.ic / attr.groups * 2;
+  } else if (auto conv_op = dyn_cast<tpu::Conv3DOp>(op)) {
+    auto attr = conv_op.parseParam();
+    return out_num * attr.kd * attr.kh * attr.kw * attr.ic / attr.groups * 2;
+  } else if (auto deconv_op = dyn_cast<tpu::DeconvOp>(op)) {
+    auto attr = deconv_op.parseParam();
+    return module::getNumElements(deconv_op.getInput()) * attr.kh * attr.kw *
+           attr.oc / attr.g * 2;
+  } else if (auto matmul_op = dyn_cast<tpu::MatMulOp>(op)) {
+    auto attr = matmul_op.parseParam();
+    return attr.batch * attr.M * attr.K * attr.N * 2;
+  }
+  // element-wise like
+  return out_num;
+}
+
+int64_t RooflineCycleCalculator::getTiuCycle(Operation *op, double ratio) {
+  auto flops = getFLOPs(op) * ratio;
+  double dbytes = module::getDtypeSize(op->getOperand(0));
+  double ops_per_cycle;
+  if (isa<tpu::Conv2DOp, tpu::Conv3DOp, tpu::DeconvOp, tpu::MatMulOp>(op)) {
+    // one MAC is two ops
+    ops_per_cycle = 2.0 * Arch::TIU_MACS / std::max(dbytes, 1.0);
+  } else {
+    ops_per_cycle = Arch::NPU_NUM * Arch::eu_num(std::max(dbytes, 1.0));
+  }
+  return (int64_t)std::ceil(flops / ops_per_cycle);
+}
+
+int64_t RooflineCycleCalculator::getDmaCycle(int64_t bytes) {
+  return ceiling_func(bytes, Arch::GDMA_BYTES);
+}
+
+int64_t RooflineCycleCalculator::getGlobalLayerCycle(Operation *op) {
+  int64_t bytes = 0;
+  for (auto in : op->getOperands()) {
+    if (!module::isNone(in)) {
+      bytes += module::getBytes(in);
+    }
+  }
+  for (auto out : op->getResults()) {
+    if (!module::isNone(out)) {
+      bytes += module::getBytes(out);
+    }
+  }
+  return std::max(getTiuCycle(op), getDmaCycle(bytes));
+}
+
+int64_t RooflineCycleCalculator::getLocalLayerCycle(Operation *op,
+                                                    TensorInfo &tensor_infos,
+                                                    group_type_t group_type,
+                                                    bool calc_bdc_slack) {
+  // gdma of local layer is done by load/store, scale FLOPs by output slice
+  double ratio = 1.0;
+  Value out = op->getResult(0);
+  auto iter = tensor_infos.find(out);
+  if (iter != tensor_infos.end()) {
+    int64_t n_slice, c_slice, h_slice, d_slice, w_slice;
+    get_max_slice_nchdw(iter->second.slice_info, n_slice, c_slice, h_slice,
+                        d_slice, w_slice);
+    int64_t N, C, D, H, W;
+    module::getNCDHW(out, N, C, D, H, W, group_type);
+    ratio = (double)(n_slice * c_slice * d_slice * h_slice * w_slice) /
+            (N * C * D * H * W);
+  }
+  return getTiuCycle(op, std::min(ratio, 1.0));
+}
+
+int64_t RooflineCycleCalculator::getGdmaCycle(Value v,
+                                              tensor_info_t &tensor_info,
+                                              group_type_t group_type,
+                                              Operation *owner_op, int mode) {
+  bool is_load = tensor_info.mode == TIMESTEP_LOAD;
+  if (tensor_info.mode2 > 0) {
+    is_load = (tensor_info.mode2 & TIMESTEP2_LOAD) ||
+              ((tensor_info.mode2 & TIMESTEP2_STORE_AND_LOAD) && mode == 1);
+  }
+  if (is_load) {
+    return getLoadCycle(v, tensor_info, group_type,
+                        tensor_info.mode2 > 0 ? owner_op : nullptr);
+  }
+  return getStoreCycle(v, tensor_info, group_type);
+}
+
+static int64_t get_slice_bytes(Value v, const slice_info_t &si) {
+  int64_t n_slice, c_slice, h_slice, d_slice, w_slice;
+  get_max_slice_nchdw(si, n_slice, c_slice, h_slice, d_slice, w_slice);
+  return std::ceil(n_slice * c_slice * d_slice * h_slice * w_slice *
+                   module::getDtypeSize(v));
+}
+
+int64_t RooflineCycleCalculator::getLoadCycle(Value v,
+                                              tensor_info_t &tensor_info,
+                                              group_type_t group_type,
+                                              Operation *owner_op) {
+  auto &si = owner_op ? tensor_info.slice_infos[owner_op]
+                      : tensor_info.slice_info;
+  return getDmaCycle(get_slice_bytes(v, si));
+}
+
+int64_t RooflineCycleCalculator::getStoreCycle(Value v,
+                                               const tensor_info_t &tensor_info,
+                                               group_type_t group_type) {
+  return getDmaCycle(get_slice_bytes(v, tensor_info.slice_info));
+}
+
+int64_t RooflineCycleCalculator::getGroupBound(const LgInfo &lg_info) {
+  if (lg_info.group_ops.size() == 1) {
+    return getGlobalLayerCycle(lg_info.group_ops.back());
+  }
+  int64_t tiu_cycle = 0;
+  int64_t bytes = 0;
+  ValueSet weights;
+  for (auto op : lg_info.group_ops) {
+    tiu_cycle += getTiuCycle(op);
+    for (auto in : op->getOperands()) {
+      if (module::isWeight(in) && weights.insert(in).second) {
+        bytes += module::getBytes(in);
+      }
+    }
+  }
+  for (auto in : lg_info.group_ins) {
+    if (!module::isWeight(in)) {
+      bytes += module::getBytes(in);
+    }
+  }
+  for (auto out : lg_info.group_outs) {
+    bytes += module::getBytes(out);
+  }
+  return std::max(tiu_cycle, getDmaCycle(bytes));
+}
+
 } // namespace tpu
 } // namespace tpu_mlir
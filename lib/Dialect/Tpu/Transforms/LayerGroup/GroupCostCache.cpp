@@ -0,0 +1,115 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// TPU-MLIR is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/GroupCostCache.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/Support/Format.h"
+
+namespace tpu_mlir {
+namespace tpu {
+
+size_t GroupCostCache::KeyHash::operator()(const group_cost_key_t &key) const {
+  return llvm::hash_combine_range(key.begin(), key.end());
+}
+
+void GroupCostCache::get_key(group_cost_key_t &key, const LgInfo &lg_info,
+                             group_cost_kind_t kind, RunMode run_mode) {
+  key.clear();
+  key.push_back(kind);
+  key.push_back(lg_info.type);
+  key.push_back((uintptr_t)run_mode);
+
+  llvm::DenseMap<Operation *, uintptr_t> op_idx;
+  for (auto op : lg_info.group_ops) {
+    op_idx.insert({op, op_idx.size()});
+  }
+  // external inputs are numbered by first use, a value used twice differs
+  // from two values
+  llvm::DenseMap<Value, uintptr_t> in_idx;
+  for (auto op : lg_info.group_ops) {
+    key.push_back((uintptr_t)op->getName().getAsOpaquePointer());
+    key.push_back((uintptr_t)op->getAttrDictionary().getAsOpaquePointer());
+    key.push_back(op->getNumOperands());
+    for (auto in : op->getOperands()) {
+      key.push_back((uintptr_t)in.getType().getAsOpaquePointer());
+      auto src_op = in.getDefiningOp();
+      auto iter = src_op ? op_idx.find(src_op) : op_idx.end();
+      if (iter != op_idx.end()) {
+        key.push_back(0);
+        key.push_back(iter->second);
+        key.push_back(in.cast<OpResult>().getResultNumber());
+        continue;
+      }
+      key.push_back(1);
+      key.push_back(in_idx.insert({in, in_idx.size()}).first->second);
+      if (src_op != nullptr) {
+        // weight, none and so on are handled differently
+        key.push_back((uintptr_t)src_op->getName().getAsOpaquePointer());
+        key.push_back(
+            (uintptr_t)src_op->getAttrDictionary().getAsOpaquePointer());
+      } else {
+        key.push_back(0);
+        key.push_back(0);
+      }
+    }
+    key.push_back(op->getNumResults());
+    for (auto out : op->getResults()) {
+      key.push_back((uintptr_t)out.getType().getAsOpaquePointer());
+      bool is_group_out = false;
+      for (auto dst_op : out.getUsers()) {
+        if (op_idx.count(dst_op) == 0) {
+          is_group_out = true;
+          break;
+        }
+      }
+      key.push_back(is_group_out);
+    }
+  }
+}
+
+bool GroupCostCache::find(const group_cost_key_t &key,
+                          group_cost_info_t &info) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = cache_.find(key);
+  if (iter == cache_.end()) {
+    miss_num_++;
+    return false;
+  }
+  hit_num_++;
+  info = iter->second;
+  return true;
+}
+
+void GroupCostCache::insert(const group_cost_key_t &key,
+                            const group_cost_info_t &info) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cache_[key] = info;
+}
+
+void GroupCostCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cache_.clear();
+  hit_num_ = 0;
+  miss_num_ = 0;
+}
+
+void GroupCostCache::show_statistics() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto total = hit_num_ + miss_num_;
+  if (total == 0) {
+    return;
+  }
+  llvm::errs() << llvm::format(
+      "group cost cache: %ld queries, %ld hits (%.1f%%), %ld entries\n", total,
+      hit_num_, 100.0 * hit_num_ / total, (int64_t)cache_.size());
+}
+
+} // namespace tpu
+} // namespace tpu_mlir
@@ -0,0 +1,200 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// TPU-MLIR is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/GroupDecisionCache.h"
+#include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/LgPass.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace tpu_mlir {
+namespace tpu {
+
+// bump it when the search or the key changes
+static const char *CACHE_VERSION = "tpu-mlir layer group cache v1";
+
+std::string GroupDecisionCache::get_key(
+    const std::vector<Operation *> &base_group, RunMode run_mode) {
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  auto &options = LgPass::OPTIONS;
+  os << CACHE_VERSION << ";chip " << (int)module::getChip() << ";cores "
+     << module::getCoreNum() << ";train " << module::isTrain() << ";opt "
+     << options.opt << ";by_cores " << options.group_by_cores << ";nnvlc "
+     << (int)options.nnvlc_mode << ";cost " << (int)options.cost_model
+     << ";mode " << (int)run_mode << "\n";
+
+  llvm::DenseMap<Operation *, int64_t> op_idx;
+  for (auto op : base_group) {
+    op_idx.insert({op, (int64_t)op_idx.size()});
+  }
+  llvm::DenseMap<Value, int64_t> in_idx;
+  for (auto op : base_group) {
+    os << op->getName() << " {";
+    for (auto attr : op->getAttrs()) {
+      // fake params of searching, derived from shapes
+      if (attr.getName().getValue() == LocalGenInterface::kLayerGroupAttrName) {
+        continue;
+      }
+      os << attr.getName().getValue() << "=";
+      attr.getValue().print(os);
+      os << ",";
+    }
+    os << "} (";
+    for (auto in : op->getOperands()) {
+      in.getType().print(os);
+      auto src_op = in.getDefiningOp();
+      auto iter = src_op ? op_idx.find(src_op) : op_idx.end();
+      if (iter != op_idx.end()) {
+        os << " %" << iter->second << "#"
+           << in.cast<OpResult>().getResultNumber();
+      } else {
+        auto idx = in_idx.insert({in, (int64_t)in_idx.size()}).first->second;
+        os << " in" << idx << " "
+           << (src_op ? src_op->getName().getStringRef()
+                      : llvm::StringRef("arg"));
+      }
+      os << ",";
+    }
+    os << ") -> (";
+    for (auto out : op->getResults()) {
+      out.getType().print(os);
+      for (auto dst_op : out.getUsers()) {
+        if (op_idx.count(dst_op) == 0) {
+          os << " out";
+          break;
+        }
+      }
+      os << ",";
+    }
+    os << ")\n";
+  }
+  os.flush();
+
+  llvm::MD5 hash;
+  hash.update(str);
+  llvm::MD5::MD5Result result;
+  hash.final(result);
+  return result.digest().str().str();
+}
+
+void GroupDecisionCache::load(const std::string &file) {
+  clear();
+  file_ = file;
+  if (file_.empty()) {
+    return;
+  }
+  std::ifstream ifs(file_);
+  if (!ifs.is_open()) {
+    return;
+  }
+  std::string line;
+  if (!std::getline(ifs, line) || line != CACHE_VERSION) {
+    llvm::errs() << "layer group cache " << file_
+                 << " is out of date, ignore it\n";
+    return;
+  }
+  while (std::getline(ifs, line)) {
+    std::istringstream iss(line);
+    std::string key;
+    int64_t num = 0;
+    if (!(iss >> key >> num) || num <= 0) {
+      continue;
+    }
+    std::vector<int64_t> cut_result(num);
+    bool ok = true;
+    for (auto &idx : cut_result) {
+      ok = ok && (bool)(iss >> idx);
+    }
+    if (ok) {
+      cache_[key] = std::move(cut_result);
+    }
+  }
+  llvm::errs() << "load " << cache_.size() << " layer group decisions from "
+               << file_ << "\n";
+}
+
+void GroupDecisionCache::save() {
+  if (file_.empty()) {
+    return;
+  }
+  llvm::errs() << "layer group cache: " << hit_num_ << " hits, " << miss_num_
+               << " misses\n";
+  if (!dirty_) {
+    return;
+  }
+  // write to a temp file of unique name then rename, so concurrent compiles
+  // never write the same temp file nor see half file
+  int fd;
+  llvm::SmallString<128> tmp_file;
+  if (llvm::sys::fs::createUniqueFile(file_ + "-%%%%%%.tmp", fd, tmp_file)) {
+    llvm::errs() << "can't write layer group cache " << file_ << "\n";
+    return;
+  }
+  {
+    llvm::raw_fd_ostream ofs(fd, /*shouldClose=*/true);
+    ofs << CACHE_VERSION << "\n";
+    for (auto &it : cache_) {
+      ofs << it.first << " " << it.second.size();
+      for (auto idx : it.second) {
+        ofs << " " << idx;
+      }
+      ofs << "\n";
+    }
+    ofs.close();
+    if (ofs.has_error()) {
+      ofs.clear_error();
+      llvm::errs() << "can't write layer group cache " << tmp_file << "\n";
+      std::remove(tmp_file.c_str());
+      return;
+    }
+  }
+  if (std::rename(tmp_file.c_str(), file_.c_str()) != 0) {
+    llvm::errs() << "can't write layer group cache " << file_ << "\n";
+    std::remove(tmp_file.c_str());
+    return;
+  }
+  llvm::errs() << "save " << cache_.size() << " layer group decisions to "
+               << file_ << "\n";
+  dirty_ = false;
+}
+
+void GroupDecisionCache::clear() {
+  file_.clear();
+  cache_.clear();
+  dirty_ = false;
+  hit_num_ = 0;
+  miss_num_ = 0;
+}
+
+bool GroupDecisionCache::find(const std::string &key,
+                              std::vector<int64_t> &cut_result) {
+  auto iter = cache_.find(key);
+  if (iter == cache_.end()) {
+    miss_num_++;
+    return false;
+  }
+  hit_num_++;
+  cut_result = iter->second;
+  return true;
+}
+
+void GroupDecisionCache::insert(const std::string &key,
+                                const std::vector<int64_t> &cut_result) {
+  cache_[key] = cut_result;
+  dirty_ = true;
+}
+
+} // namespace tpu
+} // namespace tpu_mlir
@@ -10,6 +10,8 @@
 #include "tpu_mlir/Backend/BM168x/BM1684X.h"
 #include "tpu_mlir/Backend/BM168x/BackendInterfaces.h"
 #include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/GroupMethod.h"
+#include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/GroupCostCache.h"
+#include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/GroupDecisionCache.h"
 #include "progressbar.hpp"
 #include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/LayerGroupUtil.h"
 #include <llvm/Support/Debug.h>
@@ -27,10 +29,10 @@ namespace tpu {
 #define GROUP_CHECK_RETURN(val)                                                \
   {                                                                            \
     if (val) {                                                                 \
-      llvm::errs() << "layer group is valid";                                  \
+      lg_errs() << "layer group is valid";                                  \
       return true;                                                             \
     } else {                                                                   \
-      llvm::errs() << "layer group is invalid";                                \
+      lg_errs() << "layer group is invalid";                                \
       return false;                                                            \
     }                                                                          \
   }
@@ -208,6 +210,10 @@ GroupMethod::GroupMethod(int64_t opt) {
     Bm168xCycleCalculator *cyc_ptr = new Bm168xCycleCalculator();
     cycle_calculator_ = std::shared_ptr<CycleCalculator>(cyc_ptr);
   }
+  roofline_calculator_ = std::make_shared<RooflineCycleCalculator>();
+  roofline_check_num_ = 0;
+  roofline_agree_num_ = 0;
+  roofline_prune_num_ = 0;
   MAX_COST = llvm::maxIntN(64);
   opt_ = opt;
 }
@@ -224,6 +230,45 @@ int64_t GroupMethod::cost_add(int64_t cost0, int64_t cost1) {
   }
 }
 
+bool GroupMethod::is_roofline_worse(const LgInfo &lg_info,
+                                    int64_t other_cost) {
+  if (other_cost == MAX_COST) {
+    return false;
+  }
+  return roofline_calculator_->getGroupBound(lg_info) >= other_cost;
+}
+
+bool GroupMethod::roofline_prune(bool roofline_worse) {
+  if (!roofline_worse || LgPass::OPTIONS.cost_model != CostModel::ROOFLINE) {
+    return false;
+  }
+#pragma omp atomic
+  roofline_prune_num_++;
+  return true;
+}
+
+void GroupMethod::record_roofline(bool roofline_worse, bool exact_worse) {
+#pragma omp atomic
+  roofline_check_num_++;
+  if (roofline_worse == exact_worse) {
+#pragma omp atomic
+    roofline_agree_num_++;
+  }
+}
+
+void GroupMethod::show_roofline_statistics() {
+  if (roofline_check_num_ == 0 && roofline_prune_num_ == 0) {
+    return;
+  }
+  lg_errs() << llvm::format(
+      "roofline cost model: %ld checks, %.1f%% agree with exact, %ld pruned\n",
+      roofline_check_num_,
+      roofline_check_num_
+          ? 100.0 * roofline_agree_num_ / roofline_check_num_
+          : 0.0,
+      roofline_prune_num_);
+}
+
 bool GroupMethod::group_one_layer_proc(const LgInfo &lg_info, bool calc_cost,
                                        int64_t *group_cost) {
   if (lg_info.group_ops.size() == 1) {
@@ -313,7 +358,7 @@ void GroupMethod::get_base_branch_groups(
     tmp_base_groups.push_back(tmp);
   }
 
-  llvm::errs() << "get_base_branch_groups start, group num:"
+  lg_errs() << "get_base_branch_groups start, group num:"
                << tmp_base_groups.size() << "\n";
   while (true) {
     bool can_break = true;
@@ -345,7 +390,7 @@ void GroupMethod::get_base_branch_groups(
         }
         idx++;
       }
-      llvm::errs() << "op:" << module::getName(tmp_op).str() << " have "
+      lg_errs() << "op:" << module::getName(tmp_op).str() << " have "
                    << count << " input tensor is not weight\n";
       if (count == 1) {
         auto tmp_op2 = tmp_op->getOperand(imm_tensor_idx).getDefiningOp();
@@ -355,7 +400,7 @@ void GroupMethod::get_base_branch_groups(
             user_count++;
           }
         }
-        llvm::errs() << "have " << user_count << " next node\n";
+        lg_errs() << "have " << user_count << " next node\n";
         if (user_count > 1) { // �����ֲ��
           group.push_back(nullptr);
           bool grp_exist = false;
@@ -366,7 +411,7 @@ void GroupMethod::get_base_branch_groups(
             }
           }
           if (!grp_exist) {
-            llvm::errs() << "meet divide node, add new group, start op name:"
+            lg_errs() << "meet divide node, add new group, start op name:"
                          << module::getName(tmp_op2).str() << "\n";
             std::vector<Operation *> tmp;
             tmp.push_back(tmp_op2);
@@ -383,7 +428,7 @@ void GroupMethod::get_base_branch_groups(
               isa<top::NoneOp, top::WeightOp, top::InputOp>(pre_op)) {
             continue;
           }
-          llvm::errs() << "meet merge node, add new group, start op name:"
+          lg_errs() << "meet merge node, add new group, start op name:"
                        << module::getName(pre_op).str() << "\n";
           std::vector<Operation *> tmp;
           tmp.push_back(pre_op);
@@ -404,10 +449,10 @@ void GroupMethod::get_base_branch_groups(
 
   int i = 0;
   for (auto group : tmp_base_groups) {
-    llvm::errs() << ">>>tmp_base_groups grp:" << i++ << "\n";
+    lg_errs() << ">>>tmp_base_groups grp:" << i++ << "\n";
     int j = 0;
     for (auto op : group) {
-      llvm::errs() << "  op:" << j++ << " name: " << module::getName(op).str()
+      lg_errs() << "  op:" << j++ << " name: " << module::getName(op).str()
                    << "\n";
     }
   }
@@ -419,7 +464,7 @@ void GroupMethod::get_base_branch_groups(
       if (isLgSupport(op)) {
         tmp.push_back(op);
       } else {
-        llvm::errs() << "global layer name: " << module::getName(op).str()
+        lg_errs() << "global layer name: " << module::getName(op).str()
                      << "\n";
         if (tmp.size() > 1) {
           base_groups.push_back(tmp);
@@ -434,10 +479,10 @@ void GroupMethod::get_base_branch_groups(
 
   i = 0;
   for (auto group : base_groups) {
-    llvm::errs() << ">>>base_groups grp:" << i++ << "\n";
+    lg_errs() << ">>>base_groups grp:" << i++ << "\n";
     int j = 0;
     for (auto op : group) {
-      llvm::errs() << "  op:" << j++ << " name: " << module::getName(op).str()
+      lg_errs() << "  op:" << j++ << " name: " << module::getName(op).str()
                    << "\n";
     }
   }
@@ -477,10 +522,10 @@ void GroupMethod::get_base_dfs_topo_groups(
     const std::vector<std::vector<Operation *>> &tmp_base_groups) {
   int i = 0;
   for (auto group : tmp_base_groups) {
-    llvm::errs() << ">>>tmp_base_groups grp:" << i++ << "\n";
+    lg_errs() << ">>>tmp_base_groups grp:" << i++ << "\n";
     int j = 0;
     for (auto op : group) {
-      llvm::errs() << "  op:" << j++ << " name: " << module::getName(op).str()
+      lg_errs() << "  op:" << j++ << " name: " << module::getName(op).str()
                    << "\n";
     }
   }
@@ -500,7 +545,7 @@ void GroupMethod::get_base_dfs_topo_groups(
     if (LgInfo.group_ops.size() == 1) {
       continue;
     }
-    llvm::errs() << "start refine order, grp:" << --idx << "\n";
+    lg_errs() << "start refine order, grp:" << --idx << "\n";
     std::vector<Operation *> topo_ops;
     std::map<Operation *, int> indeg;
     auto ops = LgInfo.group_ops;
@@ -516,7 +561,7 @@ void GroupMethod::get_base_dfs_topo_groups(
     }
     std::vector<std::vector<Operation *>> serprated_groups;
     for (auto it : indeg) {
-      llvm::errs() << "  indeg, op name:" << module::getName(it.first).str()
+      lg_errs() << "  indeg, op name:" << module::getName(it.first).str()
                    << ", count:" << it.second << "\n";
       if (it.second == 0) {
         if (std::find(topo_ops.begin(), topo_ops.end(), it.first) ==
@@ -532,9 +577,9 @@ void GroupMethod::get_base_dfs_topo_groups(
     }
 
     int i = 0;
-    llvm::errs() << "full_topo_ops:\n";
+    lg_errs() << "full_topo_ops:\n";
     for (auto op : topo_ops) {
-      llvm::errs() << "  op:" << i++ << " name:" << module::getName(op).str()
+      lg_errs() << "  op:" << i++ << " name:" << module::getName(op).str()
                    << "\n";
     }
     std::vector<std::vector<Operation *>> serprated_groups_checked;
@@ -565,9 +610,9 @@ void GroupMethod::get_base_dfs_topo_groups(
         }
       }
       base_groups.push_back(topo_group);
-      llvm::errs() << "add new serprated_groups:\n";
+      lg_errs() << "add new serprated_groups:\n";
       for (auto op : topo_group) {
-        llvm::errs() << "  name:" << module::getName(op).str() << "\n";
+        lg_errs() << "  name:" << module::getName(op).str() << "\n";
       }
     }
 
@@ -671,6 +716,32 @@ bool GroupMethod::group_valid_pre_check(const LgInfo &lg_info) {
 
 bool GroupMethod::is_layer_group_valid(LgInfo &lg_info, bool calc_cost,
                                        int64_t *group_cost) {
+  if (lg_info.group_ops.size() == 1) {
+    return check_layer_group(lg_info, calc_cost, group_cost);
+  }
+  // group of more ops only writes cost when valid
+  group_cost_key_t key;
+  group_cost_info_t info;
+  auto &cost_cache = GroupCostCache::getInstance();
+  GroupCostCache::get_key(key, lg_info, GROUP_COST_VALID, runmode_);
+  if (cost_cache.find(key, info) &&
+      (!info.valid || info.has_cost || !calc_cost)) {
+    if (info.valid && calc_cost) {
+      *group_cost = info.cost;
+    }
+    return info.valid;
+  }
+  info.valid = check_layer_group(lg_info, calc_cost, &info.cost);
+  info.has_cost = calc_cost;
+  cost_cache.insert(key, info);
+  if (info.valid && calc_cost) {
+    *group_cost = info.cost;
+  }
+  return info.valid;
+}
+
+bool GroupMethod::check_layer_group(LgInfo &lg_info, bool calc_cost,
+                                    int64_t *group_cost) {
   bool status;
   status = group_one_layer_proc(lg_info, calc_cost, group_cost);
   if (status && LgPass::OPTIONS.group_by_cores == false) {
@@ -705,8 +776,6 @@ bool GroupMethod::is_layer_group_valid(LgInfo &lg_info, bool calc_cost,
   }
 
   if (calc_cost) {
-// remove it after pid_node is extractedb
-#pragma omp critical(get_cycle)
     *group_cost =
         cycle_calculator_->getGroupCycle(time_step, shape_secs, lg_info.type);
   }
@@ -785,12 +854,28 @@ void GroupMethod::get_group_clusters(
     }
   }
 
-  llvm::errs() << "clusters idx(size): ";
+  lg_errs() << "clusters idx(size): ";
   for (size_t i = 0; i < clusters.size(); ++i) {
-    llvm::errs() << llvm::format("%d(%d), ", clusters[i].first,
+    lg_errs() << llvm::format("%d(%d), ", clusters[i].first,
                                  clusters[i].second);
   }
-  llvm::errs() << "\n";
+  lg_errs() << "\n";
+}
+
+bool GroupMethod::is_valid_cut_result(const std::vector<int64_t> &cut_result,
+                                      int64_t layer_num) {
+  int64_t pre_idx = -1;
+  for (auto idx : cut_result) {
+    if (idx <= pre_idx || idx >= layer_num) {
+      return false;
+    }
+    pre_idx = idx;
+  }
+  return !cut_result.empty();
+}
+
+bool GroupMethod::is_cut_cached(size_t base_group_idx) {
+  return base_group_idx < cut_cached_.size() && cut_cached_[base_group_idx];
 }
 
 void GroupMethod::sweep_for_min_cost(
@@ -836,7 +921,7 @@ void createSubnetGraph(std::vector<Operation *> subnet_ops,
 
 void GroupMethod::dynamic_programming_layer_group_with_cluster(
     std::vector<LgInfo> &lg_infos, const SetVector<Operation *> &subnet_ops) {
-  llvm::errs() << "\n"
+  lg_errs() << "\n"
                << "=======================================================\n"
                << "***** Dynamic Programming layer group with cluster ****\n"
                << "=======================================================\n";
@@ -848,16 +933,32 @@ void GroupMethod::dynamic_programming_layer_group_with_cluster(
   // std::shared_ptr<dot_graph> opt2_dot_graph = std::make_shared<dot_graph>();
   // createSubnetGraph(ops_vector, opt2_dot_graph);
   // for debug
-  LgInfo sub_group;
   std::vector<std::vector<Operation *>> base_groups;
   get_base_groups(base_groups, subnet_ops);
-  llvm::errs() << llvm::format("total num of base_group is %d\n",
+  lg_errs() << llvm::format("total num of base_group is %d\n",
                                base_groups.size());
+  // reuse decisions of unchanged base groups from previous compiles
+  auto &decision_cache = GroupDecisionCache::getInstance();
+  std::vector<std::string> cache_keys(base_groups.size());
+  cut_cached_.assign(base_groups.size(), false);
   for (size_t i = 0; i < base_groups.size(); ++i) {
+    if (decision_cache.enabled()) {
+      std::vector<int64_t> cut_result;
+      cache_keys[i] = GroupDecisionCache::get_key(base_groups[i], runmode_);
+      if (decision_cache.find(cache_keys[i], cut_result) &&
+          is_valid_cut_result(cut_result, base_groups[i].size())) {
+        lg_errs() << llvm::format(
+            "process base group %d, layer_num=%d, reuse cached cut results\n",
+            i, base_groups[i].size());
+        cut_results_.push_back(std::move(cut_result));
+        cut_cached_[i] = true;
+        continue;
+      }
+    }
     std::vector<std::pair<int64_t, int64_t>> clusters;
     get_group_clusters(clusters, base_groups[i]);
     size_t cluster_num = clusters.size();
-    llvm::errs() << llvm::format(
+    lg_errs() << llvm::format(
         "process base group %d, layer_num=%d, cluster_num=%d\n", i,
         base_groups[i].size(), cluster_num);
     if (cluster_num > 1) {
@@ -865,15 +966,21 @@ void GroupMethod::dynamic_programming_layer_group_with_cluster(
           cluster_num, std::vector<int64_t>(cluster_num, 0));
       auto cut_points = std::vector<std::vector<int64_t>>(
           cluster_num, std::vector<int64_t>(cluster_num, 0));
+      // groups are evaluated concurrently, backend cycle queries are
+      // serialized by BM168x::CycleQueryLock, cached cycles are not
+#pragma omp parallel for schedule(dynamic)
       for (size_t j = 0; j < cluster_num; ++j) {
+        LgInfo sub_group;
         int64_t start_idx = clusters[j].first;
         int64_t end_idx = start_idx + clusters[j].second - 1;
         get_layer_group(sub_group, base_groups[i], start_idx, end_idx);
 
-        assert(is_layer_group_valid(sub_group, true, &cost_table[j][j]));
+        bool valid = is_layer_group_valid(sub_group, true, &cost_table[j][j]);
+        assert(valid);
+        (void)valid;
 
         LLVM_DEBUG({
-          llvm::errs() << "cluster[" << j << "] = " << start_idx << ", "
+          lg_errs() << "cluster[" << j << "] = " << start_idx << ", "
                        << end_idx << ";" << "cost = " << cost_table[j][j]
                        << "\n";
           sub_group.dump_lginfo();
@@ -881,46 +988,61 @@ void GroupMethod::dynamic_programming_layer_group_with_cluster(
 
         cut_points[j][j] = j;
       }
-      llvm::errs() << "Searching best group slices...\n";
+      lg_errs() << "Searching best group slices...\n";
       progressbar bar(cluster_num - 1);
       for (size_t len = 2; len <= cluster_num; ++len) {
         bar.update();
         // llvm::errs() << llvm::format("process cluster len = %d\n", len);
-        // #pragma omp parallel for private(sub_group)
-        for (int64_t start = 0; start <= cluster_num - len; ++start) {
+        // ranges of one length only depend on shorter ones
+#pragma omp parallel for schedule(dynamic)
+        for (int64_t start = 0; start <= (int64_t)(cluster_num - len);
+             ++start) {
+          LgInfo sub_group;
           int64_t end = start + len - 1;
           // llvm::errs() << "start = " << start << ", end = " << end << "\n";
           int64_t start_idx = clusters[start].first;
           int64_t end_idx = clusters[end].first + clusters[end].second - 1;
           get_layer_group(sub_group, base_groups[i], start_idx, end_idx);
 
+          // shorter ranges are known, the best cut is a bound for the group
+          int64_t cut_cost = MAX_COST;
+          int64_t cut_point = end;
+          for (int64_t sweep = start; sweep < end; ++sweep) {
+            int64_t temp_cost =
+                cost_add(cost_table[start][sweep], cost_table[sweep + 1][end]);
+            if (temp_cost < cut_cost) {
+              cut_cost = temp_cost;
+              cut_point = sweep;
+            }
+          }
+
           int64_t group_cost = MAX_COST;
-          is_layer_group_valid(sub_group, true, &group_cost);
+          bool roofline_worse = is_roofline_worse(sub_group, cut_cost);
+          if (!roofline_prune(roofline_worse)) {
+            is_layer_group_valid(sub_group, true, &group_cost);
+            if (cut_cost != MAX_COST) {
+              record_roofline(roofline_worse, group_cost >= cut_cost);
+            }
+          }
 
           int64_t optimal_point = end;
-          // sweep_for_min_cost(&group_cost, &optimal_point, start, end,
-          //                    cost_table);
           LLVM_DEBUG({
-            llvm::errs() << "; start_idx = " << start_idx
+            lg_errs() << "; start_idx = " << start_idx
                          << "; end_idx = " << end_idx
                          << "; group_cost = " << group_cost << "\n";
           });
 
-          for (int64_t sweep = start; sweep < end; ++sweep) {
-            int64_t temp_cost =
-                cost_add(cost_table[start][sweep], cost_table[sweep + 1][end]);
-            if (temp_cost < group_cost) {
-              group_cost = temp_cost;
-              optimal_point = sweep;
-              LLVM_DEBUG({
-                llvm::errs() << "; update better" << "; start = " << start
-                             << "; sweep = " << sweep << "; end = " << end
-                             << "; temp_cost = " << temp_cost << "\n";
-              });
-            }
+          if (cut_cost < group_cost) {
+            group_cost = cut_cost;
+            optimal_point = cut_point;
+            LLVM_DEBUG({
+              lg_errs() << "; update better" << "; start = " << start
+                           << "; sweep = " << cut_point << "; end = " << end
+                           << "; temp_cost = " << cut_cost << "\n";
+            });
           }
           LLVM_DEBUG({
-            llvm::errs() << "; start_idx = " << start_idx
+            lg_errs() << "; start_idx = " << start_idx
                          << "; end_idx = " << end_idx
                          << "; group_cost = " << group_cost << "\n";
           });
@@ -929,7 +1051,7 @@ void GroupMethod::dynamic_programming_layer_group_with_cluster(
           cut_points[start][end] = optimal_point;
         }
       }
-      llvm::errs() << "\n";
+      lg_errs() << "\n";
       std::vector<int64_t> cut_result;
       get_layer_cut_result(cut_result, clusters, cut_points, 0,
                            cluster_num - 1);
@@ -941,28 +1063,28 @@ void GroupMethod::dynamic_programming_layer_group_with_cluster(
           get_layer_group(sub_group, base_groups[i], start, end);
           int64_t group_cost = MAX_COST;
           auto temp_status = is_layer_group_valid(sub_group, true, &group_cost);
-          llvm::errs() << temp_status << " ;start" << start << " - " << " end "
+          lg_errs() << temp_status << " ;start" << start << " - " << " end "
                        << end << " = " << group_cost << "\n";
           start = end + 1;
         }
 
-        llvm::errs() << "\n";
-        llvm::errs() << "================FINAL GROUP================\n";
+        lg_errs() << "\n";
+        lg_errs() << "================FINAL GROUP================\n";
         for (size_t cost_i = 0; cost_i < cluster_num; ++cost_i) {
           for (int64_t cost_j = 0; cost_j < cluster_num; ++cost_j) {
-            llvm::errs() << cut_points[cost_i][cost_j] << ", " << "";
+            lg_errs() << cut_points[cost_i][cost_j] << ", " << "";
           }
-          llvm::errs() << "\n";
+          lg_errs() << "\n";
         }
-        llvm::errs() << "================COST TABLE================\n";
+        lg_errs() << "================COST TABLE================\n";
         for (size_t cost_i = 0; cost_i < cluster_num; ++cost_i) {
           for (int64_t cost_j = 0; cost_j < cluster_num; ++cost_j) {
-            llvm::errs() << cost_table[cost_i][cost_j] << ", " << "";
+            lg_errs() << cost_table[cost_i][cost_j] << ", " << "";
           }
-          llvm::errs() << "\n";
+          lg_errs() << "\n";
         }
-        llvm::errs() << "=============================================\n";
-        llvm::errs() << "\n";
+        lg_errs() << "=============================================\n";
+        lg_errs() << "\n";
       });
     } else {
       cut_results_.push_back(std::vector<int64_t>(1, 0));
@@ -971,27 +1093,35 @@ void GroupMethod::dynamic_programming_layer_group_with_cluster(
 
   show_cut_results();
   // some post process for cluster
-  llvm::errs() << "-------------------------------------------------------\n";
-  llvm::errs() << "Consider redundant computation and gdma cost\n";
-  llvm::errs() << "-------------------------------------------------------\n";
+  lg_errs() << "-------------------------------------------------------\n";
+  lg_errs() << "Consider redundant computation and gdma cost\n";
+  lg_errs() << "-------------------------------------------------------\n";
   consider_redundant_computation_and_gdma_cost(base_groups);
   show_cut_results();
 
-  llvm::errs() << "-------------------------------------------------------\n";
-  llvm::errs() << "Merge cut idx to reduce gdma cost\n";
-  llvm::errs() << "-------------------------------------------------------\n";
+  lg_errs() << "-------------------------------------------------------\n";
+  lg_errs() << "Merge cut idx to reduce gdma cost\n";
+  lg_errs() << "-------------------------------------------------------\n";
   bool take_effective = merge_cut_idx_to_reduce_gdma_cost(base_groups);
   show_cut_results();
 
   if (take_effective) {
-    llvm::errs() << "-------------------------------------------------------\n";
-    llvm::errs() << "Consider redundant computation and gdma cost again\n"
+    lg_errs() << "-------------------------------------------------------\n";
+    lg_errs() << "Consider redundant computation and gdma cost again\n"
                  << "due to cut idx merged in the previous step\n";
-    llvm::errs() << "-------------------------------------------------------\n";
+    lg_errs() << "-------------------------------------------------------\n";
     consider_redundant_computation_and_gdma_cost(base_groups);
     show_cut_results();
   }
 
+  if (decision_cache.enabled()) {
+    for (size_t i = 0; i < base_groups.size(); ++i) {
+      if (!cut_cached_[i]) {
+        decision_cache.insert(cache_keys[i], cut_results_[i]);
+      }
+    }
+  }
+
   // update lg_infos
   get_final_groups(lg_infos, base_groups);
   // for debug
@@ -1083,7 +1213,7 @@ bool GroupMethod::update_sequence_group_cost(LgInfo *left_layer_group,
   }
   int64_t total_cost = group_costs[0] + group_costs[1];
   if (pre_cost_judge) {
-    LLVM_DEBUG(llvm::errs() << "The pre cost of the two group is " << total_cost
+    LLVM_DEBUG(lg_errs() << "The pre cost of the two group is " << total_cost
                             << "\n";);
     if (opt_seq_info.min_cost >= 0 && opt_seq_info.min_cost < total_cost) {
       return false;
@@ -1107,7 +1237,7 @@ bool GroupMethod::update_sequence_group_cost(LgInfo *left_layer_group,
     return false;
   }
   total_cost = group_costs[0] + group_costs[1];
-  llvm::errs() << "The final cost of the two group is " << total_cost << "\n";
+  lg_errs() << "The final cost of the two group is " << total_cost << "\n";
   if (opt_seq_info.min_cost >= 0 && opt_seq_info.min_cost <= total_cost) {
     return false;
   }
@@ -1127,6 +1257,9 @@ bool GroupMethod::consider_redundant_computation_and_gdma_cost(
   LgInfo left_sub_group, right_sub_group;
 
   for (size_t i = 0; i < base_groups.size(); ++i) {
+    if (is_cut_cached(i)) {
+      continue;
+    }
     auto &base_group = base_groups[i];
     auto &cut_result = cut_results_[i];
     size_t cut_num = cut_result.size();
@@ -1148,7 +1281,7 @@ bool GroupMethod::consider_redundant_computation_and_gdma_cost(
               &left_sub_group, &right_sub_group, &left_first, seq_info);
           if (is_better) {
             optimal_cut_idx = cut_result[j];
-            llvm::errs() << "//// Group cost " << seq_info.min_cost
+            lg_errs() << "//// Group cost " << seq_info.min_cost
                          << ", optimal cut idx " << optimal_cut_idx << "\n";
           }
         }
@@ -1165,6 +1298,9 @@ bool GroupMethod::merge_cut_idx_to_reduce_gdma_cost(
   bool lg_valid;
   bool take_effective = false;
   for (size_t i = 0; i < base_groups.size(); ++i) {
+    if (is_cut_cached(i)) {
+      continue;
+    }
     auto &base_group = base_groups[i];
     auto &cut_result = cut_results_[i];
     if (get_max_cluster_size(base_group.size()) > 1) {
@@ -1192,7 +1328,7 @@ bool GroupMethod::merge_cut_idx_to_reduce_gdma_cost(
         if (lg_valid) {
           if (combine_group_cost < left_group_cost + right_group_cost) {
             LLVM_DEBUG({
-              llvm::errs() << "; start_idx = " << start_cut_idx
+              lg_errs() << "; start_idx = " << start_cut_idx
                            << "; end_idx = " << end_cut_idx
                            << "; group_cost = " << combine_group_cost
                            << "; base_group = " << i << "; action = "
@@ -1218,7 +1354,7 @@ bool GroupMethod::merge_cut_idx_to_reduce_gdma_cost(
 
 void GroupMethod::simple_layer_group(std::vector<LgInfo> &lg_infos,
                                      const SetVector<Operation *> &subnet_ops) {
-  llvm::errs() << "\n"
+  lg_errs() << "\n"
                << "=======================================================\n"
                << "*********** Group layers as many as possible **********\n"
                << "=======================================================\n";
@@ -1366,7 +1502,7 @@ GroupMethod::get_sec_per_cores(const shape_secs_t &shape_secs,
   }
 
   for (int i = 0; i < core_num; i++) {
-    llvm::errs() << "sec_per_cores:" << sec_per_cores[i] << "\n";
+    lg_errs() << "sec_per_cores:" << sec_per_cores[i] << "\n";
   }
 
   for (int n = 0; n < shape_secs.nsecs; n++) { // todo Ѱ���ø���core����ˮһ�µ�˳��
@@ -1501,10 +1637,10 @@ ExcludeOpFromGroup(std::vector<Operation *> &group_ops, Operation *fail_op) {
   }
 
   if (del_ops.size() > 0) {
-    llvm::errs() << "get a new grp:\n";
+    lg_errs() << "get a new grp:\n";
   }
   for (auto del_op : del_ops) {
-    llvm::errs() << "  name:" << module::getName(del_op).str() << "\n";
+    lg_errs() << "  name:" << module::getName(del_op).str() << "\n";
     group_ops.erase(std::remove(group_ops.begin(), group_ops.end(), del_op),
                     group_ops.end());
   }
@@ -1560,9 +1696,9 @@ void mergeEdgeOpToOtherGrp(int cur_grp_idx,
   }
   if (max_group_idx != -1) {
     base_groups[max_group_idx].push_back(fail_op);
-    llvm::errs() << "add fail_op to group" << max_group_idx << "\n";
+    lg_errs() << "add fail_op to group" << max_group_idx << "\n";
   } else {
-    llvm::errs() << "make fail_op as global layer\n";
+    lg_errs() << "make fail_op as global layer\n";
   }
 }
 
@@ -1576,13 +1712,13 @@ std::vector<op_var_pos_info> createOverlapStrategy(const LgInfo &lg_info,
   op_var_bound.push_back(null_var_pos);
   int k = 1;
   int op_num = lg_info.group_ops.size();
-  llvm::errs() << "old overlap:" << overlap << "\n";
+  lg_errs() << "old overlap:" << overlap << "\n";
   if (op_num <= overlap) {
     overlap = 1;
   } else if (op_num * 0.2 > overlap) {
     overlap = op_num * 0.2;
   }
-  llvm::errs() << "new overlap:" << overlap << "\n";
+  lg_errs() << "new overlap:" << overlap << "\n";
   for (int n = 0; n < slice_num; n++) {
     int group_offset = k;
     for (int m = 0; m < op_num; m++) {
@@ -1669,17 +1805,33 @@ void show_group(LgInfo *sub_group)
 
   for (auto op : sub_group->group_ops) {
     auto name = module::getName(op).str();
-    llvm::errs() << "  op:" << name << "\n";
+    lg_errs() << "  op:" << name << "\n";
   }
   for (auto out : sub_group->group_outs) {
-    llvm::errs() << "    out:" << module::getName(out).str() << "\n";
+    lg_errs() << "    out:" << module::getName(out).str() << "\n";
   }
   for (auto in : sub_group->group_ins) {
-    llvm::errs() << "    in:" << module::getName(in).str() << "\n";
+    lg_errs() << "    in:" << module::getName(in).str() << "\n";
   }
 }
 
 int64_t GroupMethod::get_group_cycle(LgInfo *sub_group)
+{
+  group_cost_key_t key;
+  group_cost_info_t info;
+  auto &cost_cache = GroupCostCache::getInstance();
+  GroupCostCache::get_key(key, *sub_group, GROUP_COST_CYCLE, runmode_);
+  if (cost_cache.find(key, info)) {
+    return info.cost;
+  }
+  info.cost = calc_group_cycle(sub_group);
+  info.valid = info.cost != 0;
+  info.has_cost = true;
+  cost_cache.insert(key, info);
+  return info.cost;
+}
+
+int64_t GroupMethod::calc_group_cycle(LgInfo *sub_group)
 {
   int64_t group_cost = 0;
   shape_secs_t ori_group_shape_secs;
@@ -1706,7 +1858,7 @@ int64_t GroupMethod::get_group_cycle(LgInfo *sub_group)
 
 Operation* GroupMethod::cut_this_group_is_better(LgInfo *sub_group)
 {
-  llvm::errs() << ">>>>>> try to cut this group" <<":\n";
+  lg_errs() << ">>>>>> try to cut this group" <<":\n";
   show_group(sub_group);
 
   std::vector<std::pair<Operation*, int>> cut_op_idx;
@@ -1730,55 +1882,99 @@ Operation* GroupMethod::cut_this_group_is_better(LgInfo *sub_group)
   if(original_group_cost == 0){
     return nullptr;
   }
-  llvm::errs() << ">>>>>> original_group_cost:" << original_group_cost <<":\n";
+  lg_errs() << ">>>>>> original_group_cost:" << original_group_cost <<":\n";
   //尝试所有可以切分的方案,找出耗时最短的方案
-  int64_t min_cost = llvm::maxIntN(64);
-  Operation* cut_op = nullptr;
+  // candidates are evaluated in parallel, then compared in order
+  struct cut_try_t {
+    std::string log;
+    bool pruned = true;
+    int64_t global_op_cost = 0;
+    int64_t left_sub_group_cost = 0;
+    int64_t right_sub_group_cost = 0;
+    bool roofline_worse = false;
+    LgInfo left_sub_group;
+    LgInfo right_sub_group;
+  };
+  std::vector<cut_try_t> cut_tries(cut_op_idx.size());
+#pragma omp parallel for schedule(dynamic)
   for(int i=0; i<cut_op_idx.size(); i++)
   {
     auto global_op = cut_op_idx[i].first;
     int64_t idx = cut_op_idx[i].second;
-    int64_t global_op_cost = cycle_calculator_->getGlobalLayerCycle(global_op);
-
-    int64_t left_sub_group_cost = 0;
-    int64_t right_sub_group_cost = 0;
-    LgInfo left_sub_group, right_sub_group;
+    auto &cut_try = cut_tries[i];
+    auto &left_sub_group = cut_try.left_sub_group;
+    auto &right_sub_group = cut_try.right_sub_group;
+    LgLogBuffer log_buffer;
+    int64_t roofline_cost = roofline_calculator_->getGlobalLayerCycle(global_op);
     if(idx-1 >= 0)
     {
       get_layer_group(left_sub_group, sub_group->group_ops, 0, idx-1);
+      roofline_cost += roofline_calculator_->getGroupBound(left_sub_group);
+    }
+    if(idx+1 <= sub_group->group_ops.size()-1)
+    {
+      get_layer_group(right_sub_group, sub_group->group_ops, idx+1, sub_group->group_ops.size()-1);
+      roofline_cost += roofline_calculator_->getGroupBound(right_sub_group);
+    }
+    cut_try.roofline_worse = roofline_cost >= original_group_cost;
+    if (roofline_prune(cut_try.roofline_worse)) {
+      cut_try.log = log_buffer.take();
+      continue;
+    }
+    cut_try.pruned = false;
+    cut_try.global_op_cost = cycle_calculator_->getGlobalLayerCycle(global_op);
+    if(!left_sub_group.group_ops.empty())
+    {
       if(left_sub_group.group_ops.size()==1){
-        left_sub_group_cost = cycle_calculator_->getGlobalLayerCycle(left_sub_group.group_ops.back());
+        cut_try.left_sub_group_cost = cycle_calculator_->getGlobalLayerCycle(left_sub_group.group_ops.back());
       }
       else{
-        left_sub_group_cost = get_group_cycle(&left_sub_group);
+        cut_try.left_sub_group_cost = get_group_cycle(&left_sub_group);
       }
     }
-    if(idx+1 <= sub_group->group_ops.size()-1)
+    if(!right_sub_group.group_ops.empty())
     {
-      get_layer_group(right_sub_group, sub_group->group_ops, idx+1, sub_group->group_ops.size()-1);
       if(right_sub_group.group_ops.size()==1){
-        right_sub_group_cost = cycle_calculator_->getGlobalLayerCycle(right_sub_group.group_ops.back());
+        cut_try.right_sub_group_cost = cycle_calculator_->getGlobalLayerCycle(right_sub_group.group_ops.back());
       }
       else{
-        right_sub_group_cost = get_group_cycle(&right_sub_group);
+        cut_try.right_sub_group_cost = get_group_cycle(&right_sub_group);
       }
     }
+    cut_try.log = log_buffer.take();
+  }
+
+  int64_t min_cost = llvm::maxIntN(64);
+  Operation* cut_op = nullptr;
+  for(int i=0; i<cut_op_idx.size(); i++)
+  {
+    auto &cut_try = cut_tries[i];
+    lg_errs() << cut_try.log;
+    if (cut_try.pruned) {
+      continue;
+    }
+    auto global_op = cut_op_idx[i].first;
+    int64_t idx = cut_op_idx[i].second;
+    int64_t global_op_cost = cut_try.global_op_cost;
+    int64_t left_sub_group_cost = cut_try.left_sub_group_cost;
+    int64_t right_sub_group_cost = cut_try.right_sub_group_cost;
     int64_t cut_group_cost = left_sub_group_cost + right_sub_group_cost + global_op_cost;
+    record_roofline(cut_try.roofline_worse, cut_group_cost >= original_group_cost);
     if(cut_group_cost < original_group_cost && cut_group_cost < min_cost)
     {
       min_cost = std::min(min_cost, cut_group_cost);
       cut_op = global_op;
     }
 
-    llvm::errs() << ">>>>>> number of attempts:" << i << ":\n";
-    llvm::errs() << ">>>>>> cut idx:" << idx << ":\n";
-    llvm::errs() << ">>>>>> left group:" << ":\n";
-    show_group(&left_sub_group);
-    llvm::errs() << ">>>>>> right group:" << ":\n";
-    show_group(&right_sub_group);
-    llvm::errs() << ">>>>>> global_op_cost: " << global_op_cost << " left_sub_group_cost: " << left_sub_group_cost <<" right_sub_group_cost: "<< right_sub_group_cost <<":\n";
-    llvm::errs() << ">>>>>> cut_group_cost:" << cut_group_cost <<":\n";
-    llvm::errs() << ">>>>>> original_group_cost:" << original_group_cost <<":\n";
+    lg_errs() << ">>>>>> number of attempts:" << i << ":\n";
+    lg_errs() << ">>>>>> cut idx:" << idx << ":\n";
+    lg_errs() << ">>>>>> left group:" << ":\n";
+    show_group(&cut_try.left_sub_group);
+    lg_errs() << ">>>>>> right group:" << ":\n";
+    show_group(&cut_try.right_sub_group);
+    lg_errs() << ">>>>>> global_op_cost: " << global_op_cost << " left_sub_group_cost: " << left_sub_group_cost <<" right_sub_group_cost: "<< right_sub_group_cost <<":\n";
+    lg_errs() << ">>>>>> cut_group_cost:" << cut_group_cost <<":\n";
+    lg_errs() << ">>>>>> original_group_cost:" << original_group_cost <<":\n";
   }
 
   return cut_op;
@@ -1790,18 +1986,43 @@ void GroupMethod::try_cut_some_group(LgPassIR *pass_ir, std::vector<std::vector<
     return;
   }
   int grp_num = base_groups.size();
-  LgInfo sub_group;
+  // search cuts of the groups in parallel, then apply them in order. Cutting
+  // one group only appends new groups, these are searched when reached.
+  int searched_num = grp_num;
+  std::vector<Operation *> cut_ops(searched_num, nullptr);
+  std::vector<std::string> cut_logs(searched_num);
+#pragma omp parallel for schedule(dynamic)
+  for (int64_t i = 0; i < searched_num; i++) {
+    if (base_groups[i].size() > 1) {
+      LgLogBuffer log_buffer;
+      LgInfo sub_group;
+      sub_group.group_id = i;
+      sub_group.group_ops.assign(base_groups[i].begin(), base_groups[i].end());
+      sub_group.update_group_io(LgPass::OPTIONS.opt);
+      set_group_type(sub_group);
+      cut_ops[i] = cut_this_group_is_better(&sub_group);
+      cut_logs[i] = log_buffer.take();
+    }
+  }
+
   for (int64_t i = 0; i < grp_num; i++) {
     if (base_groups[i].size() > 1) {
+      LgInfo sub_group;
       sub_group.group_id = i;
       sub_group.group_ops.assign(base_groups[i].begin(), base_groups[i].end());
       sub_group.update_group_io(LgPass::OPTIONS.opt);
       set_group_type(sub_group);
 
-      Operation* cut_op = cut_this_group_is_better(&sub_group);
+      Operation* cut_op = nullptr;
+      if (i < searched_num) {
+        lg_errs() << cut_logs[i];
+        cut_op = cut_ops[i];
+      } else {
+        cut_op = cut_this_group_is_better(&sub_group);
+      }
       if(cut_op)
       {
-        llvm::errs() << "find cut op!!"<<module::getName(cut_op).str()<<"\n";
+        lg_errs() << "find cut op!!"<<module::getName(cut_op).str()<<"\n";
         processWhenOpFail(pass_ir, sub_group, base_groups, grp_num, cut_op);
         show_group(&sub_group);
         for (auto it = base_groups[i].begin(); it != base_groups[i].end();) {
@@ -1829,7 +2050,7 @@ Operation* check_single_group_could_be_load(LgInfo &sub_group)
 
   // 判断切分后内存是否能加载
   if (!init_group_data_secs(sub_group, shape_secs, value_size)) {
-      llvm::errs() << "init_group_data_secs fail\n";
+      lg_errs() << "init_group_data_secs fail\n";
       return vec_op_hsecs[0].first;
     }
 
@@ -1837,7 +2058,7 @@ Operation* check_single_group_could_be_load(LgInfo &sub_group)
   TensorInfo tensor_infos;
   Operation *fail_op = nullptr;
   if (stripe_mine_idx_slice2(sub_group, shape_secs, tensor_infos, fail_op) == false) {
-      llvm::errs() << "stripe_mine_idx_slice2 fail, remove fail_op: "
+      lg_errs() << "stripe_mine_idx_slice2 fail, remove fail_op: "
                     << module::getName(fail_op).str() << "\n";
       return fail_op;
     }
@@ -2017,16 +2238,16 @@ void make_sure_enough_slice_for_multicore(LgPassIR *pass_ir, std::vector<std::ve
       std::vector<std::pair<Operation *, int>> vec_op_hsecs;
       shape_secs_t max_shape_secs = get_group_max_secs(sub_group, vec_op_hsecs);
       std::sort(vec_op_hsecs.begin(), vec_op_hsecs.end(),pair_op_int_Sort_by_int);
-      llvm::errs()<< "attention!!! sub_group op size:" << sub_group.group_ops.size() << "\n";
+      lg_errs()<< "attention!!! sub_group op size:" << sub_group.group_ops.size() << "\n";
 
       while(max_shape_secs.nsecs*max_shape_secs.hsecs < corenum){
-        llvm::errs()<< "max_shape_secs n:" << max_shape_secs.nsecs
+        lg_errs()<< "max_shape_secs n:" << max_shape_secs.nsecs
         << " c:" << max_shape_secs.csecs << " d:" << max_shape_secs.dsecs
         << " h:" << max_shape_secs.hsecs << " w:" << max_shape_secs.wsecs
         <<" corenum "<< corenum << "\n";
         // 删除h维度最小的算子
         Operation* fail_op = vec_op_hsecs[0].first;
-        llvm::errs() << module::getName(fail_op).str() << "  output h dim " << vec_op_hsecs[0].second <<" too small, delete it from group!\n";
+        lg_errs() << module::getName(fail_op).str() << "  output h dim " << vec_op_hsecs[0].second <<" too small, delete it from group!\n";
 
         processWhenOpFail(pass_ir, sub_group, base_groups, grp_num, fail_op);
         for (auto it = base_groups[i].begin(); it != base_groups[i].end();) {
@@ -2046,10 +2267,10 @@ void make_sure_enough_slice_for_multicore(LgPassIR *pass_ir, std::vector<std::ve
         if(vec_op_hsecs.size()==0){
           break;
         }
-        llvm::errs()<<"vec_op_hsecs.size() : "<<vec_op_hsecs.size()<<"\n";
+        lg_errs()<<"vec_op_hsecs.size() : "<<vec_op_hsecs.size()<<"\n";
         for(auto it:vec_op_hsecs)
         {
-          llvm::errs() << module::getName(it.first).str() << "\n";
+          lg_errs() << module::getName(it.first).str() << "\n";
         }
         // for debug
         std::sort(vec_op_hsecs.begin(), vec_op_hsecs.end(),pair_op_int_Sort_by_int);
@@ -2059,13 +2280,13 @@ void make_sure_enough_slice_for_multicore(LgPassIR *pass_ir, std::vector<std::ve
 }
 
 void GroupMethod::l2m_process(LgPassIR *pass_ir, int grp_idx, std::vector<std::pair<Value, int64_t>>& value_size) {
-  llvm::errs() << "process l2m...\n";
+  lg_errs() << "process l2m...\n";
   auto& grp_time_step = pass_ir->ILP_time_steps[grp_idx];
   auto& map_l2m_load = pass_ir->map_l2m_load[grp_idx];
   int ts_count = grp_time_step[0]->ts_count;
   int core_num_per_pipe0 = grp_time_step[0]->ncdhw_steps.size();
   for (auto itr : grp_time_step[0]->vec_l2m_value_info) {
-    llvm::errs() << "check Value:" << module::getName(itr.value).str()
+    lg_errs() << "check Value:" << module::getName(itr.value).str()
                   << ", slice_idx:" <<itr.slice_idx
                   << ", pipe0 load ts:" << itr.load_ts << "\n";
     int parallel_core_num = core_num_per_pipe0;
@@ -2075,7 +2296,7 @@ void GroupMethod::l2m_process(LgPassIR *pass_ir, int grp_idx, std::vector<std::p
       for (auto itr3 = grp_time_step[j]->vec_l2m_value_info.begin();
                 itr3 != grp_time_step[j]->vec_l2m_value_info.end(); ++itr3) {
         if (itr3->value == itr.value && itr3->slice_idx == itr.slice_idx) {
-          llvm::errs() << "find in pipe:" <<j<< ", load ts:" << itr3->load_ts << "\n";
+          lg_errs() << "find in pipe:" <<j<< ", load ts:" << itr3->load_ts << "\n";
           if (itr3->load_ts < min) {
             min = itr3->load_ts;
           }
@@ -2093,7 +2314,7 @@ void GroupMethod::l2m_process(LgPassIR *pass_ir, int grp_idx, std::vector<std::p
   for (int m = -1; m < ts_count; m++) {
     if (map_l2m_load.find(m) != map_l2m_load.end()) {
       for (auto itr: map_l2m_load[m]) {
-        llvm::errs() << " Value:" << module::getName(itr.value).str()
+        lg_errs() << " Value:" << module::getName(itr.value).str()
                     << " slice_idx:" << itr.slice_idx << " load ts:" << m<< " free ts:" << itr.free_ts << "\n";
       }
     }
@@ -2165,7 +2386,7 @@ void GroupMethod::l2m_process(LgPassIR *pass_ir, int grp_idx, std::vector<std::p
       }
     }
   } else {
-    llvm::errs() << "l2m enough \n";
+    lg_errs() << "l2m enough \n";
     for (auto it3: value_size) {
       value_l2m.push_back(it3.first);
       auto name = module::getName(it3.first).str();
@@ -2177,7 +2398,7 @@ void GroupMethod::l2m_process(LgPassIR *pass_ir, int grp_idx, std::vector<std::p
     if (map_l2m_load.find(m) != map_l2m_load.end()) {
       for (auto& itr: map_l2m_load[m]) {
         if (itr.slice_idx > 0 && std::find(value_l2m.begin(), value_l2m.end(), itr.value) != value_l2m.end()) {
-          llvm::errs() << "value:" << module::getName(itr.value).str() << ",set valid false\n";
+          lg_errs() << "value:" << module::getName(itr.value).str() << ",set valid false\n";
           itr.valid = false;
         }
       }
@@ -2209,7 +2430,7 @@ bool GroupMethod::is_same_pipeline(LgPassIR *pass_ir, int core_id, int grp_idx,
         }
       }
       if (all_slice_same) {
-        llvm::errs() << "core " << core_id << ",all slice shape same with pipeline " << n << ", skip ILP\n";
+        lg_errs() << "core " << core_id << ",all slice shape same with pipeline " << n << ", skip ILP\n";
         for (int m = 0; m < sec_per_cores[core_id]; m++) {
           std::vector<int64_t> ncdhw = vec_ncdhw[vec_ncdhw_idx + m];
           pass_ir->ILP_time_steps[grp_idx][n]->addSliceNcdhwSteps(core_id, ncdhw);
@@ -2230,14 +2451,14 @@ Operation* GroupMethod::ilp_for_single_group(LgPassIR *pass_ir, LgInfo &sub_grou
   shape_secs_t shape_secs;
   std::vector<std::pair<Value, int64_t>> value_size;
   init_group_data_secs(sub_group, shape_secs, value_size);
-  llvm::errs() << "init shape_secs, n:" << shape_secs.nsecs
+  lg_errs() << "init shape_secs, n:" << shape_secs.nsecs
                 << " c:" << shape_secs.csecs << " d:" << shape_secs.dsecs
                 << " h:" << shape_secs.hsecs << " w:" << shape_secs.wsecs <<'\n';
 
   if(core_num > 1){
     std::vector<std::pair<Operation *, int>> vec_op_hsecs_tmp;
     shape_secs_t max_shape_secs = get_group_max_secs(sub_group, vec_op_hsecs_tmp);
-    llvm::errs() << "max_shape_secs, n:" << max_shape_secs.nsecs
+    lg_errs() << "max_shape_secs, n:" << max_shape_secs.nsecs
               << " c:" << max_shape_secs.csecs << " d:" << max_shape_secs.dsecs
               << " h:" << max_shape_secs.hsecs << " w:" << max_shape_secs.wsecs <<'\n';
     int64_t secs = shape_secs.nsecs * shape_secs.csecs * shape_secs.dsecs * shape_secs.hsecs * shape_secs.wsecs;
@@ -2246,7 +2467,7 @@ Operation* GroupMethod::ilp_for_single_group(LgPassIR *pass_ir, LgInfo &sub_grou
     int new_secs = (secs + core_num - 1)/core_num*core_num;
     int sz = new_secs - secs;
     if (sz > 0) {
-      llvm::errs() <<"algin secs:"<<secs<<" to "<<new_secs<<"\n";
+      lg_errs() <<"algin secs:"<<secs<<" to "<<new_secs<<"\n";
 
       std::vector<int> vec_secs;
       std::vector<int> vec_dhw_secs;
@@ -2255,7 +2476,7 @@ Operation* GroupMethod::ilp_for_single_group(LgPassIR *pass_ir, LgInfo &sub_grou
         // update_shape_secs2(sub_group, shape_secs, dhw_secs, max_shape_secs);
         update_shape_secs_for_ilp_group(shape_secs, max_shape_secs);
 
-        llvm::errs() << "update shape shape_secs, n:" << shape_secs.nsecs
+        lg_errs() << "update shape shape_secs, n:" << shape_secs.nsecs
         << " c:" << shape_secs.csecs << " d:" << shape_secs.dsecs
         << " h:" << shape_secs.hsecs << " w:" << shape_secs.wsecs <<'\n';
 
@@ -2273,7 +2494,7 @@ Operation* GroupMethod::ilp_for_single_group(LgPassIR *pass_ir, LgInfo &sub_grou
         int pos = std::distance(vec_secs.begin(), it2);
         shape_secs = vec_shape_secs[pos];
         dhw_secs = vec_dhw_secs[pos];
-        llvm::errs() << "new shape_secs, n:" << shape_secs.nsecs
+        lg_errs() << "new shape_secs, n:" << shape_secs.nsecs
               << " c:" << shape_secs.csecs << " d:" << shape_secs.dsecs
               << " h:" << shape_secs.hsecs << " w:" << shape_secs.wsecs <<'\n';
       }
@@ -2288,20 +2509,20 @@ Operation* GroupMethod::ilp_for_single_group(LgPassIR *pass_ir, LgInfo &sub_grou
   bool ret = false;
   while (true) {
     if (++try_count > max_try_count) {
-      llvm::errs() <<"layer group fail\n";
+      lg_errs() <<"layer group fail\n";
       return fail_op;
     }
     int64_t secs = shape_secs.nsecs * shape_secs.csecs * shape_secs.dsecs * shape_secs.hsecs * shape_secs.wsecs;
     bool l2m_en = l2m_switch && secs > 1 && core_num > 1;
 
-    llvm::errs() << "shape_secs, n:" << shape_secs.nsecs
+    lg_errs() << "shape_secs, n:" << shape_secs.nsecs
                   << " c:" << shape_secs.csecs << " d:" << shape_secs.dsecs
                   << " h:" << shape_secs.hsecs << " w:" << shape_secs.wsecs
                   << " try_count:" << try_count<< " l2m_en:" << l2m_en << "\n";
 
     ret = stripe_mine_idx_slice2(sub_group, shape_secs, tensor_infos,fail_op);
     if(!ret){
-      llvm::errs() << module::getName(fail_op).str() << " stripe_mine_idx_slice2 fail"<<"\n";
+      lg_errs() << module::getName(fail_op).str() << " stripe_mine_idx_slice2 fail"<<"\n";
       return fail_op;
     }
     update_tensor_infos(sub_group, tensor_infos);
@@ -2340,7 +2561,7 @@ Operation* GroupMethod::ilp_for_single_group(LgPassIR *pass_ir, LgInfo &sub_grou
       while(sec_per_cores[core_id]-- > 0) {
         std::vector<int64_t> ncdhw = vec_ncdhw[vec_ncdhw_idx++];
         ilp_timeStep->addSliceNcdhwSteps(core_id, ncdhw);
-        llvm::errs() << "slice process, n:" << ncdhw[0]
+        lg_errs() << "slice process, n:" << ncdhw[0]
                       << " c:" << ncdhw[1] << " d:" << ncdhw[2]
                       << " h:" << ncdhw[3] << " w:" << ncdhw[4]<< " ncdhw_idx:" << vec_ncdhw_idx - 1 << "\n";
         ret = backward_gen_ilp_var2(
@@ -2349,7 +2570,7 @@ Operation* GroupMethod::ilp_for_single_group(LgPassIR *pass_ir, LgInfo &sub_grou
             pass_ir->returnOp, load_bytes_for_next_ts,
             tmp_value_size, fail_op, l2m_en, sec_per_cores[core_id] == 0, 4);
         if(!ret){
-          llvm::errs() <<"backward_gen_ilp_var2 fail" <<" core_id "<<core_id<<"\n";
+          lg_errs() <<"backward_gen_ilp_var2 fail" <<" core_id "<<core_id<<"\n";
           return fail_op;
         }
         slice_idx++;
@@ -2357,34 +2578,34 @@ Operation* GroupMethod::ilp_for_single_group(LgPassIR *pass_ir, LgInfo &sub_grou
 
       ret = ilp_timeStep->merge_small_cycle_op(tensor_infos);
       if (!ret) {
-        llvm::errs() << "ilp_timeStep->merge_small_cycle_op fail\n";
+        lg_errs() << "ilp_timeStep->merge_small_cycle_op fail\n";
         return fail_op;
       }
 
       ret = ilp_timeStep->prepare(tensor_infos);
       if (!ret) {
-        llvm::errs() << "ilp_timeStep->prepare fail\n";
+        lg_errs() << "ilp_timeStep->prepare fail\n";
         return fail_op;
       }
 
       ret = ilp_timeStep->run();
       if (!ret) {
-        llvm::errs() << "ilp_timeStep->run fail\n";
+        lg_errs() << "ilp_timeStep->run fail\n";
         return fail_op;
       }
 
       mem_alloc_status alloc_status;
       ret = ilp_timeStep->mem_alloc(alloc_status, tmp_value_size, tensor_infos);
       if (!ret) {
-        printf("ilp_timeStep->mem_alloc fail\n");
+        lg_errs() << "ilp_timeStep->mem_alloc fail\n";
         return fail_op;
       }
-      llvm::errs() << "grp" << grp_idx << ",core" << core_id << ", mem_alloc success\n";
+      lg_errs() << "grp" << grp_idx << ",core" << core_id << ", mem_alloc success\n";
       pass_ir->ILP_time_steps[grp_idx].emplace_back(ilp_timeStep);
     }
 
     if(ret){
-      llvm::errs() << "ilp_timeStep success\n";
+      lg_errs() << "ilp_timeStep success\n";
       if (l2m_en) {
         l2m_process(pass_ir, grp_idx, value_size);
       }
@@ -2431,13 +2652,13 @@ void GroupMethod::init_ilp_base_groups(LgPassIR* pass_ir, LgInfo& sub_group, std
                                                block_ops.end());
             first_group = false;
           } else {
-            llvm::errs() << "add new block_ops\n";
+            lg_errs() << "add new block_ops\n";
             pass_ir->tmp_base_groups.push_back(block_ops);
           }
         }
       }
       if (!have_valid_grp) {
-        llvm::errs() << "not have_valid_grp\n";
+        lg_errs() << "not have_valid_grp\n";
         pass_ir->tmp_base_groups[i].clear();
       }
     }
@@ -2462,8 +2683,21 @@ void GroupMethod::init_ilp_base_groups(LgPassIR* pass_ir, LgInfo& sub_group, std
 
 }
 
+// move the result of one group solved in ilp_ir to pass_ir as group grp_idx
+static void merge_ilp_pass_ir(LgPassIR *pass_ir, LgPassIR &ilp_ir,
+                              int grp_idx) {
+  pass_ir->ILP_time_steps[grp_idx] = std::move(ilp_ir.ILP_time_steps[0]);
+  pass_ir->map_l2m_load[grp_idx] = std::move(ilp_ir.map_l2m_load[0]);
+  for (auto &l2mem_alloc_ptr : ilp_ir.lg_l2mem_alloc_ptr) {
+    pass_ir->lg_l2mem_alloc_ptr.push_back(l2mem_alloc_ptr);
+  }
+  pass_ir->shape_secs.emplace_back(ilp_ir.shape_secs[0]);
+  pass_ir->lg_tensor_infos_.push_back(std::move(ilp_ir.lg_tensor_infos_[0]));
+  pass_ir->lg_infos.push_back(ilp_ir.lg_infos[0]);
+}
+
 void GroupMethod::ilp_layer_group(LgPassIR *pass_ir) {
-  llvm::errs() << "\n"
+  lg_errs() << "\n"
                << "=======================================================\n"
                << "*********** ilp_layer_group **********\n"
                << "=======================================================\n";
@@ -2500,21 +2734,67 @@ void GroupMethod::ilp_layer_group(LgPassIR *pass_ir) {
   int grp_idx = 0;
 
   std::cout<<"init grp_num is "<<grp_num<<std::endl;
+  // the first try of the groups are solved in parallel, each into its own
+  // LgPassIR and from a fresh LgInfo. Results and logs are merged in group
+  // order.
+  // Groups split out of failed ones are solved when reached.
+  int solved_num = grp_num;
+  std::vector<LgInfo> solved_groups(solved_num);
+  std::vector<std::shared_ptr<LgPassIR>> solved_irs(solved_num);
+  std::vector<Operation *> solved_fail_ops(solved_num, nullptr);
+  std::vector<std::string> solved_logs(solved_num);
+#pragma omp parallel for schedule(dynamic)
+  for (int64_t i = 0; i < solved_num; i++) {
+    if (base_groups[i].size() > 1) {
+      LgLogBuffer log_buffer;
+      auto &group = solved_groups[i];
+      group.group_id = i;
+      group.group_ops.assign(base_groups[i].begin(), base_groups[i].end());
+      group.update_group_io(LgPass::OPTIONS.opt);
+      set_group_type(group);
+      auto ilp_ir = std::make_shared<LgPassIR>();
+      ilp_ir->returnOp = pass_ir->returnOp;
+      ilp_ir->ILP_time_steps.push_back(std::vector<ILPTimeStepPtr>());
+      ilp_ir->map_l2m_load.push_back(
+          std::map<int, std::vector<l2m_value_info>>());
+      solved_fail_ops[i] = ilp_for_single_group(ilp_ir.get(), group, 0,
+                                                core_num, l2m_switch, train);
+      solved_irs[i] = ilp_ir;
+      solved_logs[i] = log_buffer.take();
+    }
+  }
+
   for (int64_t i = 0; i < grp_num; i++) {
     if (base_groups[i].size() > 1) {
+      // nothing of the previous group is carried over, as for the first tries
+      sub_group = LgInfo();
       sub_group.group_id = i;
       sub_group.group_ops.assign(base_groups[i].begin(), base_groups[i].end());
       sub_group.update_group_io(LgPass::OPTIONS.opt);
       set_group_type(sub_group);
-      llvm::errs() << ">>>>>> process group" << grp_idx << ":\n";
+      lg_errs() << ">>>>>> process group" << grp_idx << ":\n";
       show_group(&sub_group);
       sub_group.dump_lginfo();
 
       // deal single group until sucess or break all op into global op
+      bool first_try = i < solved_num;
       while(true){
-        Operation* fail_op = ilp_for_single_group(pass_ir, sub_group, grp_idx, core_num, l2m_switch, train);
+        Operation* fail_op = nullptr;
+        if (first_try) {
+          first_try = false;
+          sub_group = solved_groups[i];
+          fail_op = solved_fail_ops[i];
+          lg_errs() << solved_logs[i];
+          solved_logs[i].clear();
+          if (!fail_op) {
+            merge_ilp_pass_ir(pass_ir, *solved_irs[i], grp_idx);
+          }
+          solved_irs[i].reset();
+        } else {
+          fail_op = ilp_for_single_group(pass_ir, sub_group, grp_idx, core_num, l2m_switch, train);
+        }
         if(fail_op){
-          llvm::errs() <<"some op fail!!!" << "\n";
+          lg_errs() <<"some op fail!!!" << "\n";
           processWhenOpFail(pass_ir, sub_group, base_groups, grp_num, fail_op);
           for (auto it = base_groups[i].begin(); it != base_groups[i].end();) {
               if (std::find(sub_group.group_ops.begin(), sub_group.group_ops.end(), *it) == sub_group.group_ops.end()) {
@@ -2553,7 +2833,7 @@ void GroupMethod::ilp_layer_group(LgPassIR *pass_ir) {
 
   auto end = std::chrono::high_resolution_clock::now();
   auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-  llvm::errs() << "get ilp_layer_group time:" << elapsed.count() << "\n";
+  lg_errs() << "get ilp_layer_group time:" << elapsed.count() << "\n";
 }
 
 void GroupMethod::process(LgPassIR *pass_ir) {
@@ -2575,6 +2855,7 @@ void GroupMethod::process(LgPassIR *pass_ir) {
     simple_layer_group(lg_infos, subnet_ops);
     break;
   }
+  show_roofline_statistics();
 }
 
 void GroupMethod::get_final_groups(
@@ -2602,11 +2883,11 @@ void GroupMethod::get_final_groups(
 void GroupMethod::show_cut_results() {
   LLVM_DEBUG(for (size_t i = 0; i < cut_results_.size(); ++i) {
     auto &cut_result = cut_results_[i];
-    llvm::errs() << "base group[" << i << "] cut results: ";
+    lg_errs() << "base group[" << i << "] cut results: ";
     for (size_t j = 0; j < cut_result.size(); ++j) {
-      llvm::errs() << cut_result[j] << ", ";
+      lg_errs() << cut_result[j] << ", ";
     }
-    llvm::errs() << "\n";
+    lg_errs() << "\n";
   });
 }
 
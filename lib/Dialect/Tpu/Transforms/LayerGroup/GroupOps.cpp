@@ -617,8 +617,8 @@ void GroupOps::buildMlir_for_opt3() {
             if (it.var_value == 1) {
               auto itr = ILP_time_step->values_need_store_to_grpout.begin();
               for (;itr != ILP_time_step->values_need_store_to_grpout.end(); ++itr) {
-                // if (it.varName == itr->second) { //new edit
-                if (std::find(itr->second.begin(), itr->second.end(), it.varName) != itr->second.end()) {
+                // if (it.var_id == itr->second) { //new edit
+                if (std::find(itr->second.begin(), itr->second.end(), it.var_id) != itr->second.end()) {
                   tmp_need_store_load_value.push_back(itr->first);
                   if (map_store_tensor_to_outbuffer_out.find(itr->first) == map_store_tensor_to_outbuffer_out.end()) {
                     assert(itr->first == it.value);
@@ -647,7 +647,7 @@ void GroupOps::buildMlir_for_opt3() {
               if (it.info.mode2 & TIMESTEP2_STORE) {
                 LOG(INFO) <<"add into will_store_value for store, name:"<<out_name;
                 tmp_will_store_value.push_back(it.value);
-              } else if (it.info.mode2 & TIMESTEP2_STORE_AND_LOAD && ILP_time_step->mapILPVarInfo[it.varName].mode == 0) {
+              } else if (it.info.mode2 & TIMESTEP2_STORE_AND_LOAD && ILP_time_step->mapILPVarInfo[it.var_id].mode == 0) {
                 LOG(INFO) <<"add into will_store_value for store_and_load, name:"<<out_name;
                 tmp_will_store_value.push_back(it.value);
               }
@@ -857,7 +857,7 @@ void GroupOps::buildMlir_for_opt3() {
                 map_output_to_merge_slice[it.value].push_back(storeOp_out);
                 map_group_out_to_yield_in[it.value] = storeOp_out;
               } else if (it.info.mode2 & TIMESTEP2_STORE_AND_LOAD) {
-                if (ILP_time_step->mapILPVarInfo[it.varName].mode == 0) {
+                if (ILP_time_step->mapILPVarInfo[it.var_id].mode == 0) {
                   CreateStoreOp2(it.value, it.info, ts_id, it.slice_idx, pipe_id, lg_info.type, can_merge);
                 } else {
                   CreateLoadOp2(ts_id, it, pipe_id, ops, ncdhw_idx, lg_info.type, can_merge);
@@ -1400,7 +1400,7 @@ void GroupOps::CreateLoadOp2(int64_t ts, ts_var_t& ts_var, int64_t pipe_id,
     }
   }
 
-  std::string key = llvm::formatv("{0}_slice{1}", in_name, slice_idx).str();
+  lmem_key_t key(input, slice_idx);
   auto mem_s_addr = ILP_time_step->lmem_alloc_ptr->vec_mem_alloc_his[key].vec_reload_addr[0].second.addr;
   if (map_store_to_load_value.find(input) != map_store_to_load_value.end()) {
     mem_s_addr = ILP_time_step->lmem_alloc_ptr->vec_mem_alloc_his[key].vec_reload_addr[1].second.addr;
@@ -1461,7 +1461,7 @@ Value GroupOps::CreateStoreOp2(Value &output, tensor_info_t& ti, int64_t ts, int
   LOG(INFO) <<"sotre op output_name: " << name;
   // dot_graph_log->add_edge_into_subgraph(module::getName(new_value).str(), name);
 
-  std::string key = llvm::formatv("{0}_slice{1}", out_tensor_name, slice_idx).str();
+  lmem_key_t key(output, slice_idx);
   auto mem_s_addr = ILP_time_step->lmem_alloc_ptr->vec_mem_alloc_his[key].vec_reload_addr[0].second.addr;
   auto mem_s_size = ILP_time_step->lmem_alloc_ptr->vec_mem_alloc_his[key].size;
   attrs.push_back(builder.getNamedAttr(
@@ -1613,7 +1613,6 @@ void GroupOps::UpdateOpLgParam2(Operation *op, Operation *old_op, int64_t ts,  i
                               TensorInfo &tensor_info, std::vector<int64_t> ncdhw_idx, group_type_t group_type, bool can_merge) {
   auto builder = OpBuilder(ctx_);
   auto output = *old_op->getResults().begin();
-  std::string name = module::getName(output).str();
   auto &ti = tensor_info[output];
   if (version == 1) {
     int n = tensor_info[old_op->getResult(0)].slice_info.n[ncdhw_idx[0]].second;
@@ -1623,10 +1622,10 @@ void GroupOps::UpdateOpLgParam2(Operation *op, Operation *old_op, int64_t ts,  i
     auto out_type = RankedTensorType::get({n,c,h,w}, builder.getF32Type());
     op->getResult(0).setType(out_type); //todo maxpool indices,second output
   }
-  std::string key = llvm::formatv("{0}_slice{1}", name, slice_idx).str();
+  lmem_key_t key(output, slice_idx);
   auto mem_s_addr = ILP_time_step->lmem_alloc_ptr->vec_mem_alloc_his[key].vec_reload_addr[0].second.addr;
   auto mem_s_size = ILP_time_step->lmem_alloc_ptr->vec_mem_alloc_his[key].size;
-  std::string imm_key = llvm::formatv("{0}_buffer_slice{1}", name, slice_idx).str();
+  lmem_key_t imm_key(output, slice_idx, true);
   int imm_mem_s_addr = 0, imm_mem_s_size = 0;
   if (ILP_time_step->lmem_alloc_ptr->vec_mem_alloc_his.find(imm_key) != ILP_time_step->lmem_alloc_ptr->vec_mem_alloc_his.end()) {
     imm_mem_s_addr = ILP_time_step->lmem_alloc_ptr->vec_mem_alloc_his[imm_key].vec_reload_addr[0].second.addr;
@@ -10,15 +10,21 @@
 #include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/LayerGroupUtil.h"
 #include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/TimeStepMethod.h"
 #include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/IlpTimeStep.h"
+#include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/LgPass.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/FormatVariadic.h"
 #include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace tpu_mlir {
 namespace tpu {
 
 class AutoIndent {
 public:
-    static int indent;
+    // groups are solved in parallel, each thread logs its own indent
+    static thread_local int indent;
     AutoIndent() {
       indent++;
     }
@@ -27,9 +33,9 @@ public:
       indent--;
     }
 };
-int AutoIndent::indent = 0;
+thread_local int AutoIndent::indent = 0;
 
-bool SortByMemStruct(const std::pair<std::string, mem_struct> &v1, const std::pair<std::string, mem_struct> &v2)
+bool SortByMemStruct(const std::pair<lmem_key_t, mem_struct> &v1, const std::pair<lmem_key_t, mem_struct> &v2)
 {
     return v1.second.addr < v2.second.addr;//升序排列
 }
@@ -42,7 +48,7 @@ bool SortByMemSize(const mem_alloc_req_info &v1, const mem_alloc_req_info &v2)
 inline int64_t align(int64_t input, int64_t align_size)
 {
     if (input % align_size != 0) {
-      fprintf(stderr, "warning, input:%ld is not align %ld\n", input, align_size);
+      lg_errs() << llvm::format("warning, input:%ld is not align %ld\n", input, align_size);
     }
     return (int64_t)((input + align_size - 1)/align_size*align_size);
 }
@@ -51,6 +57,15 @@ inline std::string convert_name_to_key(const std::string& name, int slice_idx) {
   return llvm::formatv("{0}_slice{1}", name, slice_idx).str();
 }
 
+// only for log, the key of a free mem block in show_mem has no value
+std::string convert_key_to_name(const lmem_key_t& key) {
+  if (!key.value) {
+    return "free_mem " + std::to_string(key.slice_idx);
+  }
+  auto name = module::getName(key.value).str();
+  return convert_name_to_key(key.is_buffer ? name + "_buffer" : name, key.slice_idx);
+}
+
 bool is_range_overlap(int start1, int end1, int start2, int end2) {
   if (std::max(start1,start2) < std::min(end1, end2)) {
     return true;
@@ -106,7 +121,7 @@ bool l2mem_alloc::alloc(int slice_idx, const std::string& name, Value value, int
     for (int i = 0; i < size; i++) {
       lmem_buf[free_addr+i] = true;
     }
-    fprintf(stderr, "%s\n", llvm::formatv("        alloc ok for {0}, free_addr:{1}", name, free_addr).str().c_str());
+    lg_errs() << llvm::format("%s\n", llvm::formatv("        alloc ok for {0}, free_addr:{1}", name, free_addr).str().c_str());
     mem_struct mem_s;
     mem_s.addr = free_addr;
     mem_s.size = size;
@@ -134,7 +149,7 @@ bool l2mem_alloc::free(int slice_idx, const std::string& name) {
   std::string key = convert_name_to_key(name, slice_idx);
   if (mem_dict.find(key) != mem_dict.end()) {
     auto mem_s = mem_dict[key];
-    fprintf(stderr, "      free %s, addr:%d, size:%d\n", key.c_str(), mem_s.addr, mem_s.size);
+    lg_errs() << llvm::format("      free %s, addr:%d, size:%d\n", key.c_str(), mem_s.addr, mem_s.size);
     for (int i = 0; i < mem_s.size; i++) {
       assert(lmem_buf[mem_s.addr + i]);
       lmem_buf[mem_s.addr + i] = false;
@@ -153,7 +168,7 @@ void l2mem_alloc::clear() {
   vec_mem_alloc_his.clear();
 }
 
-lmem_alloc::lmem_alloc(std::map<std::string, std::vector<std::string>>& banked_tensors, ILPTimeStep* pILPTimeStep, int ts_count)
+lmem_alloc::lmem_alloc(std::map<Value, std::vector<Value>, value_compare>& banked_tensors, ILPTimeStep* pILPTimeStep, int ts_count)
 :banked_tensors_(banked_tensors), m_pILPTimeStep(pILPTimeStep) {
   total_size = 256*1024;
   lmem_buf = new bool[total_size];
@@ -173,7 +188,7 @@ lmem_alloc::~lmem_alloc() {
   delete []lmem_buf;
 }
 
-std::shared_ptr<std::vector<std::pair<std::string, mem_struct>>> lmem_alloc::show_mem(int& total_free_size, int& max_free_mem_idx, int& max_free_mem_size) {
+std::shared_ptr<std::vector<std::pair<lmem_key_t, mem_struct>>> lmem_alloc::show_mem(int& total_free_size, int& max_free_mem_idx, int& max_free_mem_size) {
   int free_start_addr = -1, free_count = 0, total_free_count = 0, start_bank = -1, end_bank = -1;
   for (int i = 0; i < total_size; i++) {
     if (!lmem_buf[i]) {
@@ -186,7 +201,7 @@ std::shared_ptr<std::vector<std::pair<std::string, mem_struct>>> lmem_alloc::sho
     } else {
       if (free_start_addr >= 0) {
         end_bank = (i - 1) / (total_size/16);
-        fprintf(stderr, "        >>>free_start_addr:%d, end_addr:%d, size:%d, start_bank:%d, end_bank:%d\n",
+        lg_errs() << llvm::format("        >>>free_start_addr:%d, end_addr:%d, size:%d, start_bank:%d, end_bank:%d\n",
               free_start_addr, free_start_addr + free_count - 1, free_count, start_bank, end_bank);
         free_start_addr = -1;
         free_count = 0;
@@ -194,20 +209,25 @@ std::shared_ptr<std::vector<std::pair<std::string, mem_struct>>> lmem_alloc::sho
     }
   }
   if (free_start_addr >= 0) {
-    fprintf(stderr, "        >>>free_start_addr:%d, end_addr:%d, size:%d, start_bank:%d, end_bank:15\n",
+    lg_errs() << llvm::format("        >>>free_start_addr:%d, end_addr:%d, size:%d, start_bank:%d, end_bank:15\n",
           free_start_addr, free_start_addr + free_count - 1, free_count, start_bank);
   }
-  fprintf(stderr, "        >>>total_free_count:%d\n", total_free_count);
+  lg_errs() << llvm::format("        >>>total_free_count:%d\n", total_free_count);
 
-  std::vector<std::pair<std::string, mem_struct>> vec_mem_struct;
-  fprintf(stderr, "        >>>mem_dict:\n");
+  bool detail_log = m_pILPTimeStep->detail_log;
+  std::vector<std::pair<lmem_key_t, mem_struct>> vec_mem_struct;
+  if (detail_log) {
+    lg_errs() << "        >>>mem_dict:\n";
+  }
   for (auto itr = mem_dict.begin(); itr != mem_dict.end(); ++itr) {
-    vec_mem_struct.push_back(std::make_pair(itr->first.c_str(), itr->second));
-    fprintf(stderr, "        name:%s, addr:%d, size:%d\n", itr->first.c_str(), itr->second.addr, itr->second.size);
+    vec_mem_struct.push_back(std::make_pair(itr->first, itr->second));
+    if (detail_log) {
+      lg_errs() << llvm::format("        name:%s, addr:%d, size:%d\n", convert_key_to_name(itr->first).c_str(), itr->second.addr, itr->second.size);
+    }
   }
   std::sort(vec_mem_struct.begin(), vec_mem_struct.end(), SortByMemStruct);
   int pre_s_addr = 0, free_mem_idx = 0;
-  auto vec_mem_struct2 = std::make_shared<std::vector<std::pair<std::string, mem_struct>>>();
+  auto vec_mem_struct2 = std::make_shared<std::vector<std::pair<lmem_key_t, mem_struct>>>();
   int idx = 0;
   max_free_mem_idx = 0;
   max_free_mem_size = 0;
@@ -224,7 +244,7 @@ std::shared_ptr<std::vector<std::pair<std::string, mem_struct>>> lmem_alloc::sho
       }
       total_free_size += mem_s.size;
       mem_s.type = 1;
-      vec_mem_struct2->push_back(std::make_pair("free_mem "+std::to_string(free_mem_idx++), mem_s));
+      vec_mem_struct2->push_back(std::make_pair(lmem_key_t(Value(), free_mem_idx++), mem_s));
       idx++;
     }
     // itr.second.type = 0;
@@ -243,38 +263,44 @@ std::shared_ptr<std::vector<std::pair<std::string, mem_struct>>> lmem_alloc::sho
     }
     total_free_size += mem_s.size;
     mem_s.type = 1;
-    vec_mem_struct2->push_back(std::make_pair("free_mem "+std::to_string(free_mem_idx++), mem_s));
-  }
-  fprintf(stderr, "        >>>mem_dict:\n");
-  int idx2 = 0;
-  for (auto itr: *vec_mem_struct2) {
-    start_bank = itr.second.addr / (total_size/16);
-    int e_addr = itr.second.addr + itr.second.size - 1;
-    end_bank = e_addr / (total_size/16);
-    fprintf(stderr, "           idx:%3d, key:%40s, s_addr:%8d, e_addr:%8d, size:%8d, bank_id:%d, type:%d, start_bank:%d, end_bank:%d\n",
-      idx2++, itr.first.c_str(), itr.second.addr, e_addr, itr.second.size,
-      itr.second.bank_id.size() > 0?itr.second.bank_id[0]:-1, itr.second.type, start_bank, end_bank);
-  }
-  fprintf(stderr, "max_free_mem_idx:%d, max_free_mem_size:%d\n", max_free_mem_idx, max_free_mem_size);
+    vec_mem_struct2->push_back(std::make_pair(lmem_key_t(Value(), free_mem_idx++), mem_s));
+  }
+  if (detail_log) {
+    lg_errs() << "        >>>mem_dict:\n";
+    int idx2 = 0;
+    for (auto itr: *vec_mem_struct2) {
+      start_bank = itr.second.addr / (total_size/16);
+      int e_addr = itr.second.addr + itr.second.size - 1;
+      end_bank = e_addr / (total_size/16);
+      lg_errs() << llvm::format("           idx:%3d, key:%40s, s_addr:%8d, e_addr:%8d, size:%8d, bank_id:%d, type:%d, start_bank:%d, end_bank:%d\n",
+        idx2++, convert_key_to_name(itr.first).c_str(), itr.second.addr, e_addr, itr.second.size,
+        itr.second.bank_id.size() > 0?itr.second.bank_id[0]:-1, itr.second.type, start_bank, end_bank);
+    }
+  }
+  lg_errs() << llvm::format("max_free_mem_idx:%d, max_free_mem_size:%d\n", max_free_mem_idx, max_free_mem_size);
   return std::move(vec_mem_struct2);
 }
 
-bool lmem_alloc::_alloc(int slice_idx, const std::string& name, Value value, int size, std::vector<int>& ret_bank_id,
+bool lmem_alloc::_alloc(const lmem_key_t& key, Value value, int size, std::vector<int>& ret_bank_id,
                         int& free_addr, int& confict_size, bool force_not_care_bank) {
-  // std::string key = llvm::formatv("{0}_slice{1}", name, slice_idx).str();
   // if (mem_dict.find(key) != mem_dict.end()){
   //   return true;
   // }
 
+  bool detail_log = m_pILPTimeStep->detail_log;
+  int slice_idx = key.slice_idx;
   std::vector<int> vec_bank_id, all_conf_bank_id;
   bool care_bank = false;
-  if (!force_not_care_bank) {
-    for (auto it: banked_tensors_[name]) {
-      std::string key = convert_name_to_key(it, slice_idx);
-      std::vector<int> bank_id = get_bank(key);
+  auto banked = banked_tensors_.find(key.value);
+  if (!force_not_care_bank && !key.is_buffer && banked != banked_tensors_.end()) {
+    for (auto it: banked->second) {
+      lmem_key_t banked_key(it, slice_idx);
+      std::vector<int> bank_id = get_bank(banked_key);
       all_conf_bank_id.insert(all_conf_bank_id.end(), bank_id.begin(), bank_id.end());
       if (bank_id.size() > 0) {
-        fprintf(stderr, "        confict to %s, bank_id:%s\n", key.c_str(), vector_to_string(bank_id).c_str());
+        if (detail_log) {
+          lg_errs() << llvm::format("        confict to %s, bank_id:%s\n", convert_key_to_name(banked_key).c_str(), vector_to_string(bank_id).c_str());
+        }
         vec_bank_id.insert(vec_bank_id.end(), bank_id.begin(), bank_id.end());
         care_bank = true;
       }
@@ -295,7 +321,7 @@ bool lmem_alloc::_alloc(int slice_idx, const std::string& name, Value value, int
           }
       }
       if (bidx == -1) {
-        fprintf(stderr, "warning: not find valid bank, force no bank\n");
+        lg_errs() << "warning: not find valid bank, force no bank\n";
         care_bank = false;
       }
     }
@@ -344,7 +370,7 @@ bool lmem_alloc::_alloc(int slice_idx, const std::string& name, Value value, int
       confict_size = 0;
       for (auto itr: bank_size) {
         if ((std::find(all_conf_bank_id.begin(), all_conf_bank_id.end(), itr.first) != all_conf_bank_id.end())) {
-          fprintf(stderr, "          bank%d confilct size:%d\n", itr.first, itr.second);
+          lg_errs() << llvm::format("          bank%d confilct size:%d\n", itr.first, itr.second);
           confict_size += itr.second;
         }
       }
@@ -353,7 +379,9 @@ bool lmem_alloc::_alloc(int slice_idx, const std::string& name, Value value, int
         lmem_buf[free_addr+i] = true;
       }
 
-      fprintf(stderr, "%s\n", llvm::formatv("        alloc ok for {0}, free_addr:{1}, bank_id:{2}", name, free_addr, vector_to_string(ret_bank_id)).str().c_str());
+      if (detail_log) {
+        lg_errs() << llvm::format("%s\n", llvm::formatv("        alloc ok for {0}, free_addr:{1}, bank_id:{2}", convert_key_to_name(key), free_addr, vector_to_string(ret_bank_id)).str().c_str());
+      }
       mem_struct mem_s;
       mem_s.addr = free_addr;
       mem_s.bank_id.assign(ret_bank_id.begin(), ret_bank_id.end());
@@ -361,7 +389,6 @@ bool lmem_alloc::_alloc(int slice_idx, const std::string& name, Value value, int
       mem_s.value = value;
       mem_s.slice_idx = slice_idx;
       mem_s.type = 0;
-      std::string key = convert_name_to_key(name, slice_idx);
       mem_dict[key] = mem_s;
       if (!rehearsal) {
         reload_mem_struct tmp_mem_s;
@@ -393,15 +420,17 @@ bool lmem_alloc::alloc_multi(int ts_idx, std::vector<mem_alloc_req_info>& vec_me
   int total_confict_size = 0, confict_size = 0, idx = 0, free_addr = -1;
   std::vector<int> new_vec_move_mem_min, ret_bank_id;
   if (sort_by_size) {
-    fprintf(stderr, "    alloc_multi sort_by_size\n");
+    lg_errs() << "    alloc_multi sort_by_size\n";
     std::sort(vec_mem_req.begin(), vec_mem_req.end(), SortByMemSize);
-    for (auto it : vec_mem_req) {
-      fprintf(stderr, "      name:%s, size:%d\n", it.name.c_str(), it.size);
+    if (m_pILPTimeStep->detail_log) {
+      for (auto it : vec_mem_req) {
+        lg_errs() << llvm::format("      name:%s, size:%d\n", convert_key_to_name(it.key).c_str(), it.size);
+      }
+      lg_errs() << "\n";
     }
-    fprintf(stderr, "\n");
     for (auto it : vec_mem_req) {
-      if (!alloc(ts_idx, it.slice_idx, it.name, it.value, it.size)) {
-        fprintf(stderr, "_alloc fail\n");
+      if (!alloc(ts_idx, it.key, it.value, it.size)) {
+        lg_errs() << "_alloc fail\n";
         return false;
       }
     }
@@ -416,21 +445,21 @@ bool lmem_alloc::alloc_multi(int ts_idx, std::vector<mem_alloc_req_info>& vec_me
   int min_confict_size = total_size;
 
   do {
-    fprintf(stderr, "\ntest permutation:%d\n", idx);
+    lg_errs() << llvm::format("\ntest permutation:%d\n", idx);
     for (auto i: new_vec_move_mem) {
-      free(convert_name_to_key(vec_mem_req[i].name, vec_mem_req[i].slice_idx));
+      free(vec_mem_req[i].key);
     }
     total_confict_size = 0;
     bool success = true;
     for (int i : new_vec_move_mem) {
-      fprintf(stderr, "  alloc i:%d tensor\n", i);
-      if (!_alloc(vec_mem_req[i].slice_idx, vec_mem_req[i].name, vec_mem_req[i].value, vec_mem_req[i].size,
+      lg_errs() << llvm::format("  alloc i:%d tensor\n", i);
+      if (!_alloc(vec_mem_req[i].key, vec_mem_req[i].value, vec_mem_req[i].size,
                   ret_bank_id, free_addr, confict_size)) {
-        fprintf(stderr, "_alloc fail\n");
+        lg_errs() << "_alloc fail\n";
         success = false;
         break;
       }
-      fprintf(stderr, "  free_addr:%d, confict_size:%d\n", free_addr, confict_size);
+      lg_errs() << llvm::format("  free_addr:%d, confict_size:%d\n", free_addr, confict_size);
       total_confict_size += confict_size;
     }
 
@@ -438,7 +467,7 @@ bool lmem_alloc::alloc_multi(int ts_idx, std::vector<mem_alloc_req_info>& vec_me
       min_confict_size = total_confict_size;
       new_vec_move_mem_min.assign(new_vec_move_mem.begin(), new_vec_move_mem.end());
       if (total_confict_size == 0) {
-        fprintf(stderr, "   no confilct\n");
+        lg_errs() << "   no confilct\n";
         break;
       }
     }
@@ -448,39 +477,42 @@ bool lmem_alloc::alloc_multi(int ts_idx, std::vector<mem_alloc_req_info>& vec_me
   rehearsal = false;
   total_confict_size = 0;
   std::map<int, int> new_vec_move_mem_new_addr;
-  fprintf(stderr, "actually alloc the moved tensor again:\n");
+  lg_errs() << "actually alloc the moved tensor again:\n";
   for (auto i: new_vec_move_mem) {
-    free(convert_name_to_key(vec_mem_req[i].name, vec_mem_req[i].slice_idx));
+    free(vec_mem_req[i].key);
   }
   for (int i : new_vec_move_mem_min) {
-    fprintf(stderr, "  i:%d\n", i);
-    if (!_alloc(vec_mem_req[i].slice_idx, vec_mem_req[i].name, vec_mem_req[i].value, vec_mem_req[i].size,
+    lg_errs() << llvm::format("  i:%d\n", i);
+    if (!_alloc(vec_mem_req[i].key, vec_mem_req[i].value, vec_mem_req[i].size,
                   ret_bank_id, free_addr, confict_size)) {
-      fprintf(stderr, "_alloc fail\n");
+      lg_errs() << "_alloc fail\n";
       return false;
     }
-    fprintf(stderr, "  confict_size:%d\n", confict_size);
+    lg_errs() << llvm::format("  confict_size:%d\n", confict_size);
     total_confict_size += confict_size;
   }
-  fprintf(stderr, "  total_confict_size:%d, min_confict_size:%d\n",total_confict_size, min_confict_size);
+  lg_errs() << llvm::format("  total_confict_size:%d, min_confict_size:%d\n",total_confict_size, min_confict_size);
   assert(total_confict_size == min_confict_size);
   return true;
 }
 
 
 //refc：暂时只使用默认值1，考虑弃用
-bool lmem_alloc::alloc(int ts_idx, int slice_idx, const std::string& name, Value value, int size) {
-  fprintf(stderr, "%s\n", llvm::formatv("      start alloc for {0}, size:{1}, slice_idx:{2}", name, size, slice_idx).str().c_str());
+bool lmem_alloc::alloc(int ts_idx, const lmem_key_t& key, Value value, int size) {
+  bool detail_log = m_pILPTimeStep->detail_log;
+  if (detail_log) {
+    lg_errs() << llvm::format("%s\n", llvm::formatv("      start alloc for {0}, size:{1}, slice_idx:{2}", convert_key_to_name(key), size, key.slice_idx).str().c_str());
+  }
   assert(size > 0);
   int free_addr = -1, confict_size = -1;
   std::vector<int> ret_bank_id;
-  if (!_alloc(slice_idx, name, value, size, ret_bank_id, free_addr, confict_size)) {
-    fprintf(stderr, "      alloc fail, current mem status:\n");
+  if (!_alloc(key, value, size, ret_bank_id, free_addr, confict_size)) {
+    lg_errs() << "      alloc fail, current mem status:\n";
     // return false;
     int total_free_size = 0, max_free_mem_idx = 0, max_free_mem_size = 0;
     auto vec_mem_struct2 = *show_mem(total_free_size, max_free_mem_idx, max_free_mem_size);
     if (total_free_size < size) {
-      fprintf(stderr, "error! alloc total_free_size < size\n");
+      lg_errs() << "error! alloc total_free_size < size\n";
       return false;
     }
 
@@ -561,13 +593,13 @@ bool lmem_alloc::alloc(int ts_idx, int slice_idx, const std::string& name, Value
       }
     }
     if (tmp_size - align_num < size) {
-      fprintf(stderr, "error! can not find enough free mem block\n");
+      lg_errs() << "error! can not find enough free mem block\n";
       return false;
     }
     int min = 10000, max = -1;
-    fprintf(stderr, "vec_merge_mem:\n");
+    lg_errs() << "vec_merge_mem:\n";
     for (auto i: vec_merge_mem) {
-      fprintf(stderr, "  i:%d\n", i);
+      lg_errs() << llvm::format("  i:%d\n", i);
       if (i < min) {
         min = i;
       }
@@ -580,7 +612,7 @@ bool lmem_alloc::alloc(int ts_idx, int slice_idx, const std::string& name, Value
     std::map<int, int> new_vec_move_mem_old_addr;
     std::map<int, int> new_vec_move_size;
     std::map<int, int> new_vec_slice_idx;
-    fprintf(stderr, "vec_move_mem:\n");
+    lg_errs() << "vec_move_mem:\n";
     for (auto i: vec_move_mem) {
       if (i > min && i < max) { //只对最上和最下空闲区域间的tensor进行移动
         new_vec_move_mem.push_back(i);
@@ -588,7 +620,7 @@ bool lmem_alloc::alloc(int ts_idx, int slice_idx, const std::string& name, Value
         new_vec_move_size[i] =vec_mem_struct2[i].second.size;
         new_vec_move_value[i] = vec_mem_struct2[i].second.value;
         new_vec_slice_idx[i] = vec_mem_struct2[i].second.slice_idx;
-        fprintf(stderr, "  i:%d\n", i);
+        lg_errs() << llvm::format("  i:%d\n", i);
       }
     }
 
@@ -606,12 +638,12 @@ bool lmem_alloc::alloc(int ts_idx, int slice_idx, const std::string& name, Value
       }
 
       do {
-        fprintf(stderr, "\ntest permutation:%d\n", idx);
+        lg_errs() << llvm::format("\ntest permutation:%d\n", idx);
         for (auto i: new_vec_move_mem) {
           if (i != -1)
               free(vec_mem_struct2[i].first);
           else
-              free(convert_name_to_key(name, slice_idx));
+              free(key);
         }
         int unused;
         // (void)lmem_alloc_ptr->show_mem(unused, unused, unused);
@@ -620,10 +652,10 @@ bool lmem_alloc::alloc(int ts_idx, int slice_idx, const std::string& name, Value
         bool success = true;
         for (int it : order_idx) {
           auto i = new_vec_move_mem[it];
-          fprintf(stderr, "  start alloc %dth tensor\n", i);
+          lg_errs() << llvm::format("  start alloc %dth tensor\n", i);
           if (i == -1) {
-            if (!_alloc(slice_idx, name, value, size, ret_bank_id, free_addr, confict_size, force_not_care_bank)) {
-              fprintf(stderr, "_alloc fail 1\n");
+            if (!_alloc(key, value, size, ret_bank_id, free_addr, confict_size, force_not_care_bank)) {
+              lg_errs() << "_alloc fail 1\n";
               int unused;
               // (void)lmem_alloc_ptr->show_mem(unused, unused, unused);
               show_mem(unused, unused, unused);
@@ -632,9 +664,8 @@ bool lmem_alloc::alloc(int ts_idx, int slice_idx, const std::string& name, Value
             }
           } else {
             auto mem_s = vec_mem_struct2[i].second;
-            auto name = module::getName(vec_mem_struct2[i].second.value).str();
-            if (!_alloc(mem_s.slice_idx, name, mem_s.value, mem_s.size, ret_bank_id, free_addr, confict_size, force_not_care_bank)) {
-              fprintf(stderr, "_alloc fail 2\n");
+            if (!_alloc(vec_mem_struct2[i].first, mem_s.value, mem_s.size, ret_bank_id, free_addr, confict_size, force_not_care_bank)) {
+              lg_errs() << "_alloc fail 2\n";
               int unused;
               // (void)lmem_alloc_ptr->show_mem(unused, unused, unused);
               show_mem(unused, unused, unused);
@@ -642,14 +673,14 @@ bool lmem_alloc::alloc(int ts_idx, int slice_idx, const std::string& name, Value
               break;
             }
           }
-          fprintf(stderr, "  free_addr:%d, confict_size:%d\n", free_addr, confict_size);
+          lg_errs() << llvm::format("  free_addr:%d, confict_size:%d\n", free_addr, confict_size);
           total_confict_size += confict_size;
         }
         if (success && total_confict_size < min_confict_size) {
           min_confict_size = total_confict_size;
           new_vec_move_mem_min.assign(order_idx.begin(), order_idx.end());
           if (total_confict_size == 0) {
-            fprintf(stderr, "   no confilct\n");
+            lg_errs() << "   no confilct\n";
             break;
           }
         }
@@ -659,38 +690,37 @@ bool lmem_alloc::alloc(int ts_idx, int slice_idx, const std::string& name, Value
         break;
       }
       force_not_care_bank = true;
-      fprintf(stderr, "   enable force_not_care_bank\n");
+      lg_errs() << "   enable force_not_care_bank\n";
     }
 
     rehearsal = false;
     total_confict_size = 0;
     std::map<int, int> new_vec_move_mem_new_addr;
-    fprintf(stderr, "actually alloc the moved tensor again:\n");
+    lg_errs() << "actually alloc the moved tensor again:\n";
     for (auto i: new_vec_move_mem) {
       if (i != -1)
           free(vec_mem_struct2[i].first);
       else
-          free(convert_name_to_key(name, slice_idx));
+          free(key);
     }
     for (int it : new_vec_move_mem_min) {
       auto i = new_vec_move_mem[it];
-      fprintf(stderr, "  i:%d\n", i);
+      lg_errs() << llvm::format("  i:%d\n", i);
       if (i == -1) {
-        if (!_alloc(slice_idx, name, value, size, ret_bank_id, free_addr, confict_size, force_not_care_bank)) {
+        if (!_alloc(key, value, size, ret_bank_id, free_addr, confict_size, force_not_care_bank)) {
           return false;
         }
       } else {
-        auto op_name = module::getName(vec_mem_struct2[i].second.value).str();
         auto mem_s = vec_mem_struct2[i].second;
-        if (!_alloc(mem_s.slice_idx, op_name, mem_s.value, mem_s.size, ret_bank_id, free_addr, confict_size, force_not_care_bank)) {
+        if (!_alloc(vec_mem_struct2[i].first, mem_s.value, mem_s.size, ret_bank_id, free_addr, confict_size, force_not_care_bank)) {
           return false;
         }
         new_vec_move_mem_new_addr[i] = free_addr;
       }
-      fprintf(stderr, "  confict_size:%d\n", confict_size);
+      lg_errs() << llvm::format("  confict_size:%d\n", confict_size);
       total_confict_size += confict_size;
     }
-    fprintf(stderr, "  total_confict_size:%d, min_confict_size:%d\n",total_confict_size, min_confict_size);
+    lg_errs() << llvm::format("  total_confict_size:%d, min_confict_size:%d\n",total_confict_size, min_confict_size);
     assert(total_confict_size == min_confict_size);
     ts_move_info tmp;
     for (int it : new_vec_move_mem_min) {
@@ -705,15 +735,20 @@ bool lmem_alloc::alloc(int ts_idx, int slice_idx, const std::string& name, Value
     }
     tmp.name = "lmem_tensor_move_at_ts"+std::to_string(ts_idx);
     m_pILPTimeStep->inserted_timestep_table_[ts_idx] = tmp;
-    fprintf(stderr, "%s\n", llvm::formatv("      alloc ok for {0}, size:{1}",
-                                  name, size).str().c_str());
+    if (detail_log) {
+      lg_errs() << llvm::format("%s\n", llvm::formatv("      alloc ok for {0}, size:{1}",
+                                    convert_key_to_name(key), size).str().c_str());
+    }
   }
 
   return true;
 }
 
-bool lmem_alloc::alloc2(int ts_idx, int slice_idx, const std::string& name, Value value, int addr, int size) {
-  fprintf(stderr, "%s\n", llvm::formatv("      start alloc for {0}, size:{1}, slice_idx:{2}, addr:{3}", name, size, slice_idx, addr).str().c_str());
+bool lmem_alloc::alloc2(int ts_idx, const lmem_key_t& key, Value value, int addr, int size) {
+  int slice_idx = key.slice_idx;
+  if (m_pILPTimeStep->detail_log) {
+    lg_errs() << llvm::format("%s\n", llvm::formatv("      start alloc for {0}, size:{1}, slice_idx:{2}, addr:{3}", convert_key_to_name(key), size, slice_idx, addr).str().c_str());
+  }
   int bidx = addr / (total_size/16);
   int end_bidx = (addr + size - 1) / (total_size/16);
   std::vector<int> tmp_bank_id;
@@ -734,7 +769,6 @@ bool lmem_alloc::alloc2(int ts_idx, int slice_idx, const std::string& name, Valu
   mem_s.value = value;
   mem_s.slice_idx = slice_idx;
   mem_s.type = 2;
-  std::string key = convert_name_to_key(name, slice_idx);
   mem_dict[key] = mem_s;
 
   his_mem_struct his_mem_s;
@@ -748,10 +782,12 @@ bool lmem_alloc::alloc2(int ts_idx, int slice_idx, const std::string& name, Valu
 }
 
 
-bool lmem_alloc::free(const std::string& key, std::vector<std::pair<int,int>>* vec_pre_ts_free_mem) {
+bool lmem_alloc::free(const lmem_key_t& key, std::vector<std::pair<int,int>>* vec_pre_ts_free_mem) {
   if (mem_dict.find(key) != mem_dict.end()) {
     auto mem_s = mem_dict[key];
-    fprintf(stderr, "      free %s, addr:%d, size:%d\n", key.c_str(), mem_s.addr, mem_s.size);
+    if (m_pILPTimeStep->detail_log) {
+      lg_errs() << llvm::format("      free %s, addr:%d, size:%d\n", convert_key_to_name(key).c_str(), mem_s.addr, mem_s.size);
+    }
     for (int i = 0; i < mem_s.size; i++) {
       assert(lmem_buf[mem_s.addr + i]);
       lmem_buf[mem_s.addr + i] = false;
@@ -765,7 +801,7 @@ bool lmem_alloc::free(const std::string& key, std::vector<std::pair<int,int>>* v
   return false;
 }
 
-bool lmem_alloc::get_mem_struct(const std::string& key, mem_struct& mem_s) {
+bool lmem_alloc::get_mem_struct(const lmem_key_t& key, mem_struct& mem_s) {
   if (mem_dict.find(key) != mem_dict.end()) {
     mem_s = mem_dict[key];
     return true;
@@ -773,9 +809,9 @@ bool lmem_alloc::get_mem_struct(const std::string& key, mem_struct& mem_s) {
   return false;
 }
 
-std::vector<int> lmem_alloc::get_bank(const std::string& name) {
+std::vector<int> lmem_alloc::get_bank(const lmem_key_t& key) {
   std::vector<int> tmp;
-  auto iter = mem_dict.find(name);
+  auto iter = mem_dict.find(key);
   if (iter != mem_dict.end()) {
     auto bank_id = iter->second.bank_id;
     tmp.assign(bank_id.begin(), bank_id.end());
@@ -788,15 +824,15 @@ ILPTimeStep::ILPTimeStep(const LgInfo& group_info, int sec_per_core)
   :_group_info(group_info), solver(MPSolver::CreateSolver("SCIP")) {
  // Create the mip solver with the SCIP backend.
   if (!solver) {
-    llvm::errs() << "SCIP solver unavailable.\n";;
+    lg_errs() << "SCIP solver unavailable.\n";;
   }
   ts_count = sec_per_core*_group_info.group_ops.size() + 2;
   slice_num = sec_per_core;
   for(int i = 0; i < ts_count; i++) {
-    cycle_contrains.push_back(std::vector<std::pair<int, std::string>>());
+    cycle_contrains.push_back(std::vector<std::pair<int, int>>());
   }
   for(int i = 0; i < ts_count; i++) {
-    mem_contrains.push_back(std::vector<std::pair<int, std::string>>());
+    mem_contrains.push_back(std::vector<std::pair<int, int>>());
   }
   for(int i = 0; i < ts_count; i++) {
     timestep_table_.push_back(TimestepRow2());
@@ -813,20 +849,25 @@ ILPTimeStep::~ILPTimeStep()
 {
 }
 
-void ILPTimeStep::addValueInfo(int slice_idx, Value value, std::string varName) {
+void ILPTimeStep::addValueInfo(int slice_idx, Value value, int var_id) {
   if (mapValueInfo.find(value) == mapValueInfo.end()) {
-    std::map<int, std::vector<std::string>> tmp;
+    std::map<int, std::vector<int>> tmp;
     mapValueInfo[value] = tmp;
   } else {
     if (mapValueInfo[value].find(slice_idx) == mapValueInfo[value].end()) {
-      std::vector<std::string> tmp;
+      std::vector<int> tmp;
       mapValueInfo[value][slice_idx] = tmp;
     }
   }
-  mapValueInfo[value][slice_idx].push_back(varName); //确保时隙后面的变量放在最后面
+  mapValueInfo[value][slice_idx].push_back(var_id); //确保时隙后面的变量放在最后面
+}
+
+int ILPTimeStep::addVarInfo(const ilp_var_info& var_info) {
+  mapILPVarInfo.push_back(var_info);
+  return mapILPVarInfo.size() - 1;
 }
 
-void ILPTimeStep::addBinaryVar(int ts_idx, int slice_idx, int mode, std::string varName, Value value, tensor_info_t& info, int64_t lmem_bytes) {
+int ILPTimeStep::addBinaryVar(int ts_idx, int slice_idx, int mode, const std::string& varName, Value value, tensor_info_t& info, int64_t lmem_bytes) {
   assert(solver != nullptr);
   MPVariable* x = solver->MakeIntVar(0, 1, varName);
   ilp_var_info var_info;
@@ -835,16 +876,17 @@ void ILPTimeStep::addBinaryVar(int ts_idx, int slice_idx, int mode, std::string
   var_info.mode = mode;
   var_info.ilp_var = x;
   var_info.tensor_info = info;
-  mapILPVarInfo[varName] = var_info;
+  int var_id = addVarInfo(var_info);
 
   ts_var_t tmp;
-  tmp.varName = varName;
+  tmp.var_id = var_id;
   tmp.value = value;
   tmp.info = info;
   tmp.lmem_bytes = align(lmem_bytes, 64);
   tmp.slice_idx = slice_idx;
   timestep_table_[ts_idx].vec_ts_var.push_back(tmp);
-  addValueInfo(slice_idx, value, varName);
+  addValueInfo(slice_idx, value, var_id);
+  return var_id;
 }
 
 void ILPTimeStep::addTensorSize(int ts_idx, Value value, int lmem_size) {
@@ -857,9 +899,9 @@ void ILPTimeStep::addTensorCycle(int ts_idx, Value value, int cycle) {
   timestep_table_[ts_idx].vec_op_infos[0].load_tensor_cycles[value] = cycle;
 }
 
-void ILPTimeStep::addTimestepGdmaCycle(int ts_idx, int cycle, std::string varName) {
-  // llvm::errs() << "addTimestepGdmaCycle, ts_idx:"<<ts_idx<< ", cycle:"<<cycle<< ", varName: "<<varName<<"\n";
-  cycle_contrains[ts_idx].push_back(std::make_pair(cycle, varName));
+void ILPTimeStep::addTimestepGdmaCycle(int ts_idx, int cycle, int var_id) {
+  // llvm::errs() << "addTimestepGdmaCycle, ts_idx:"<<ts_idx<< ", cycle:"<<cycle<< ", var_id: "<<var_id<<"\n";
+  cycle_contrains[ts_idx].push_back(std::make_pair(cycle, var_id));
 }
 
 void ILPTimeStep::addOpInfo(int ts_idx, Operation* op, int buffer_size, int mem_size_for_load, int bdc_cycle) {
@@ -873,19 +915,17 @@ void ILPTimeStep::addOpInfo(int ts_idx, Operation* op, int buffer_size, int mem_
   timestep_table_[ts_idx].vec_op_infos.push_back(tmp);
 }
 
-void ILPTimeStep::addTimestepMemUse(int ts_idx, int mem_size, std::vector<std::string>& varNames) {
+void ILPTimeStep::addTimestepMemUse(int ts_idx, int mem_size, const std::vector<int>& var_ids) {
   // llvm::errs() << "addTimestepMemUse, ts_idx:"<<ts_idx<< ", mem_size:"<<mem_size<<"\n";
-  for (auto varName: varNames) {
-    // llvm::errs() << "      varName: "<<varName<<"\n";
-    mem_contrains[ts_idx].push_back(std::make_pair(mem_size, varName));
+  for (auto var_id: var_ids) {
+    // llvm::errs() << "      var_id: "<<var_id<<"\n";
+    mem_contrains[ts_idx].push_back(std::make_pair(mem_size, var_id));
   }
 }
 
-MPVariable* ILPTimeStep::getMPVarByName(std::string varName) {
-  if (mapILPVarInfo.find(varName) != mapILPVarInfo.end()) {
-    return mapILPVarInfo[varName].ilp_var;
-  }
-  assert(false);
+MPVariable* ILPTimeStep::getMPVar(int var_id) {
+  assert(var_id >= 0 && var_id < (int)mapILPVarInfo.size());
+  return mapILPVarInfo[var_id].ilp_var;
 }
 
 void ILPTimeStep::resideOpInValue(Operation* op, Value value) {
@@ -896,9 +936,9 @@ void ILPTimeStep::resideOpInValue(Operation* op, Value value) {
   reside_in_tensor[op].push_back(value);
 }
 
-void ILPTimeStep::addNewOutIntoReturnOp(std::vector<std::string> var_names, Value value) {
+void ILPTimeStep::addNewOutIntoReturnOp(std::vector<int> var_ids, Value value) {
   if (values_need_store_to_grpout.find(value) == values_need_store_to_grpout.end()) {
-    values_need_store_to_grpout[value] = var_names;
+    values_need_store_to_grpout[value] = var_ids;
   }
 }
 
@@ -920,7 +960,7 @@ void ILPTimeStep::addConstraint(double lb, double ub, std::vector<std::pair<int,
   if (false) {
     MPSolver::ResultStatus result_status = solver->Solve();
     if (result_status != MPSolver::OPTIMAL && result_status != MPSolver::FEASIBLE) {
-      llvm::errs() << "after addConstraint, the problem does not have an optimal or feasible solution!, result_status:"<<(int)result_status<<"\n";
+      lg_errs() << "after addConstraint, the problem does not have an optimal or feasible solution!, result_status:"<<(int)result_status<<"\n";
       // int idx = 0;
       // vec_constraints.pop_back();
       // for (auto it: vec_constraints) {
@@ -937,13 +977,13 @@ void ILPTimeStep::addConstraint(double lb, double ub, std::vector<std::pair<int,
       // }
       // exit(0);
     } else {
-      llvm::errs() <<"test pass\n";
+      lg_errs() <<"test pass\n";
     }
   }
 }
 
 void ILPTimeStep::showAllConstraint() {
-  llvm::errs() <<"showAllConstraint:\n";
+  lg_errs() <<"showAllConstraint:\n";
 
   std::map<MPVariable*, std::string> only_one_var_warning;
   for (auto it: vec_constraints) {
@@ -974,7 +1014,7 @@ void ILPTimeStep::showConstraintInfo(constraint_info& cons_info, std::map<MPVari
   double min_int = -MPSolver::infinity();
   std::string str;
   auto& it = cons_info;
-  llvm::errs() <<"MakeRowConstraint, lb:"<<(int)it.lb<<" ub:"<<(int)it.ub<<", m_constraint_idx:"<<i
+  lg_errs() <<"MakeRowConstraint, lb:"<<(int)it.lb<<" ub:"<<(int)it.ub<<", m_constraint_idx:"<<i
                <<", info_for_tips:"<<it.info_for_tips<<", var num:"<<it.coeff_var_items.size()<<", coeff and var:\n";
   if (it.lb == it.ub) {
     for (auto it2: it.coeff_var_items) {
@@ -982,18 +1022,18 @@ void ILPTimeStep::showConstraintInfo(constraint_info& cons_info, std::map<MPVari
       if (only_one_var_warning.find(it2.second) != only_one_var_warning.end()) {
         str += only_one_var_warning[it2.second];
       }
-      llvm::errs() <<"  "<<it2.first<<" * "<<str<<"\n";
+      lg_errs() <<"  "<<it2.first<<" * "<<str<<"\n";
     }
-    llvm::errs() <<"  == "<<(int)it.lb<<"\n";
+    lg_errs() <<"  == "<<(int)it.lb<<"\n";
   } else {
     if (it.lb != min_int && it.ub == max_int) {
-      llvm::errs() <<"  "<<(int)it.lb<<"  <\n";
+      lg_errs() <<"  "<<(int)it.lb<<"  <\n";
       for (auto it2: it.coeff_var_items) {
         str = it2.second->name();
         if (only_one_var_warning.find(it2.second) != only_one_var_warning.end()) {
           str += only_one_var_warning[it2.second];
         }
-        llvm::errs() <<"  "<<it2.first<<" * "<<str<<"\n";
+        lg_errs() <<"  "<<it2.first<<" * "<<str<<"\n";
       }
     }
     if (it.lb == min_int && it.ub != max_int) {
@@ -1002,39 +1042,41 @@ void ILPTimeStep::showConstraintInfo(constraint_info& cons_info, std::map<MPVari
         if (only_one_var_warning.find(it2.second) != only_one_var_warning.end()) {
           str += only_one_var_warning[it2.second];
         }
-        llvm::errs() <<"  "<<it2.first<<" * "<<str<<"\n";
+        lg_errs() <<"  "<<it2.first<<" * "<<str<<"\n";
       }
-      llvm::errs() <<"  < "<<(int)it.ub<<"\n";
+      lg_errs() <<"  < "<<(int)it.ub<<"\n";
     }
     if (it.lb != min_int && it.ub != max_int) {
-      llvm::errs() <<"  "<<(int)it.lb<<"  <\n";
+      lg_errs() <<"  "<<(int)it.lb<<"  <\n";
       for (auto it2: it.coeff_var_items) {
         str = it2.second->name();
         if (only_one_var_warning.find(it2.second) != only_one_var_warning.end()) {
           str += only_one_var_warning[it2.second];
         }
-        llvm::errs() <<"  "<<it2.first<<" * "<<str<<"\n";
+        lg_errs() <<"  "<<it2.first<<" * "<<str<<"\n";
       }
-      llvm::errs() <<"  < "<<(int)it.ub<<"\n";
+      lg_errs() <<"  < "<<(int)it.ub<<"\n";
     }
   }
 }
 
 void ILPTimeStep::showRunInfo() {
   int i = 0;
-  llvm::errs() << "showRunInfo:\n";;
+  lg_errs() << "showRunInfo:\n";;
   for (auto &itr: timestep_table_new) {
-    llvm::errs() << "-------------------ts"<<i<<"--------------------\n";;
+    lg_errs() << "-------------------ts"<<i<<"--------------------\n";;
     int cycle = 0, total_cycle = 0;
     for (auto &itr2: itr.vec_ts_var) {
-      if (mapILPVarInfo[itr2.varName].ilp_var->solution_value() == 1) {
+      auto ilp_var = mapILPVarInfo[itr2.var_id].ilp_var;
+      if (ilp_var->solution_value() == 1) {
         for (auto itr3: cycle_contrains_new[i]) {
-          if (itr3.second == itr2.varName) {
+          if (itr3.second == itr2.var_id) {
             cycle = itr3.first;
             break;
           }
         }
-        llvm::errs() <<"  dma var, name: " << itr2.varName <<", cycle:"<<cycle<<"\n";
+        lg_errs() <<"  dma var, var_id: " << itr2.var_id <<", value: " << module::getName(itr2.value)
+                     <<", slice_idx: " << itr2.slice_idx <<", cycle:"<<cycle<<"\n";
         if (map_reside_value_info.find(itr2.value) == map_reside_value_info.end()) {
           total_cycle += cycle;
         }
@@ -1043,24 +1085,24 @@ void ILPTimeStep::showRunInfo() {
 
     for (auto itr2: itr.vec_op_infos) {
       auto outs = get_output_values(itr2.op);
-      llvm::errs() <<"  op name: " << module::getName(outs[0]).str()
+      lg_errs() <<"  op name: " << module::getName(outs[0]).str()
                 <<" , cycle:"<<itr2.bdc_cycle<<", free mem_size:"<<itr2.mem_size_for_load<<"\n";
     }
     i++;
   }
 }
 
-void ILPTimeStep::addRowConstraint(int ts_idx, Value load_tensor, std::vector<std::string> var_names) {
+void ILPTimeStep::addRowConstraint(int ts_idx, Value load_tensor, const std::vector<int>& var_ids) {
   assert(solver != nullptr);
-  assert(var_names.size() > 0);
+  assert(var_ids.size() > 0);
 
   // llvm::errs() <<"ts_idx:"<<ts_idx<<", addRowConstraint:\n";
   std::vector<std::pair<int, MPVariable*>> coeff_var_items;
-  for (auto var_name: var_names) {
-    // llvm::errs() << "      var_name: "<<var_name<<"\n";
-    coeff_var_items.push_back(std::make_pair(1, mapILPVarInfo[var_name].ilp_var));
+  for (auto var_id: var_ids) {
+    // llvm::errs() << "      var_id: "<<var_id<<"\n";
+    coeff_var_items.push_back(std::make_pair(1, mapILPVarInfo[var_id].ilp_var));
   }
-  // if (var_names.size() > 1) {
+  // if (var_ids.size() > 1) {
   //   // addConstraint(1, 1, coeff_var_items);
   // }
   addConstraint(1, 1, coeff_var_items);
@@ -1068,19 +1110,23 @@ void ILPTimeStep::addRowConstraint(int ts_idx, Value load_tensor, std::vector<st
   if (ts_idx >= 0) {
     auto& need_load_var = timestep_table_[ts_idx].vec_op_infos[0].need_load_var;
     if (need_load_var.find(load_tensor) == need_load_var.end()) {
-      std::vector<std::string> null_names;
-      need_load_var[load_tensor] = null_names;
+      std::vector<int> null_ids;
+      need_load_var[load_tensor] = null_ids;
     }
-    need_load_var[load_tensor].assign(var_names.begin(), var_names.end());
+    need_load_var[load_tensor].assign(var_ids.begin(), var_ids.end());
   }
 }
 
-void ILPTimeStep::setVarExpectValue(std::string var_name, int expect_value) {
+void ILPTimeStep::setVarExpectValue(int var_id, int expect_value) {
   std::vector<std::pair<int, MPVariable*>> coeff_var_items;
-  coeff_var_items.push_back(std::make_pair(1, mapILPVarInfo[var_name].ilp_var));
+  coeff_var_items.push_back(std::make_pair(1, mapILPVarInfo[var_id].ilp_var));
   addConstraint(expect_value, expect_value, coeff_var_items);
 }
 
+void ILPTimeStep::addVarHint(int var_id, double hint_value) {
+  var_hints.push_back(std::make_pair(var_id, hint_value));
+}
+
 bool ILPTimeStep::run() {
   assert(solver != nullptr);
   // int max_int = (int)MPSolver::infinity();
@@ -1089,12 +1135,30 @@ bool ILPTimeStep::run() {
     showAllConstraint();
     solver->EnableOutput();
   }
-  llvm::errs() << "solve start\n";
+  if (!var_hints.empty()) {
+    // start from the hinted solution, solver fills the other variables
+    std::vector<std::pair<const MPVariable*, double>> hints;
+    for (auto it: var_hints) {
+      hints.push_back(std::make_pair(getMPVar(it.first), it.second));
+    }
+    solver->SetHint(hints);
+  }
+#ifdef _OPENMP
+  if (omp_in_parallel()) {
+    // other groups are solved by the other threads, avoid oversubscription
+    (void)solver->SetNumThreads(1);
+  }
+#endif
+  if (LgPass::OPTIONS.ilp_time_limit > 0) {
+    // return the best feasible solution found if time is out
+    solver->set_time_limit(LgPass::OPTIONS.ilp_time_limit * 1000);
+  }
+  lg_errs() << "solve start\n";
   MPSolver::ResultStatus result_status = solver->Solve();
 
   // Check that the problem has an optimal solution.
   if (result_status != MPSolver::OPTIMAL && result_status != MPSolver::FEASIBLE) {
-    llvm::errs() << "The problem does not have an optimal or feasible solution!, result_status:"<<(int)result_status<<"\n";
+    lg_errs() << "The problem does not have an optimal or feasible solution!, result_status:"<<(int)result_status<<"\n";
 
     // int idx = 0;
     // llvm::errs() << "start checking1\n";
@@ -1128,17 +1192,17 @@ bool ILPTimeStep::run() {
     return false;
   }
 
-  llvm::errs() << "Solution:\n";;
-  llvm::errs() << "Objective value = " << objective->Value()<<"\n";
+  lg_errs() << "Solution:\n";;
+  lg_errs() << "Objective value = " << objective->Value()<<"\n";
 
   // for (auto itr = mapILPVarInfo.begin(); itr != mapILPVarInfo.end(); ++itr) {
   //   llvm::errs() <<"var name: " << itr->first << ", value: " << itr->second.ilp_var->solution_value()<<"\n";
   // }
 
-  llvm::errs() << "\nAdvanced usage:\n";;
-  llvm::errs() << "Problem solved in " << solver->wall_time() << " milliseconds\n";;
-  llvm::errs() << "Problem solved in " << solver->iterations() << " iterations\n";;
-  llvm::errs() << "Problem solved in " << solver->nodes()
+  lg_errs() << "\nAdvanced usage:\n";;
+  lg_errs() << "Problem solved in " << solver->wall_time() << " milliseconds\n";;
+  lg_errs() << "Problem solved in " << solver->iterations() << " iterations\n";;
+  lg_errs() << "Problem solved in " << solver->nodes()
             << " branch-and-bound nodes\n";;
   return true;
 }
@@ -1153,27 +1217,35 @@ void ILPTimeStep::addSliceNcdhwSteps(int core_id, std::vector<int64_t> ncdhw) {
 }
 
 void ILPTimeStep::showTimeStepInfo(int debug_cmd) {
-  llvm::errs() << "-------------------mem_contrains_info, after merge--------------------\n";;
+  lg_errs() << "-------------------mem_contrains_info, after merge--------------------\n";;
   for(int i = 0; i < ts_count; i++) {
-    llvm::errs() << "-------------------ts"<<i<<"--------------------\n";;
+    lg_errs() << "-------------------ts"<<i<<"--------------------\n";;
     if (!(i == 0 || i == ts_count - 1)) {
       for (auto it:timestep_table_new[i].vec_op_infos)
-        llvm::errs() <<"op_name:"<<module::getName(it.op)<<"\n";
+        lg_errs() <<"op_name:"<<module::getName(it.op)<<"\n";
     }
     for (auto it: mem_contrains_new[i]) {
-      llvm::errs() <<"  "<<it.first<<" * "<<it.second<<"\n";
+      if (detail_log) {
+        lg_errs() <<"  "<<it.first<<" * "<<mapILPVarInfo[it.second].ilp_var->name()<<"\n";
+      } else {
+        lg_errs() <<"  "<<it.first<<" * var"<<it.second<<"\n";
+      }
     }
   }
 
-  llvm::errs() << "-------------------cycle_contrains_info, after merge--------------------\n";;
+  lg_errs() << "-------------------cycle_contrains_info, after merge--------------------\n";;
   for(int i = 0; i < ts_count; i++) {
-    llvm::errs() << "-------------------ts"<<i<<"--------------------\n";;
+    lg_errs() << "-------------------ts"<<i<<"--------------------\n";;
     if (!(i == 0 || i == ts_count - 1)) {
       for (auto it:timestep_table_new[i].vec_op_infos)
-        llvm::errs() <<"op_name:"<<module::getName(it.op)<<"\n";
+        lg_errs() <<"op_name:"<<module::getName(it.op)<<"\n";
     }
     for (auto it: cycle_contrains_new[i]) {
-      llvm::errs() <<"  "<<it.first<<" * "<<it.second<<"\n";
+      if (detail_log) {
+        lg_errs() <<"  "<<it.first<<" * "<<mapILPVarInfo[it.second].ilp_var->name()<<"\n";
+      } else {
+        lg_errs() <<"  "<<it.first<<" * var"<<it.second<<"\n";
+      }
     }
   }
 }
@@ -1207,12 +1279,12 @@ bool ILPTimeStep::merge_small_cycle_op(TensorInfo& tensor_infos) {
 
   int dma_cycle = -1, merge_start = 0, min_pos = 0;
   std::vector<Value> big_load_tensor;
-  llvm::errs() << "merge_small_cycle_op starting\n";
+  lg_errs() << "merge_small_cycle_op starting\n";
   for(int i = ts_count - 1; i >= 0; i--) {
     if (!(i == 0 || i == ts_count - 1)) {
       // int slice_idx = timestep_table_[i].vec_op_infos[0].slice_idx;
       auto op = timestep_table_[i].vec_op_infos[0].op;
-      llvm::errs() << "ts:"<<i<< ", op:"<<module::getName(op).str()
+      lg_errs() << "ts:"<<i<< ", op:"<<module::getName(op).str()
                    << ", type:"<<op->getName().getStringRef().str()<<"\n";
       do {
         if (dma_cycle == -1) {
@@ -1220,14 +1292,14 @@ bool ILPTimeStep::merge_small_cycle_op(TensorInfo& tensor_infos) {
             auto in = op->getOperand(1);
             big_load_tensor.push_back(in);
             dma_cycle = timestep_table_[i].vec_op_infos[0].load_tensor_cycles[in];
-            llvm::errs() <<"weight load cycle:"<<dma_cycle<<"\n";
+            lg_errs() <<"weight load cycle:"<<dma_cycle<<"\n";
             merge_start = i - 1;
           } else {
             break;
           }
         } else {
           merge_start = i;
-          llvm::errs() << "ts:"<<i<< " achor dma_cycle:"<<dma_cycle<<" for merged op\n";
+          lg_errs() << "ts:"<<i<< " achor dma_cycle:"<<dma_cycle<<" for merged op\n";
         }
 
         std::vector<int> cycle_sum;
@@ -1237,7 +1309,7 @@ bool ILPTimeStep::merge_small_cycle_op(TensorInfo& tensor_infos) {
             break;
           auto bdc_cycle = timestep_table_[merge_start - k].vec_op_infos[0].bdc_cycle;
           sum += bdc_cycle;
-          llvm::errs() << "merge op"<<merge_start - k<<", bdc_cycle:"<<bdc_cycle<<", sum:"<<sum<<"\n";
+          lg_errs() << "merge op"<<merge_start - k<<", bdc_cycle:"<<bdc_cycle<<", sum:"<<sum<<"\n";
           cycle_sum.push_back(std::abs(dma_cycle - sum));
         }
         min_pos = 0;
@@ -1247,13 +1319,15 @@ bool ILPTimeStep::merge_small_cycle_op(TensorInfo& tensor_infos) {
           if (it2 != cycle_sum.end()) {
             min_pos = std::distance(cycle_sum.begin(), it2);
             if (min_pos > 0) {
-              llvm::errs() << "find min_pos:"<<min_pos<<"\n";
+              lg_errs() << "find min_pos:"<<min_pos<<"\n";
               auto op_name = replaceChars_for_dot(module::getName(op).str());
               for (int m = 1; m <= min_pos; m++) { //load类型变量，保留融合op中最后一个ts(merge_start)的变量设置，其他ts的变量固定为0
                 for (auto it3: cycle_contrains[merge_start - m]) {
                   int64_t mode2 = mapILPVarInfo[it3.second].tensor_info.mode2;
                   if (mode2&TIMESTEP2_LOAD || (mode2&TIMESTEP2_STORE_AND_LOAD && mapILPVarInfo[it3.second].mode == 1)) {
-                    llvm::errs() << "for loadVar, setVarExpectValue:"<<it3.second<<" to const_0\n";
+                    if (detail_log) {
+                      lg_errs() << "for loadVar, setVarExpectValue:"<<mapILPVarInfo[it3.second].ilp_var->name()<<" to const_0\n";
+                    }
                     setVarExpectValue(it3.second, 0);
                   }
                 }
@@ -1262,7 +1336,9 @@ bool ILPTimeStep::merge_small_cycle_op(TensorInfo& tensor_infos) {
                 for (auto it3: cycle_contrains[merge_start - m]) {
                   int64_t mode2 = mapILPVarInfo[it3.second].tensor_info.mode2;
                   if (mode2&TIMESTEP2_STORE || (mode2&TIMESTEP2_STORE_AND_LOAD && mapILPVarInfo[it3.second].mode == 0)) {
-                    llvm::errs() << "for storeVar, setVarExpectValue:"<<it3.second<<" to const_0\n";
+                    if (detail_log) {
+                      lg_errs() << "for storeVar, setVarExpectValue:"<<mapILPVarInfo[it3.second].ilp_var->name()<<" to const_0\n";
+                    }
                     setVarExpectValue(it3.second, 0);
                   }
                 }
@@ -1304,7 +1380,7 @@ bool ILPTimeStep::merge_small_cycle_op(TensorInfo& tensor_infos) {
                 for (auto it: timestep_row.vec_ts_var) {
                   auto it3 = std::find(searched_value.begin(), searched_value.end(), it.value);
                   if (it3 == searched_value.end()) {
-                    // llvm::errs() << "add "<<it.varName<<" to new vec_ts_var\n";
+                    // llvm::errs() << "add "<<it.var_id<<" to new vec_ts_var\n";
                     tmp.vec_ts_var.push_back(it);
                     searched_value.push_back(it.value);
                   }
@@ -1313,13 +1389,13 @@ bool ILPTimeStep::merge_small_cycle_op(TensorInfo& tensor_infos) {
               reverse(tmp.vec_op_infos.begin(), tmp.vec_op_infos.end());
               if (merge_start == i - 1) {
                 timestep_table_new.push_back(timestep_table_[i]);
-                llvm::errs() << "i:"<<i<< ", add "<<module::getName(timestep_table_[i].vec_op_infos[0].op).str()<<" to timestep_table_new\n";
+                lg_errs() << "i:"<<i<< ", add "<<module::getName(timestep_table_[i].vec_op_infos[0].op).str()<<" to timestep_table_new\n";
               }
               timestep_table_new.push_back(tmp);
 
               //更新cycle约束、内存约束
-              std::vector<std::pair<int, std::string>> new_cycle;
-              std::vector<std::pair<int, std::string>> new_mem;
+              std::vector<std::pair<int, int>> new_cycle;
+              std::vector<std::pair<int, int>> new_mem;
               for (auto it2: cycle_contrains[merge_start]) {
                 // llvm::errs() << "add "<<it2.second<<" to new_cycle\n";
                 new_cycle.push_back(it2);
@@ -1351,7 +1427,7 @@ bool ILPTimeStep::merge_small_cycle_op(TensorInfo& tensor_infos) {
         //合并发生，在前面添加合并ts配置信息
         continue;
       }
-      llvm::errs() << "i:"<<i<< ", add2 "<<module::getName(timestep_table_[i].vec_op_infos[0].op).str()<<" to timestep_table_new\n";
+      lg_errs() << "i:"<<i<< ", add2 "<<module::getName(timestep_table_[i].vec_op_infos[0].op).str()<<" to timestep_table_new\n";
     }
     timestep_table_new.push_back(timestep_table_[i]);
     cycle_contrains_new.push_back(cycle_contrains[i]);
@@ -1361,7 +1437,7 @@ bool ILPTimeStep::merge_small_cycle_op(TensorInfo& tensor_infos) {
   reverse(cycle_contrains_new.begin(), cycle_contrains_new.end());
   reverse(mem_contrains_new.begin(), mem_contrains_new.end());
   ts_count = timestep_table_new.size();
-  llvm::errs() << "new ts_count:"<<ts_count<<"\n";
+  lg_errs() << "new ts_count:"<<ts_count<<"\n";
   return true;
 }
 
@@ -1378,11 +1454,14 @@ bool ILPTimeStep::prepare(TensorInfo& tensor_infos) {
   assert(solver != nullptr && objective != nullptr);
   std::vector<std::pair<std::string, MPVariable*>> objective_var;
   for(int i = 0; i < ts_count; i++) {
-    std::string var_name = llvm::formatv("sum_var_ts{0}", i);
+    std::string var_name, abs_var_name;
+    if (detail_log) {
+      var_name = llvm::formatv("sum_var_ts{0}", i);
+      abs_var_name = llvm::formatv("sum_var_abs_ts{0}", i);
+    }
     MPVariable* x = solver->MakeIntVar(-MPSolver::infinity(), MPSolver::infinity(), var_name);
     objective_var.push_back(std::make_pair(var_name, x));
 
-    std::string abs_var_name = llvm::formatv("sum_var_abs_ts{0}", i);
     MPVariable* x_abs = solver->MakeIntVar(-MPSolver::infinity(), MPSolver::infinity(), abs_var_name);
     objective->SetCoefficient(x_abs, 1);
 
@@ -1397,7 +1476,7 @@ bool ILPTimeStep::prepare(TensorInfo& tensor_infos) {
     addConstraint(0, MPSolver::infinity(), coeff_var_items);
   }
 
-  llvm::errs() << ">>>>> add cycle_contrains:\n";
+  lg_errs() << ">>>>> add cycle_contrains:\n";
   std::string op_name;
   for(int i = 0; i < ts_count; i++) {
     double bdc_cycle = 0;
@@ -1416,26 +1495,26 @@ bool ILPTimeStep::prepare(TensorInfo& tensor_infos) {
     }
     std::vector<std::pair<int, MPVariable*>> coeff_var_items;
     coeff_var_items.push_back(std::make_pair(1, objective_var[i].second));
-    llvm::errs() <<"  i:"<<i<<", op_name:"<<op_name<<", bdc_cycle:"<<(int)bdc_cycle<<"\n";
+    lg_errs() <<"  i:"<<i<<", op_name:"<<op_name<<", bdc_cycle:"<<(int)bdc_cycle<<"\n";
     for (auto it: cycle_contrains_new[i]) {
       coeff_var_items.push_back(std::make_pair(it.first, mapILPVarInfo[it.second].ilp_var));
     }
     addConstraint(bdc_cycle, bdc_cycle, coeff_var_items);
   }
 
-  llvm::errs() << ">>>>> add mem_contrains:\n";
+  lg_errs() << ">>>>> add mem_contrains:\n";
   for(int i = 0; i < ts_count; i++) {
     if (i == 0 || i == ts_count - 1) {
       continue;
     }
-    llvm::errs() <<" ts:"<<i<<"\n";
+    lg_errs() <<" ts:"<<i<<"\n";
     if (mem_contrains_new[i].size() > 0) {
       op_name = "null";
       std::vector<int> op_free_size;
       int ts_reside_value_size = 0;
       for (auto it: timestep_table_new[i].vec_op_infos) {
         auto name = module::getName(it.op).str();
-        llvm::errs() <<"  op:"<<name<<"\n";
+        lg_errs() <<"  op:"<<name<<"\n";
         op_name = name + "__" + op_name;
         int op_reside_value_size = 0;
         for (auto in : get_input_values(it.op)) {
@@ -1443,7 +1522,7 @@ bool ILPTimeStep::prepare(TensorInfo& tensor_infos) {
             auto tensors = reside_in_tensor[it.op];
             if (find(tensors.begin(), tensors.end(), in) != tensors.end()) {
               if (detail_log)
-                fprintf(stderr, "   reside_in_tensor\n");
+                lg_errs() << "   reside_in_tensor\n";
               op_reside_value_size += it.tensor_size[in];
               ts_reside_value_size += it.tensor_size[in];
             }
@@ -1456,7 +1535,7 @@ bool ILPTimeStep::prepare(TensorInfo& tensor_infos) {
                 (mode2&TIMESTEP2_STORE_AND_LOAD && mapILPVarInfo[it2].mode == 0)) {
                 op_reside_value_size += it.tensor_size[in];
                 if (detail_log)
-                  llvm::errs() <<"   in:"<<module::getName(in).str()<<" have store, tensor_size:"<<it.tensor_size[in]<<"\n";
+                  lg_errs() <<"   in:"<<module::getName(in).str()<<" have store, tensor_size:"<<it.tensor_size[in]<<"\n";
                 ts_reside_value_size += it.tensor_size[in];
                 break;
               }
@@ -1464,7 +1543,7 @@ bool ILPTimeStep::prepare(TensorInfo& tensor_infos) {
           }
         }
         if (detail_log)
-          llvm::errs() <<"  op_reside_value_size:"<<op_reside_value_size<<"\n";
+          lg_errs() <<"  op_reside_value_size:"<<op_reside_value_size<<"\n";
         op_free_size.push_back(it.mem_size_for_load - op_reside_value_size);
       }
       // llvm::errs() <<"  ts_reside_value_size:"<<ts_reside_value_size<<"\n";
@@ -1477,7 +1556,7 @@ bool ILPTimeStep::prepare(TensorInfo& tensor_infos) {
       if (timestep_table_new[i].vec_op_infos.size() > 1) {
         op_name = "super_op_" + op_name;
       }
-      llvm::errs() <<"  op_name:"<<op_name<<":\n";
+      lg_errs() <<"  op_name:"<<op_name<<":\n";
       std::vector<std::pair<int, MPVariable*>> coeff_var_items;
       for (auto it: mem_contrains_new[i]) {
         coeff_var_items.push_back(std::make_pair(it.first, mapILPVarInfo[it.second].ilp_var));
@@ -1491,7 +1570,7 @@ bool ILPTimeStep::prepare(TensorInfo& tensor_infos) {
 
 bool ILPTimeStep::mem_alloc(mem_alloc_status& alloc_status, std::vector<std::pair<Value, int64_t>>& value_size,
                             TensorInfo& tensor_infos) {
-  llvm::errs() << "mem_alloc start:\n";
+  lg_errs() << "mem_alloc start:\n";
   AutoIndent auto_indent;
   lmem_alloc_ptr = std::make_shared<lmem_alloc>(_group_info.group_banked_tensors, this, ts_count);
   // value_size.clear();
@@ -1516,9 +1595,9 @@ bool ILPTimeStep::mem_alloc(mem_alloc_status& alloc_status, std::vector<std::pai
         }
       }
     }
-    llvm::errs() << "min_always_free_mem_size:"<<min_always_free_mem_size<<"\n";
+    lg_errs() << "min_always_free_mem_size:"<<min_always_free_mem_size<<"\n";
 
-    llvm::errs() << "add reside_value:\n";
+    lg_errs() << "add reside_value:\n";
     if (min_always_free_mem_size > 0) {
       int addr = lmem_alloc_ptr->total_size - 16;
       for (auto itr: value_size) {
@@ -1530,7 +1609,7 @@ bool ILPTimeStep::mem_alloc(mem_alloc_status& alloc_status, std::vector<std::pai
           tmp.size = itr.second;
           map_reside_value_info[itr.first] = tmp;
           min_always_free_mem_size -= itr.second;
-          llvm::errs() << "  name:"<<module::getName(itr.first).str()<< ", addr:"<<addr<<"\n";
+          lg_errs() << "  name:"<<module::getName(itr.first).str()<< ", addr:"<<addr<<"\n";
         } else {
           break;
         }
@@ -1539,23 +1618,24 @@ bool ILPTimeStep::mem_alloc(mem_alloc_status& alloc_status, std::vector<std::pai
   }
 
   int i = 0;
-  std::string name;
   bool ret = false;
 
-  llvm::errs() << "show var value:\n";
+  lg_errs() << "show var value:\n";
   for (auto &itr: timestep_table_new) {
-    llvm::errs() << "-------------------ts"<<i<<"--------------------\n";;
+    lg_errs() << "-------------------ts"<<i<<"--------------------\n";;
     int cycle = 0, total_cycle = 0;
     for (auto &itr2: itr.vec_ts_var) {
-      if (mapILPVarInfo[itr2.varName].ilp_var->solution_value() == 1) {
+      auto ilp_var = mapILPVarInfo[itr2.var_id].ilp_var;
+      if (ilp_var->solution_value() == 1) {
         itr2.var_value = 1;
         for (auto itr3: cycle_contrains_new[i]) {
-          if (itr3.second == itr2.varName) {
+          if (itr3.second == itr2.var_id) {
             cycle = itr3.first;
             break;
           }
         }
-        llvm::errs() <<"  dma var, name: " << itr2.varName <<", cycle:"<<cycle<<"\n";
+        lg_errs() <<"  dma var, var_id: " << itr2.var_id <<", value: " << module::getName(itr2.value)
+                     <<", slice_idx: " << itr2.slice_idx <<", cycle:"<<cycle<<"\n";
         if (map_reside_value_info.find(itr2.value) == map_reside_value_info.end()) {
           total_cycle += cycle;
         }
@@ -1564,16 +1644,16 @@ bool ILPTimeStep::mem_alloc(mem_alloc_status& alloc_status, std::vector<std::pai
 
     for (auto itr2: itr.vec_op_infos) {
       auto outs = get_output_values(itr2.op);
-      llvm::errs() <<"  op name: " << module::getName(outs[0]).str()
+      lg_errs() <<"  op name: " << module::getName(outs[0]).str()
                 <<" , cycle:"<<itr2.bdc_cycle<<", free mem_size:"<<itr2.mem_size_for_load<<"\n";
     }
     i++;
   }
 
   i = 0;
-  llvm::errs() << "gen vec_l2m_value_info:\n";
+  lg_errs() << "gen vec_l2m_value_info:\n";
   for (auto &itr: timestep_table_new) {
-    llvm::errs() << "-------------------ts"<<i<<"--------------------\n";;
+    lg_errs() << "-------------------ts"<<i<<"--------------------\n";;
     int slice_idx = (i - 1)/_group_info.group_ops.size();
     for (auto itr2: itr.vec_op_infos) {
       for (auto itr3 = itr2.need_load_var.begin(); itr3 != itr2.need_load_var.end(); ++itr3) {
@@ -1581,7 +1661,6 @@ bool ILPTimeStep::mem_alloc(mem_alloc_status& alloc_status, std::vector<std::pai
         if (slice_idx == 0 || map_reside_value_info.find(itr3->first) == map_reside_value_info.end()) {
           for (auto var: itr3->second) {
             if (mapILPVarInfo[var].ilp_var->solution_value() == 1) {
-              name = module::getName(itr3->first).str();
               l2m_value_info info;
               info.slice_idx = slice_idx;
               info.value = itr3->first;
@@ -1590,7 +1669,9 @@ bool ILPTimeStep::mem_alloc(mem_alloc_status& alloc_status, std::vector<std::pai
               info.free_ts = i + 1;
               info.load_ts = mapILPVarInfo[var].ts_idx - 1;
               vec_l2m_value_info.push_back(info);
-              llvm::errs() <<"tensor name:"<<name<<", compute at pos:"<<i<<", load at ts:" << mapILPVarInfo[var].ts_idx - 1<<"\n";
+              if (detail_log) {
+                lg_errs() <<"tensor name:"<<module::getName(itr3->first).str()<<", compute at pos:"<<i<<", load at ts:" << mapILPVarInfo[var].ts_idx - 1<<"\n";
+              }
               break;
             }
           }
@@ -1599,32 +1680,31 @@ bool ILPTimeStep::mem_alloc(mem_alloc_status& alloc_status, std::vector<std::pai
     }
     i++;
   }
-  llvm::errs() << "  vec_l2m_value_info.size:"<<vec_l2m_value_info.size()<<"\n";
+  lg_errs() << "  vec_l2m_value_info.size:"<<vec_l2m_value_info.size()<<"\n";
 
   if (map_reside_value_info.size() > 0) {
-    llvm::errs() << "cancel reside_value load:\n";;
+    lg_errs() << "cancel reside_value load:\n";;
     for(int i = 0; i < ts_count; i++) {
       //第1个slice的驻留权重加载不取消，后面的均取消，这样即能保证加载时的隐藏，又取消后面slice的加载，减少功耗
       if (i < ts_count - 2) {
         for (auto& it: timestep_table_new[i].vec_ts_var) {
           if (it.slice_idx > 0 && it.var_value == 1 && map_reside_value_info.find(it.value) != map_reside_value_info.end()) {
             it.var_value = 0;
-            llvm::errs() << "  name:"<<module::getName(it.value).str()<< ", ts:"<<i<<"\n";
+            lg_errs() << "  name:"<<module::getName(it.value).str()<< ", ts:"<<i<<"\n";
           }
         }
       }
     }
   }
 
-  fprintf(stderr, "deal weight pre dma load:\n");
+  lg_errs() << "deal weight pre dma load:\n";
   for(int i = 0; i < ts_count; i++) {
     for (auto it: timestep_table_new[i].vec_ts_var) {
-      name = module::getName(it.value).str();
       if (it.info.mode2&TIMESTEP2_LOAD && it.var_value == 1) {
         if (map_reside_value_info.find(it.value) != map_reside_value_info.end()) {
           int addr = map_reside_value_info[it.value].addr;
           int size = map_reside_value_info[it.value].size;
-          lmem_alloc_ptr->alloc2(i, it.slice_idx, name, it.value, addr, size);
+          lmem_alloc_ptr->alloc2(i, lmem_key_t(it.value, it.slice_idx), it.value, addr, size);
         }
       }
     }
@@ -1634,18 +1714,17 @@ bool ILPTimeStep::mem_alloc(mem_alloc_status& alloc_status, std::vector<std::pai
 
   std::vector<mem_alloc_req_info> vec_mem_req;
   std::vector<std::pair<int,int>> vec_pre_ts_free_mem, vec_pre_ts_free_mem_pre;
-  fprintf(stderr, "start analog allocation\n");
+  lg_errs() << "start analog allocation\n";
   for(int i = 0; i < ts_count; i++) {
-    fprintf(stderr, ">>>ts:%d\n", i);
-    fprintf(stderr, "  deal dma load:\n");
+    lg_errs() << llvm::format(">>>ts:%d\n", i);
+    lg_errs() << "  deal dma load:\n";
     if (i < ts_count - 2) {
       for (auto it: timestep_table_new[i].vec_ts_var) {
-        name = module::getName(it.value).str();
         if (it.info.mode2&TIMESTEP2_LOAD && it.var_value == 1) {
           if (map_reside_value_info.find(it.value) == map_reside_value_info.end()) {
             mem_alloc_req_info tmp;
             tmp.slice_idx = it.slice_idx;
-            tmp.name = name;
+            tmp.key = lmem_key_t(it.value, it.slice_idx);
             tmp.value = it.value;
             tmp.size = it.lmem_bytes;
             vec_mem_req.push_back(tmp);
@@ -1653,10 +1732,10 @@ bool ILPTimeStep::mem_alloc(mem_alloc_status& alloc_status, std::vector<std::pai
           }
         }
         if (it.info.mode2&TIMESTEP2_STORE_AND_LOAD && it.var_value == 1) {
-          if (mapILPVarInfo[it.varName].mode == 1) {
+          if (mapILPVarInfo[it.var_id].mode == 1) {
             mem_alloc_req_info tmp;
             tmp.slice_idx = it.slice_idx;
-            tmp.name = name;
+            tmp.key = lmem_key_t(it.value, it.slice_idx);
             tmp.value = it.value;
             tmp.size = it.lmem_bytes;
             vec_mem_req.push_back(tmp);
@@ -1666,18 +1745,19 @@ bool ILPTimeStep::mem_alloc(mem_alloc_status& alloc_status, std::vector<std::pai
     }
 
     if (i > 0 && i < ts_count - 1) {
-      fprintf(stderr, "  deal tpu:\n");
+      lg_errs() << "  deal tpu:\n";
       bool have_mem_dependent = false;
       for (auto it2: timestep_table_new[i].vec_op_infos) {
         auto outs = get_output_values(it2.op);
-        name = module::getName(outs[0]).str();
-        llvm::errs() << "    op name: "<<name<<"\n";
+        if (detail_log) {
+          lg_errs() << "    op name: "<<module::getName(outs[0]).str()<<"\n";
+        }
         int buffer_size = it2.buffer_size;
         if (buffer_size > 0) {
           Value tmp_value;
           mem_alloc_req_info tmp;
           tmp.slice_idx = it2.slice_idx;
-          tmp.name = name + "_buffer";
+          tmp.key = lmem_key_t(outs[0], it2.slice_idx, true);
           tmp.value = tmp_value;
           tmp.size = buffer_size;
           vec_mem_req.push_back(tmp);
@@ -1686,7 +1766,7 @@ bool ILPTimeStep::mem_alloc(mem_alloc_status& alloc_status, std::vector<std::pai
         for (auto out : outs) {
           mem_alloc_req_info tmp;
           tmp.slice_idx = it2.slice_idx;
-          tmp.name = module::getName(out).str();
+          tmp.key = lmem_key_t(out, it2.slice_idx);
           tmp.value = out;
           tmp.size = it2.tensor_size[out];
           // if (tmp.size > 0) //训练图中maxpool的mask输出有时无需处理,why
@@ -1696,20 +1776,21 @@ bool ILPTimeStep::mem_alloc(mem_alloc_status& alloc_status, std::vector<std::pai
         bool sort_by_size = true;
         ret = lmem_alloc_ptr->alloc_multi(i, vec_mem_req, sort_by_size);
         if (!ret) {
-          fprintf(stderr, "      alloc_multi fail\n");
+          lg_errs() << "      alloc_multi fail\n";
           return false;
         }
         if (i > 1 && !have_mem_dependent) { //复合op中某子op已与上一时戳有依赖，则不再重复检查
           for (auto it1: vec_mem_req) { //当前的请求不能与上一个时戳的任一释放有依赖
             mem_struct mem_s;
-            auto key = convert_name_to_key(it1.name, it1.slice_idx);
-            lmem_alloc_ptr->get_mem_struct(key, mem_s);
+            lmem_alloc_ptr->get_mem_struct(it1.key, mem_s);
             for (auto it2: vec_pre_ts_free_mem_pre) {
               if (is_range_overlap(it2.first, it2.second, mem_s.addr, mem_s.addr + mem_s.size)) {
                 have_mem_dependent = true;
-                llvm::errs() << "         vec_mem_req, key:"<<key
-                            << ", req start addr:"<<mem_s.addr<< ", end addr:"<<mem_s.addr + mem_s.size
-                            << ", pre_ts start addr:"<<it2.first<< ", end addr:"<<it2.second<<"\n";
+                if (detail_log) {
+                  lg_errs() << "         vec_mem_req, key:"<<convert_key_to_name(it1.key)
+                              << ", req start addr:"<<mem_s.addr<< ", end addr:"<<mem_s.addr + mem_s.size
+                              << ", pre_ts start addr:"<<it2.first<< ", end addr:"<<it2.second<<"\n";
+                }
                 // if (key == "826_buffer_slice0") {
                 //   int unused;
                 //   (void)lmem_alloc_ptr->show_mem(unused, unused, unused);
@@ -1722,14 +1803,14 @@ bool ILPTimeStep::mem_alloc(mem_alloc_status& alloc_status, std::vector<std::pai
         }
         vec_mem_req.clear();
 
-        fprintf(stderr, "    deal input free:\n");
+        lg_errs() << "    deal input free:\n";
         for (auto in : get_input_values(it2.op)) {
           bool to_be_used = false;
           if (reside_in_tensor.find(it2.op) != reside_in_tensor.end()) {
             auto tensors = reside_in_tensor[it2.op];
             if (find(tensors.begin(), tensors.end(), in) != tensors.end()) {
               to_be_used = true;
-              fprintf(stderr, "       reside_in_tensor\n");
+              lg_errs() << "       reside_in_tensor\n";
             }
           }
           if (mapValueInfo.find(in) != mapValueInfo.end()) {
@@ -1747,52 +1828,48 @@ bool ILPTimeStep::mem_alloc(mem_alloc_status& alloc_status, std::vector<std::pai
               if (valid && (mode2&TIMESTEP2_STORE || mode2&TIMESTEP2_STORE_ONLY_FREE || //store应该是可以和op并行的？bank冲突吗? todo
                 (mode2&TIMESTEP2_STORE_AND_LOAD && mapILPVarInfo[it3].mode == 0))) {
                 to_be_used = true;
-                fprintf(stderr, "       have store\n");
+                lg_errs() << "       have store\n";
                 break;
               }
             }
           }
           if (map_reside_value_info.find(in) != map_reside_value_info.end()) {
             to_be_used = true;
-            fprintf(stderr, "       reside_value\n");
+            lg_errs() << "       reside_value\n";
           }
-          name = module::getName(in).str();
           if (!to_be_used) {
-            lmem_alloc_ptr->free(convert_name_to_key(name, it2.slice_idx), &vec_pre_ts_free_mem);
-          } else {
-            fprintf(stderr, "        not need to free:%s\n", name.c_str());
+            lmem_alloc_ptr->free(lmem_key_t(in, it2.slice_idx), &vec_pre_ts_free_mem);
+          } else if (detail_log) {
+            lg_errs() << llvm::format("        not need to free:%s\n", module::getName(in).str().c_str());
           }
         }
 
         for (auto it3: it2.ada_var_for_free_mem) {//无需真的store搬出去，后面的其他load或op输出直接分配使用这些区域即可
-          name = module::getName(it3.value).str();
           if (it3.info.mode2&TIMESTEP2_STORE_ONLY_FREE && it3.var_value == 1) {
-            lmem_alloc_ptr->free(convert_name_to_key(name, it3.slice_idx));
+            lmem_alloc_ptr->free(lmem_key_t(it3.value, it3.slice_idx));
           }
         }
 
         if (buffer_size > 0) {
-          name = module::getName(outs[0]).str();
-          lmem_alloc_ptr->free(convert_name_to_key(name + "_buffer", it2.slice_idx), &vec_pre_ts_free_mem);
+          lmem_alloc_ptr->free(lmem_key_t(outs[0], it2.slice_idx, true), &vec_pre_ts_free_mem);
         }
       }
 
       if (vec_pre_ts_free_mem_pre.size() > 0 && !have_mem_dependent) {
-        fprintf(stderr, "        ts:%d and ts:%d no mem dependent\n", i, i-1);
+        lg_errs() << llvm::format("        ts:%d and ts:%d no mem dependent\n", i, i-1);
         // timestep_table_new[i].can_merge = true; //todo fix me
       }
     }
 
-    fprintf(stderr, "  deal dma store:\n");
+    lg_errs() << "  deal dma store:\n";
     if (i > 1) {
       for (auto it: timestep_table_new[i].vec_ts_var) {//先store，后load //应该在最后store，本ts store时也不能给本时隙的load用
-        name = module::getName(it.value).str();
         if (it.info.mode2&TIMESTEP2_STORE && it.var_value == 1) {
-          lmem_alloc_ptr->free(convert_name_to_key(name, it.slice_idx), &vec_pre_ts_free_mem);
+          lmem_alloc_ptr->free(lmem_key_t(it.value, it.slice_idx), &vec_pre_ts_free_mem);
         }
         if (it.info.mode2&TIMESTEP2_STORE_AND_LOAD && it.var_value == 1) {
-          if (mapILPVarInfo[it.varName].mode == 0) {
-            lmem_alloc_ptr->free(convert_name_to_key(name, it.slice_idx), &vec_pre_ts_free_mem);
+          if (mapILPVarInfo[it.var_id].mode == 0) {
+            lmem_alloc_ptr->free(lmem_key_t(it.value, it.slice_idx), &vec_pre_ts_free_mem);
           }
         }
       }
@@ -9,6 +9,7 @@
 
 #include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/LayerGroupUtil.h"
 #include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/LgPass.h"
+#include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/NsecsSearch.h"
 #include "tpu_mlir/Support/MathUtils.h"
 #include "llvm/Support/FormatVariadic.h"
 
@@ -22,6 +23,25 @@ using namespace tpu_mlir::backend;
 namespace tpu_mlir {
 namespace tpu {
 
+static thread_local llvm::raw_ostream *lg_log_stream = nullptr;
+
+llvm::raw_ostream &lg_errs() {
+  return lg_log_stream ? *lg_log_stream : llvm::errs();
+}
+
+LgLogBuffer::LgLogBuffer() : os_(buffer_), prev_(lg_log_stream) {
+  lg_log_stream = &os_;
+}
+
+LgLogBuffer::~LgLogBuffer() { lg_log_stream = prev_; }
+
+std::string LgLogBuffer::take() {
+  os_.flush();
+  std::string log;
+  log.swap(buffer_);
+  return log;
+}
+
 bool isLgSupport(Operation *op) {
   bool res = false;
   if (isa<top::WeightOp, top::InputOp>(op)) {
@@ -241,6 +261,9 @@ bool init_group_data_secs(const LgInfo &lg_info, shape_secs_t &shape_secs,
     total_size += lg_op.getBufferSize(in0_lmem_bytes, out0_lmem_bytes, in_n,
                                       in_c, in_h, in_d, in_w, out_n, out_c,
                                       out_h, out_d, out_w, lg_info.type);
+    // weights that are not allowed to split stay whole in every secs, except
+    // c is split
+    int64_t unsplit_size = 0;
     for (size_t i = 1; i < ins.size(); ++i) {
       if ((module::isTrain() && !isa<tpu::AddOp, tpu::ConcatOp>(op)) ||
           module::isWeight(ins[i])) {
@@ -252,6 +275,11 @@ bool init_group_data_secs(const LgInfo &lg_info, shape_secs_t &shape_secs,
             Arch::get_weight_lmem_bytes(ins[i], lg_info.type, eu_align);
         total_size += w_size;
         value_size.push_back(std::make_pair(ins[i], (w_size + 63) / 64 * 64));
+        auto weight_op =
+            dyn_cast_or_null<top::WeightOp>(ins[i].getDefiningOp());
+        if (weight_op && weight_op.getAllowSplitAttr() == nullptr) {
+          unsplit_size += w_size;
+        }
       } else {
         module::getNCDHW(ins[i], in_n, in_c, in_d, in_h, in_w, lg_info.type);
         total_size +=
@@ -264,6 +292,11 @@ bool init_group_data_secs(const LgInfo &lg_info, shape_secs_t &shape_secs,
       total_size += Arch::get_tensor_lmem_bytes(outs[i], out_n, out_c, out_d,
                                                 out_h, out_w);
     }
+    if (lg_info.type != GROUP_MM && lg_info.type != GROUP_SMALL_C &&
+        unsplit_size >= Arch::LMEM_BYTES) {
+      // no split can fit this op
+      return false;
+    }
 
     // Need consider different backends
     int64_t total_secs = ceiling_func(total_size, Arch::LMEM_BYTES);
@@ -494,6 +527,22 @@ void assign_dhwsecs(const LgInfo &lg_info, shape_secs_t &shape_secs,
   dhw_secs = shape_secs.dsecs * shape_secs.hsecs * shape_secs.wsecs;
 }
 
+// lmem secs needed when n is split into nsecs, 0 if time step is empty and
+// -1 if slices are invalid
+static int64_t get_nsecs_split_max_secs(BasicTimeStepPtr time_step,
+                                        const LgInfo &lg_info,
+                                        shape_secs_t &shape_secs,
+                                        int64_t nsecs) {
+  auto &tensor_infos = time_step->get_tensor_infos();
+  shape_secs.nsecs = nsecs;
+  tensor_infos.clear();
+  if (stripe_mine_max_slice(lg_info, shape_secs, tensor_infos) == false) {
+    return -1;
+  }
+  time_step->update_all_mem_buffer_size(lg_info);
+  return get_split_max_secs(time_step);
+}
+
 bool update_data_split(BasicTimeStepPtr time_step, const LgInfo &lg_info,
                        shape_secs_t &shape_secs) {
   shape_secs.nsecs = 1;
@@ -505,41 +554,37 @@ bool update_data_split(BasicTimeStepPtr time_step, const LgInfo &lg_info,
   auto &tensor_infos = time_step->get_tensor_infos();
   std::vector<std::pair<Operation *, int>> vec_op_hsecs;
   shape_secs_t max_shape_secs = get_group_max_secs(lg_info, vec_op_hsecs);
-  for (int64_t nsec = 1; nsec <= max_shape_secs.nsecs; ++nsec) {
-    shape_secs.nsecs = nsec;
-    tensor_infos.clear();
-    if (stripe_mine_max_slice(lg_info, shape_secs, tensor_infos) == false) {
-      return false;
-    }
-    time_step->update_all_mem_buffer_size(lg_info);
 
-    // update nsecs
-    int64_t total_secs = get_split_max_secs(time_step);
-    if (total_secs == 0) {
-      return false;
-    }
-    shape_secs.nsecs =
-        std::max(shape_secs.nsecs, std::min(max_shape_secs.nsecs, total_secs));
-    if (shape_secs.nsecs > nsec)
-      continue;
+  int64_t total_secs =
+      get_nsecs_split_max_secs(time_step, lg_info, shape_secs, 1);
+  if (total_secs <= 0) {
+    return false;
+  }
+  // tensor infos and buffers are left as of the chosen nsecs
+  int64_t nsec = search_min_nsecs(
+      max_shape_secs.nsecs, total_secs, [&](int64_t nsecs) {
+        return get_nsecs_split_max_secs(time_step, lg_info, shape_secs, nsecs);
+      });
+  if (nsec <= 0) {
+    return false;
+  }
+
+  shape_secs.nsecs =
+      std::max(shape_secs.nsecs, std::min(max_shape_secs.nsecs, total_secs));
+  if (shape_secs.nsecs == nsec) {
     // update csecs
     int64_t cdhw_secs = ceiling_func(total_secs, shape_secs.nsecs);
     shape_secs.csecs =
         std::max(shape_secs.csecs, std::min(max_shape_secs.csecs, cdhw_secs));
     // update d/h/w secs
     int64_t dhw_secs = ceiling_func(cdhw_secs, shape_secs.csecs);
-    if (dhw_secs > 1) {
-      if (shape_secs.nsecs == max_shape_secs.nsecs) {
+    if (dhw_secs <= 1 || shape_secs.nsecs == max_shape_secs.nsecs) {
+      if (dhw_secs > 1) {
         assign_dhwsecs(lg_info, shape_secs, dhw_secs, max_shape_secs);
-      } else {
-        continue;
       }
-    }
-    if (shape_secs.dsecs <= max_shape_secs.dsecs &&
-        shape_secs.hsecs <= max_shape_secs.hsecs &&
-        shape_secs.wsecs <= max_shape_secs.wsecs) {
-      status = true;
-      break;
+      status = shape_secs.dsecs <= max_shape_secs.dsecs &&
+               shape_secs.hsecs <= max_shape_secs.hsecs &&
+               shape_secs.wsecs <= max_shape_secs.wsecs;
     }
   }
 
@@ -1528,7 +1573,7 @@ bool stripe_mine_idx_slice2(const LgInfo &lg_info,
                                tensor_infos, op_set, out_tensor_set);
     if (!ret) {
       fail_op = out_tensor.first.getDefiningOp();
-      llvm::errs() << module::getName(fail_op).str() << " backward_update_slice2 fail"<<"\n";
+      lg_errs() << module::getName(fail_op).str() << " backward_update_slice2 fail"<<"\n";
       return false;
     }
   }
@@ -1617,7 +1662,7 @@ bool backward_gen_ilp_var2(
           dma_cycle = cycle_calculator_->getGdmaCycle(in, info, lg_info.type);
         }
         ilp_timeStep.addTensorCycle(var_pos_info.ts_id, in, dma_cycle);
-        std::vector<std::string> var_names;
+        std::vector<int> var_ids;
         int ts_idx = var_pos_info.start_ts;
         bool small_tensor = false;
         for (auto it : tmp_value_size) {
@@ -1630,15 +1675,16 @@ bool backward_gen_ilp_var2(
           if (var_pos_info.ts_id - ts_idx > max_ahead_or_delay_ts) {
             continue;
           }
+          // vars are referred by id, names are only for the detail log
           std::string var_name;
-          if (is_weight) {
+          if (ilp_timeStep.detail_log && is_weight) {
             var_name =
                 llvm::formatv(
                     "x_weight_{0}_atpos{1}_for{2}_load_{3}bytes_at_ts{4}_{5}",
                     name.c_str(), var_pos_info.ts_id, op_name.c_str(),
                     lmem_bytes, ts_idx, slice_name.c_str())
                     .str();
-          } else {
+          } else if (ilp_timeStep.detail_log) {
             var_name =
                 llvm::formatv("x_grp_input_{0}_atpos{1}_for{2}_load_{3}bytes_"
                               "at_ts{4}_{5}",
@@ -1646,25 +1692,29 @@ bool backward_gen_ilp_var2(
                               lmem_bytes, ts_idx, slice_name.c_str())
                     .str();
           }
-          ilp_timeStep.addBinaryVar(ts_idx, slice_idx, -1, var_name, in, info,
-                                    lmem_bytes);
-          var_names.push_back(var_name);
-          ilp_timeStep.addTimestepGdmaCycle(ts_idx, dma_cycle, var_name);
-          ilp_timeStep.addTimestepMemUse(ts_idx, lmem_bytes, var_names);
+          int var_id = ilp_timeStep.addBinaryVar(
+              ts_idx, slice_idx, -1, var_name, in, info, lmem_bytes);
+          var_ids.push_back(var_id);
+          ilp_timeStep.addTimestepGdmaCycle(ts_idx, dma_cycle, var_id);
+          ilp_timeStep.addTimestepMemUse(ts_idx, lmem_bytes, var_ids);
         }
 
         if (small_tensor) { // 1???������?��?D?����??����?��?��?������???��??��??����D��?������?can_merge��??����������??����o?
-          int var_size = var_names.size();
+          int var_size = var_ids.size();
           if (var_size > 3) {
             for (int i = 0; i < 2; i++) {
-              // ilp_timeStep.setVarExpectValue(var_names[var_size -i -1], 0);
+              // ilp_timeStep.setVarExpectValue(var_ids[var_size -i -1], 0);
             }
           }
         }
         if (is_weight) {
-          ilp_timeStep.addRowConstraint(var_pos_info.ts_id, in, var_names);
+          ilp_timeStep.addRowConstraint(var_pos_info.ts_id, in, var_ids);
         } else {
-          ilp_timeStep.addRowConstraint(-1, in, var_names);
+          ilp_timeStep.addRowConstraint(-1, in, var_ids);
+        }
+        if (!var_ids.empty()) {
+          // as BasicTimeStep, load at the timestep just before use
+          ilp_timeStep.addVarHint(var_ids.back(), 1);
         }
       } else {
         int producer_pos =
@@ -1700,22 +1750,28 @@ bool backward_gen_ilp_var2(
       }
 
       int pre_user_pos = var_pos_info.ts_id, dma_cycle;
-      std::vector<std::string> all_store_varnames;
-      std::string ada_var_name;
+      std::vector<int> all_store_var_ids;
+      int ada_var_id = -1;
       MPVariable *x = nullptr;
       int idx = 0;
       bool first_user = true;
       if (map_user_pos.size() > 0) {
         std::map<MPVariable *, std::vector<std::pair<int, MPVariable *>>>
             map_x_var_items;
+        // the mem use of every user refers to the ada var set after the loop
+        ada_var_id = ilp_timeStep.addVarInfo(ilp_var_info());
         for (auto it : map_user_pos) {
           LLVM_DEBUG(llvm::dbgs() << "process " << idx << "th user\n";);
           auto user_pos = it.first;
           auto user = it.second;
           auto user_name = module::getName(user).str();
           //?����??����|���訢?��?��?
-          ada_var_name = llvm::formatv("ada_var_for_{0}_atpos{1}_for_user{1}",
-                                       name.c_str(), var_pos_info.ts_id, idx);
+          std::string ada_var_name;
+          if (ilp_timeStep.detail_log) {
+            ada_var_name =
+                llvm::formatv("ada_var_for_{0}_atpos{1}_for_user{1}",
+                              name.c_str(), var_pos_info.ts_id, idx);
+          }
           x = ilp_timeStep.solver->MakeIntVar(0, 1, ada_var_name);
           map_x_var_items[x] = std::vector<std::pair<int, MPVariable *>>();
           // op??��D1????����?��?user?��resnet2D2?��??����??��??��D2??������2??op�ꡧopo��?����|user??op2??������2??op��?2???��?????��??t
@@ -1735,57 +1791,50 @@ bool backward_gen_ilp_var2(
               LLVM_DEBUG(llvm::dbgs() << "full_slice_bytes:" << full_slice_bytes
                                       << ", dma_cycle:" << dma_cycle << "\n";);
             }
-            std::vector<std::string> var_names;
-            std::vector<std::pair<std::string, int>> store_var_names;
+            std::vector<int> var_ids;
+            std::vector<std::pair<int, int>> store_var_ids;
             LLVM_DEBUG(llvm::dbgs()
                            << "define store_var, ts_idx from "
                            << pre_user_pos + 1 << " to " << user_pos << "\n";);
             for (int ts_idx = pre_user_pos + 1; ts_idx < user_pos; ts_idx++) {
-              std::string var_name =
-                  llvm::formatv("x_tensor_{0}_atpos{1}_store_{2}byte_at_ts{3}_{"
-                                "4}_for_consumer",
-                                name.c_str(), var_pos_info.ts_id,
-                                full_slice_bytes, ts_idx, slice_name.c_str());
-              var_names.push_back(var_name);
-              if (var_names.size() >= max_ahead_or_delay_ts) {
-                break;
-              }
-            }
-            for (int ts_idx = pre_user_pos + 1, offset = 0; ts_idx < user_pos;
-                 ts_idx++) {
-              std::string var_name =
-                  llvm::formatv("x_tensor_{0}_atpos{1}_store_{2}byte_at_ts{3}_{"
-                                "4}_for_consumer",
-                                name.c_str(), var_pos_info.ts_id,
-                                full_slice_bytes, ts_idx, slice_name.c_str());
-              ilp_timeStep.addBinaryVar(ts_idx, slice_idx, 0, var_name, res,
-                                        info, full_slice_bytes);
-              ilp_timeStep.addTimestepGdmaCycle(ts_idx, dma_cycle, var_name);
-              std::vector<std::string> var_names2;
-              for (int n = offset++; n < var_names.size(); n++) {
-                var_names2.push_back(var_names[n]);
+              std::string var_name;
+              if (ilp_timeStep.detail_log) {
+                var_name = llvm::formatv(
+                    "x_tensor_{0}_atpos{1}_store_{2}byte_at_ts{3}_{"
+                    "4}_for_consumer",
+                    name.c_str(), var_pos_info.ts_id, full_slice_bytes, ts_idx,
+                    slice_name.c_str());
               }
-              store_var_names.push_back(std::make_pair(var_name, ts_idx));
-              all_store_varnames.push_back(var_name);
-              ilp_timeStep.addTimestepMemUse(ts_idx, lmem_bytes, var_names2);
+              int var_id = ilp_timeStep.addBinaryVar(
+                  ts_idx, slice_idx, 0, var_name, res, info, full_slice_bytes);
+              ilp_timeStep.addTimestepGdmaCycle(ts_idx, dma_cycle, var_id);
+              var_ids.push_back(var_id);
+              store_var_ids.push_back(std::make_pair(var_id, ts_idx));
+              all_store_var_ids.push_back(var_id);
               if (!first_user) {
                 for (auto itr = map_x_var_items.begin();
                      itr != map_x_var_items.end(); ++itr) {
                   itr->second.push_back(
-                      std::make_pair(1, ilp_timeStep.getMPVarByName(var_name)));
+                      std::make_pair(1, ilp_timeStep.getMPVar(var_id)));
                 }
               }
-              if (offset >= max_ahead_or_delay_ts) {
+              if (var_ids.size() >= max_ahead_or_delay_ts) {
                 break;
               }
             }
+            // the tensor stays in lmem until the store var at or after ts_idx
+            for (int n = 0; n < var_ids.size(); n++) {
+              std::vector<int> var_ids2(var_ids.begin() + n, var_ids.end());
+              ilp_timeStep.addTimestepMemUse(store_var_ids[n].second,
+                                             lmem_bytes, var_ids2);
+            }
 
             //?����?load��?��?
             dma_cycle = cycle_calculator_->getGdmaCycle(res, info, lg_info.type,
                                                         user, 1);
             ilp_timeStep.addTensorCycle(user_pos, res, dma_cycle);
-            var_names.clear();
-            std::vector<std::pair<std::string, int>> load_var_names;
+            var_ids.clear();
+            std::vector<std::pair<int, int>> load_var_ids;
             LLVM_DEBUG(llvm::dbgs()
                            << "define load_var, ts_idx from " << cur_op_idx + 3
                            << " to " << user_pos << "\n";);
@@ -1793,41 +1842,44 @@ bool backward_gen_ilp_var2(
               if (user_pos - ts_idx > max_ahead_or_delay_ts) {
                 continue;
               }
-              std::string var_name =
-                  llvm::formatv("x_producer_tensor_{0}_atpos{1}_for{2}_load_{3}"
-                                "bytes_at_ts{4}_{5}",
-                                name.c_str(), user_pos, user_name.c_str(),
-                                full_slice_bytes, ts_idx, slice_name.c_str());
-              ilp_timeStep.addBinaryVar(ts_idx, slice_idx, 1, var_name, res,
-                                        info, full_slice_bytes);
-              var_names.push_back(var_name);
-              load_var_names.push_back(std::make_pair(var_name, ts_idx));
-              ilp_timeStep.addTimestepGdmaCycle(ts_idx, dma_cycle, var_name);
+              std::string var_name;
+              if (ilp_timeStep.detail_log) {
+                var_name = llvm::formatv(
+                    "x_producer_tensor_{0}_atpos{1}_for{2}_load_{3}"
+                    "bytes_at_ts{4}_{5}",
+                    name.c_str(), user_pos, user_name.c_str(),
+                    full_slice_bytes, ts_idx, slice_name.c_str());
+              }
+              int var_id = ilp_timeStep.addBinaryVar(
+                  ts_idx, slice_idx, 1, var_name, res, info, full_slice_bytes);
+              var_ids.push_back(var_id);
+              load_var_ids.push_back(std::make_pair(var_id, ts_idx));
+              ilp_timeStep.addTimestepGdmaCycle(ts_idx, dma_cycle, var_id);
               ilp_timeStep.addTimestepMemUse(ts_idx, full_slice_bytes,
-                                             var_names);
+                                             var_ids);
             }
 
             std::set<int> ada_var_pos_set;
-            for (auto load_var : load_var_names) {
+            for (auto load_var : load_var_ids) {
               ada_var_pos_set.insert(load_var.second);
             }
-            for (auto store_var : store_var_names) {
+            for (auto store_var : store_var_ids) {
               ada_var_pos_set.insert(store_var.second);
             }
             for (auto pos : ada_var_pos_set) {
               ilp_timeStep.mem_contrains[pos].push_back(
-                  std::make_pair(full_slice_bytes, ada_var_name));
+                  std::make_pair(full_slice_bytes, ada_var_id));
             }
 
             //?����?���訢?��?��?o��?��??store/load��?��?1??��
             coeff_var_items.clear();
-            for (auto load_var : load_var_names) {
-              coeff_var_items.push_back(std::make_pair(
-                  1, ilp_timeStep.getMPVarByName(load_var.first)));
+            for (auto load_var : load_var_ids) {
+              coeff_var_items.push_back(
+                  std::make_pair(1, ilp_timeStep.getMPVar(load_var.first)));
             }
-            for (auto store_var : store_var_names) {
-              coeff_var_items.push_back(std::make_pair(
-                  -1, ilp_timeStep.getMPVarByName(store_var.first)));
+            for (auto store_var : store_var_ids) {
+              coeff_var_items.push_back(
+                  std::make_pair(-1, ilp_timeStep.getMPVar(store_var.first)));
             }
             ilp_timeStep.addConstraint(
                 0, 0, coeff_var_items); //?����?sum(store_var) == sum(load_var)
@@ -1838,24 +1890,23 @@ bool backward_gen_ilp_var2(
             }
 
             coeff_var_items.clear();
-            for (auto store_var : store_var_names) {
-              coeff_var_items.push_back(std::make_pair(
-                  1, ilp_timeStep.getMPVarByName(store_var.first)));
+            for (auto store_var : store_var_ids) {
+              coeff_var_items.push_back(
+                  std::make_pair(1, ilp_timeStep.getMPVar(store_var.first)));
             }
             coeff_var_items.push_back(std::make_pair(1, x));
             ilp_timeStep.addConstraint(
                 1, 1, coeff_var_items); //?����?sum(store_var) + ada_var = 1
 
             coeff_var_items.clear();
-            for (auto load_var : load_var_names) {
-              coeff_var_items.push_back(
-                  std::make_pair(load_var.second,
-                                 ilp_timeStep.getMPVarByName(load_var.first)));
+            for (auto load_var : load_var_ids) {
+              coeff_var_items.push_back(std::make_pair(
+                  load_var.second, ilp_timeStep.getMPVar(load_var.first)));
             }
-            for (auto store_var : store_var_names) {
+            for (auto store_var : store_var_ids) {
               coeff_var_items.push_back(
                   std::make_pair(-1 * store_var.second,
-                                 ilp_timeStep.getMPVarByName(store_var.first)));
+                                 ilp_timeStep.getMPVar(store_var.first)));
             }
             coeff_var_items.push_back(std::make_pair(2, x));
             //?����?2*ada_var + sum(pos*load_var) - sum(pos*store_var) >= 2
@@ -1874,7 +1925,7 @@ bool backward_gen_ilp_var2(
         tensor_info_t info;
         info.mode2 = TIMESTEP2_STORE_ONLY_FREE;
         ts_var_t tmp;
-        tmp.varName = ada_var_name;
+        tmp.var_id = ada_var_id;
         tmp.value = res;
         tmp.info = info;
         tmp.slice_idx = slice_idx;
@@ -1882,30 +1933,30 @@ bool backward_gen_ilp_var2(
         ilp_timeStep.timestep_table_[stay_mem_free_ts_idx]
             .vec_op_infos[0]
             .ada_var_for_free_mem.push_back(tmp);
-        ilp_timeStep.addValueInfo(slice_idx, res, ada_var_name);
+        ilp_timeStep.addValueInfo(slice_idx, res, ada_var_id);
 
         ilp_var_info var_info;
         var_info.ilp_var = x; // todo ????��???2?D����a?
         var_info.tensor_info = info;
         var_info.slice_idx = slice_idx;
         var_info.ts_idx = stay_mem_free_ts_idx;
-        ilp_timeStep.mapILPVarInfo[ada_var_name] = var_info;
+        ilp_timeStep.mapILPVarInfo[ada_var_id] = var_info;
 
-        if (all_store_varnames.size() >
+        if (all_store_var_ids.size() >
             0) { // ��Dstore��?��?��??3��?��|����3?��?store grp out
           if (have_grp_out) { // 3?��?��Dstore grp
                               // out��?����???������1??store��?��??a1��?��?o��????��???3?��?store
                               // grp out��|����
             coeff_var_items.clear();
-            for (auto store_var : all_store_varnames) {
+            for (auto store_var : all_store_var_ids) {
               coeff_var_items.push_back(
-                  std::make_pair(1, ilp_timeStep.getMPVarByName(store_var)));
+                  std::make_pair(1, ilp_timeStep.getMPVar(store_var)));
             }
             ilp_timeStep.addConstraint(1, 1, coeff_var_items);
             have_grp_out = false;
           } else {
             // 3?��??Tstore��?grp out,D����a��?3?��?grp out��?������?
-            ilp_timeStep.addNewOutIntoReturnOp(all_store_varnames, res);
+            ilp_timeStep.addNewOutIntoReturnOp(all_store_var_ids, res);
           }
         }
       }
@@ -1920,41 +1971,39 @@ bool backward_gen_ilp_var2(
         int dma_cycle =
             cycle_calculator_->getGdmaCycle(res, info, lg_info.type);
         // ilp_timeStep.addTensorCycle(var_pos_info.ts_id, res, dma_cycle);
-        std::vector<std::string> var_names;
+        std::vector<int> var_ids;
+        std::vector<int> var_ts_idx;
         // ilp_timeStep.addTensorSize(var_pos_info.ts_id, res, lmem_bytes);
         std::string slice_name = llvm::formatv(
             "slice_{0}_{1}_{2}_{3}_{4}", ncdhw_idx[0], ncdhw_idx[1],
             ncdhw_idx[2], ncdhw_idx[3], ncdhw_idx[4]);
-        int ts_idx = var_pos_info.ts_id + 1;
-        int ts_idx2 = ts_idx;
-        for (; ts_idx < var_pos_info.end_ts + 1; ts_idx++) {
-          std::string var_name = llvm::formatv(
-              "x_tensor_{0}_atpos{1}_store_{2}byte_at_ts{3}_{4}", name.c_str(),
-              var_pos_info.ts_id, lmem_bytes, ts_idx, slice_name.c_str());
-          var_names.push_back(var_name);
-          if (var_names.size() >= max_ahead_or_delay_ts) {
-            break;
-          }
-        }
-        ts_idx = ts_idx2;
-        for (int offset = 0; ts_idx < var_pos_info.end_ts + 1; ts_idx++) {
-          std::string var_name = llvm::formatv(
-              "x_tensor_{0}_atpos{1}_store_{2}byte_at_ts{3}_{4}", name.c_str(),
-              var_pos_info.ts_id, lmem_bytes, ts_idx, slice_name.c_str());
-          ilp_timeStep.addBinaryVar(ts_idx, slice_idx, -1, var_name, res, info,
-                                    lmem_bytes);
-          ilp_timeStep.addTimestepGdmaCycle(ts_idx, dma_cycle, var_name);
-          std::vector<std::string> var_names2;
-          for (int n = offset++; n < var_names.size(); n++) {
-            var_names2.push_back(var_names[n]);
+        for (int ts_idx = var_pos_info.ts_id + 1;
+             ts_idx < var_pos_info.end_ts + 1; ts_idx++) {
+          std::string var_name;
+          if (ilp_timeStep.detail_log) {
+            var_name = llvm::formatv(
+                "x_tensor_{0}_atpos{1}_store_{2}byte_at_ts{3}_{4}",
+                name.c_str(), var_pos_info.ts_id, lmem_bytes, ts_idx,
+                slice_name.c_str());
           }
-          ilp_timeStep.addTimestepMemUse(ts_idx, lmem_bytes, var_names2);
-          if (offset >= max_ahead_or_delay_ts) {
+          int var_id = ilp_timeStep.addBinaryVar(
+              ts_idx, slice_idx, -1, var_name, res, info, lmem_bytes);
+          ilp_timeStep.addTimestepGdmaCycle(ts_idx, dma_cycle, var_id);
+          var_ids.push_back(var_id);
+          var_ts_idx.push_back(ts_idx);
+          if (var_ids.size() >= max_ahead_or_delay_ts) {
             break;
           }
         }
-        if (var_names.size() > 0) {
-          ilp_timeStep.addRowConstraint(-1, res, var_names);
+        // the tensor stays in lmem until the store var at or after ts_idx
+        for (int n = 0; n < var_ids.size(); n++) {
+          std::vector<int> var_ids2(var_ids.begin() + n, var_ids.end());
+          ilp_timeStep.addTimestepMemUse(var_ts_idx[n], lmem_bytes, var_ids2);
+        }
+        if (var_ids.size() > 0) {
+          ilp_timeStep.addRowConstraint(-1, res, var_ids);
+          // as BasicTimeStep, store at the timestep just after produce
+          ilp_timeStep.addVarHint(var_ids.front(), 1);
         }
       }
     }
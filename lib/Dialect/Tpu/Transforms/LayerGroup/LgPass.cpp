@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/LgPass.h"
+#include "tpu_mlir/Backend/BM168x/BM168x.h"
 #include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/LayerGroupUtil.h"
 
 namespace tpu_mlir {
@@ -18,6 +19,8 @@ LgOptions LgPass::OPTIONS = {
     /*opt*/ 0,
     /*group_by_cores*/ false,
     /*nnvlc_mode*/ NnvlcMode::NONE,
+    /*cost_model*/ CostModel::EXACT,
+    /*ilp_time_limit*/ 0,
     };
 
 void LgPassIR::clear() {
@@ -47,6 +50,11 @@ void LgPassManager::run(LgPassIR *pass_ir) {
     generate_fake_global_addr(op);
     set_fake_local_layer_param(op, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1);
   }
+  // cycle queries of the passes only count commands, so forbid storing them
+  // once here instead of in every query, which may run concurrently
+  if (!module::isCV18xx()) {
+    backend::BM168x::instance()->set_command_issue_flag(false);
+  }
 
   for (size_t i = 0; i < this->passes.size(); i++) {
     PASS_RUN(this->passes[i]);
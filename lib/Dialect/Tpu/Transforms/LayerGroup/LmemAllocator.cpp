@@ -87,7 +87,7 @@ static bool is_buffer_used_by_gdma(const mem_buffer_key_t &buffer_key,
       if (tensor.first == buffer_key.value &&
           is_lmem_ldst(tensor.second.mode)) {
         if (is_npu_use && tensor.second.mode != TIMESTEP_STORE) {
-          llvm::errs() << "tensor is loaded and used by npu simultaneously in "
+          lg_errs() << "tensor is loaded and used by npu simultaneously in "
                           "timestep\n";
           exit(-1);
         }
@@ -164,13 +164,17 @@ static inline void update_shape_secs(const LgInfo &lg_info,
   }
 }
 
-void LmemAllocator::find_used_banks(std::set<int64_t> &used_banks,
+static inline bool is_bank_set(bank_mask_t banks, int64_t bank_idx) {
+  return (banks >> bank_idx) & 1;
+}
+
+void LmemAllocator::find_used_banks(bank_mask_t &used_banks,
                                     int64_t lmem_addr, int64_t lmem_size) {
   int64_t bank_size = Arch::LMEM_BANK_BYTES;
   int64_t start_bank = lmem_addr / bank_size;
   int64_t end_bank = (lmem_addr + lmem_size - 1) / bank_size;
   for (int64_t i = start_bank; i <= end_bank; ++i) {
-    used_banks.insert(i);
+    used_banks |= (bank_mask_t)1 << i;
   }
 }
 
@@ -481,20 +485,34 @@ MemBlock LmemAllocator::find_avail_lmem_location(
     avail_space_t &avail_space, const mem_buffer_key_t &buffer_key,
     const mem_buffer_value_t &buffer_value) {
 
-  // refine avail_lmems according to exclude_banks
-  MemBlock bank_lmem;
-  std::list<MemBlock> avail_lmems_tmp = avail_space.avail_lmems;
-  for (auto bank_idx : avail_space.exclude_banks) {
-    bank_lmem.first = bank_idx * Arch::LMEM_BANK_BYTES;
-    bank_lmem.second = Arch::LMEM_BANK_BYTES;
-    update_avail_lmems(avail_lmems_tmp, bank_lmem);
-  }
-
+  // walk the pieces of avail_lmems that are out of exclude_banks in place,
+  // the first piece large enough is the same as cutting exclude_banks from a
+  // copy of avail_lmems and searching it
+  int64_t bank_size = Arch::LMEM_BANK_BYTES;
+  auto exclude_banks = avail_space.exclude_banks;
   MemBlock alloc_lmem(-1, -1);
-  for (auto avail_iter = avail_lmems_tmp.begin();
-       avail_iter != avail_lmems_tmp.end(); ++avail_iter) {
-    if (avail_iter->second >= buffer_value.size) {
-      alloc_lmem = *avail_iter;
+  for (auto &avail_lmem : avail_space.avail_lmems) {
+    int64_t avail_end = avail_lmem.first + avail_lmem.second;
+    int64_t piece_start = avail_lmem.first;
+    while (piece_start < avail_end) {
+      int64_t bank_idx = piece_start / bank_size;
+      int64_t piece_end = (bank_idx + 1) * bank_size;
+      if (is_bank_set(exclude_banks, bank_idx)) {
+        piece_start = piece_end;
+        continue;
+      }
+      while (piece_end < avail_end &&
+             !is_bank_set(exclude_banks, piece_end / bank_size)) {
+        piece_end += bank_size;
+      }
+      piece_end = std::min(piece_end, avail_end);
+      if (piece_end - piece_start >= buffer_value.size) {
+        alloc_lmem = MemBlock(piece_start, piece_end - piece_start);
+        break;
+      }
+      piece_start = piece_end;
+    }
+    if (alloc_lmem.first != -1) {
       break;
     }
   }
@@ -508,17 +526,24 @@ MemBlock LmemAllocator::find_avail_lmem_location(
 }
 
 void LmemAllocator::update_exclude_banks(
-    std::set<int64_t> &exclude_banks, const mem_buffer_key_t &buffer_key,
+    bank_mask_t &exclude_banks, const mem_buffer_key_t &buffer_key,
     const mem_buffer_value_t &buffer_value,
     const mem_buffer_key_t &recent_buffer_allocated,
     const mem_buffer_value_t &recent_buffer_value,
     BasicTimeStepPtr &time_step) {
+  // nothing to add if the banks of recent buffer are all excluded
+  bank_mask_t recent_banks = 0;
+  find_used_banks(recent_banks, recent_buffer_value.addr,
+                  recent_buffer_value.size);
+  if ((exclude_banks & recent_banks) == recent_banks) {
+    return;
+  }
+
   int64_t timestep_num = time_step->get_timestep_num();
 
   bool first_step = true;
   bool is_npu_use, is_gdma_use;
   bool is_recent_used_banks_updated = false;
-  std::set<int64_t> recent_used_banks;
   for (int64_t ts = buffer_value.start_ts;
        (ts != ((buffer_value.end_ts + 1) % timestep_num)) || first_step;
        ts = (ts + 1) % timestep_num) {
@@ -538,8 +563,6 @@ void LmemAllocator::update_exclude_banks(
         }
         if (is_relate_op(recent_buffer_allocated, op, ts,
                          recent_buffer_value.start_ts)) {
-          find_used_banks(recent_used_banks, recent_buffer_value.addr,
-                          recent_buffer_value.size);
           is_recent_used_banks_updated = true;
           break;
         }
@@ -550,8 +573,6 @@ void LmemAllocator::update_exclude_banks(
     // used by npu
     if (!is_recent_used_banks_updated && is_npu_use &&
         is_buffer_used_by_gdma(recent_buffer_allocated, cur_tensors, false)) {
-      find_used_banks(recent_used_banks, recent_buffer_value.addr,
-                      recent_buffer_value.size);
       is_recent_used_banks_updated = true;
     }
 
@@ -560,7 +581,9 @@ void LmemAllocator::update_exclude_banks(
     }
   }
 
-  exclude_banks.insert(recent_used_banks.begin(), recent_used_banks.end());
+  if (is_recent_used_banks_updated) {
+    exclude_banks |= recent_banks;
+  }
 }
 
 MemBlock LmemAllocator::global_find_avail_lmem_localtion(
@@ -744,6 +767,7 @@ void init_buffer_avail_space(BufferAvailSpace &buffer_avail_space,
        ++buflist_it) {
     avail_space.avail_lmems.clear();
     avail_space.avail_lmems.push_back(std::make_pair(0, Arch::LMEM_BYTES));
+    avail_space.exclude_banks = 0;
     buffer_avail_space.insert(std::make_pair(buflist_it->first, avail_space));
   }
 }
@@ -768,6 +792,7 @@ bool assignL2memAddr(const LgInfo &lg_info, BasicTimeStepPtr &time_step) {
 bool LmemAllocator::assignLmemAddr(const LgInfo &lg_info,
                                    BasicTimeStepPtr &time_step,
                                    const shape_secs_t &shape_secs) {
+  assert(Arch::LMEM_BANKS <= 64 && "bank_mask_t holds no more than 64 banks");
   time_step->update_all_mem_buffer_size(lg_info);
   bool one_loop =
       (shape_secs.nsecs == 1 && shape_secs.hsecs == 1 &&
@@ -835,7 +860,7 @@ bool LmemAllocator::assignLmemAddr(const LgInfo &lg_info,
       membuf_list.erase(tgt_buflist_it);
       buffer_avail_space.erase(tgt_buflist_it->first);
     } else {
-      llvm::errs() << "Cannot find local memory location for memory buffers\n";
+      lg_errs() << "Cannot find local memory location for memory buffers\n";
       return false;
     }
   }
@@ -934,7 +959,7 @@ public:
             pass_ir->lg_infos[i], pass_ir->time_steps[i],
             pass_ir->shape_secs[i]);
         if (!ret) {
-          llvm::errs() << "local memory allocate failed for group " << i
+          lg_errs() << "local memory allocate failed for group " << i
                        << "\n";
           return false;
         }
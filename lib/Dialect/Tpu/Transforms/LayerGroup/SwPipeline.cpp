@@ -51,7 +51,7 @@ int64_t SoftwarePipeline::software_pipeline_schedule(
   // assert the first and the last timestep only contain tensor gdma
   auto first_row_iter = timestep_table.begin();
   if (!(first_row_iter->tpu0_ts_field.empty())) {
-    llvm::errs() << "simple software pipeline schedule assume the first "
+    lg_errs() << "simple software pipeline schedule assume the first "
                     "timestep only contains tensor gdma.";
     exit(-1);
   }
@@ -59,7 +59,7 @@ int64_t SoftwarePipeline::software_pipeline_schedule(
   auto last_row_iter = timestep_table.end();
   last_row_iter--;
   if (!(last_row_iter->tpu0_ts_field.empty())) {
-    llvm::errs() << "simple software pipeline schedule assume the last "
+    lg_errs() << "simple software pipeline schedule assume the last "
                     "timestep only contains tensor gdma.";
     exit(-1);
   }
@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/LmemAllocator.h"
+#include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/LayerGroupUtil.h"
 #include "tpu_mlir/Support/MathUtils.h"
 
 using namespace tpu_mlir;
@@ -423,7 +424,7 @@ static void merge_timesteps(const LgInfo &lg_info, BasicTimeStepPtr &time_step,
     time_step->reset_timestep(p_layers, p_tensors, p_lmem);
   }
   for (auto iter : ss) {
-    llvm::errs() << iter << "\n";
+    lg_errs() << iter << "\n";
   }
 }
 
@@ -481,9 +482,9 @@ static void reassign_timestep_tensors(const LgInfo &lg_info,
         update_cycle_info(total_gdma_cycle_v, total_layer_cycle_v, time_step,
                           shape_secs);
         if (print_log) {
-          llvm::errs() << "===group_idx: " << group_idx;
+          lg_errs() << "===group_idx: " << group_idx;
         }
-        llvm::errs() << "move tensor " << module::getName(sel_tensor.first)
+        lg_errs() << "move tensor " << module::getName(sel_tensor.first)
                      << " from timestep " << src_ts << " to timestep "
                      << dst_ts;
         print_log = false;
@@ -574,11 +575,11 @@ static void reassign_timestep_tensors(const LgInfo &lg_info,
       update_cycle_info(total_gdma_cycle_v, total_layer_cycle_v, time_step,
                         shape_secs);
       if (print_log) {
-        llvm::errs() << "===group idx: " << group_idx;
+        lg_errs() << "===group idx: " << group_idx;
       }
-      llvm::errs() << "move tensor " << module::getName(src_tensor.first)
+      lg_errs() << "move tensor " << module::getName(src_tensor.first)
                    << " from timestep " << src_ts << " to timestep " << dst_ts;
-      llvm::errs() << "move tensor " << module::getName(dst_tensor.first)
+      lg_errs() << "move tensor " << module::getName(dst_tensor.first)
                    << " from timestep " << dst_ts << " to timestep " << src_ts;
       print_log = false;
       break;
@@ -237,8 +237,6 @@ void TimeStepMethod::memory_aware_timestep_assignment(BasicTimeStep *time_step,
   ValueIntMap tensor_to_bufsize;
   std::vector<std::list<GdmaElt>> tensor_timesteps;
 
-// remove it after pid_node is extracted
-#pragma omp critical(get_cycle)
   get_timestep_cycle_slack(time_step, lg_info, tensor_to_cycle,
                            tensor_to_bufsize, tensor_timesteps,
                            timestep_cycle_slack);
@@ -412,7 +410,7 @@ public:
       bool ret =
           time_step->assignTimeStep(pass_ir->lg_infos[i], shape_secs, true);
       if (!ret) {
-        llvm::errs() << "time step assign failed for group " << i << "\n";
+        lg_errs() << "time step assign failed for group " << i << "\n";
         return false;
       }
       pass_ir->time_steps.emplace_back(time_step);
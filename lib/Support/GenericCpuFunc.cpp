@@ -1087,68 +1087,71 @@ void ROIPoolingFunc::invoke() {
   int width = input_shape[3];
   int num_rois = roi_shape[2];
 
-  for (int b = 0; b < batch; ++b) {
-    auto batched_rois = rois + b * num_rois * 5;
-    auto batched_output =
-        output_data + b * num_rois * channel * pooled_h * pooled_w;
-    for (int n = 0; n < num_rois; ++n) {
-      int roi_batch_ind = batched_rois[0];
-      int roi_start_w = std::round(batched_rois[1] * spatial_scale);
-      int roi_start_h = std::round(batched_rois[2] * spatial_scale);
-      int roi_end_w = std::round(batched_rois[3] * spatial_scale);
-      int roi_end_h = std::round(batched_rois[4] * spatial_scale);
-      assert(roi_batch_ind < batch);
-
-      int roi_height = std::max(roi_end_h - roi_start_h + 1, 1);
-      int roi_width = std::max(roi_end_w - roi_start_w + 1, 1);
-      const float bin_size_h =
-          static_cast<float>(roi_height) / static_cast<float>(pooled_h);
-      const float bin_size_w =
-          static_cast<float>(roi_width) / static_cast<float>(pooled_w);
-
-      float *batch_data = input_data + roi_batch_ind * channel * height * width;
-
-      for (int c = 0; c < channel; ++c) {
-        for (int ph = 0; ph < pooled_h; ++ph) {
-          for (int pw = 0; pw < pooled_w; ++pw) {
-            // Compute pooling region for this output unit:
-            //  start (included) = floor(ph * roi_height / pooled_height_)
-            //  end (excluded) = ceil((ph + 1) * roi_height / pooled_height_)
-            int hstart = static_cast<int>(
-                std::floor(static_cast<float>(ph) * bin_size_h));
-            int wstart = static_cast<int>(
-                std::floor(static_cast<float>(pw) * bin_size_w));
-            int hend = static_cast<int>(
-                std::ceil(static_cast<float>(ph + 1) * bin_size_h));
-            int wend = static_cast<int>(
-                std::ceil(static_cast<float>(pw + 1) * bin_size_w));
-
-            hstart = std::min(std::max(hstart + roi_start_h, 0), height);
-            hend = std::min(std::max(hend + roi_start_h, 0), height);
-            wstart = std::min(std::max(wstart + roi_start_w, 0), width);
-            wend = std::min(std::max(wend + roi_start_w, 0), width);
-
-            bool is_empty = (hend <= hstart) || (wend <= wstart);
-
-            const int pool_index = ph * pooled_w + pw;
-            if (is_empty) {
-              batched_output[pool_index] = 0;
-            }
+  int num_task = batch * num_rois;
+#pragma omp parallel for schedule(static, omp_schedule(num_task))
+  for (int t = 0; t < num_task; ++t) {
+    auto batched_rois = rois + t * 5;
+    auto batched_output = output_data + t * channel * pooled_h * pooled_w;
+    int roi_batch_ind = batched_rois[0];
+    int roi_start_w = std::round(batched_rois[1] * spatial_scale);
+    int roi_start_h = std::round(batched_rois[2] * spatial_scale);
+    int roi_end_w = std::round(batched_rois[3] * spatial_scale);
+    int roi_end_h = std::round(batched_rois[4] * spatial_scale);
+    assert(roi_batch_ind < batch);
+
+    int roi_height = std::max(roi_end_h - roi_start_h + 1, 1);
+    int roi_width = std::max(roi_end_w - roi_start_w + 1, 1);
+    const float bin_size_h =
+        static_cast<float>(roi_height) / static_cast<float>(pooled_h);
+    const float bin_size_w =
+        static_cast<float>(roi_width) / static_cast<float>(pooled_w);
+
+    // Compute pooling region for each output unit, shared by all channels:
+    //  start (included) = floor(ph * roi_height / pooled_height_)
+    //  end (excluded) = ceil((ph + 1) * roi_height / pooled_height_)
+    std::vector<int> hstart(pooled_h), hend(pooled_h);
+    for (int ph = 0; ph < pooled_h; ++ph) {
+      int start = static_cast<int>(
+          std::floor(static_cast<float>(ph) * bin_size_h));
+      int end = static_cast<int>(
+          std::ceil(static_cast<float>(ph + 1) * bin_size_h));
+      hstart[ph] = std::min(std::max(start + roi_start_h, 0), height);
+      hend[ph] = std::min(std::max(end + roi_start_h, 0), height);
+    }
+    std::vector<int> wstart(pooled_w), wend(pooled_w);
+    for (int pw = 0; pw < pooled_w; ++pw) {
+      int start = static_cast<int>(
+          std::floor(static_cast<float>(pw) * bin_size_w));
+      int end = static_cast<int>(
+          std::ceil(static_cast<float>(pw + 1) * bin_size_w));
+      wstart[pw] = std::min(std::max(start + roi_start_w, 0), width);
+      wend[pw] = std::min(std::max(end + roi_start_w, 0), width);
+    }
 
-            for (int h = hstart; h < hend; ++h) {
-              for (int w = wstart; w < wend; ++w) {
-                const int index = h * width + w;
-                if (batch_data[index] > batched_output[pool_index]) {
-                  batched_output[pool_index] = batch_data[index];
-                }
+    float *batch_data = input_data + roi_batch_ind * channel * height * width;
+
+    for (int c = 0; c < channel; ++c) {
+      for (int ph = 0; ph < pooled_h; ++ph) {
+        for (int pw = 0; pw < pooled_w; ++pw) {
+          bool is_empty = (hend[ph] <= hstart[ph]) || (wend[pw] <= wstart[pw]);
+
+          const int pool_index = ph * pooled_w + pw;
+          if (is_empty) {
+            batched_output[pool_index] = 0;
+          }
+
+          for (int h = hstart[ph]; h < hend[ph]; ++h) {
+            for (int w = wstart[pw]; w < wend[pw]; ++w) {
+              const int index = h * width + w;
+              if (batch_data[index] > batched_output[pool_index]) {
+                batched_output[pool_index] = batch_data[index];
               }
             }
           }
         }
-        batch_data += height * width;
-        batched_output += pooled_h * pooled_w;
       }
-      batched_rois += 5;
+      batch_data += height * width;
+      batched_output += pooled_h * pooled_w;
     }
   }
 }
@@ -1297,8 +1300,8 @@ void RoiAlignFunc::invoke() {
     int index_n = i * IC * pooled_size;
     for (int c = 0; c < IC; ++c) {
       int index_n_c = index_n + c * pooled_size;
+      const float *feat = input + (batch_idx * IC + c) * input_size;
       for (int p = 0; p < pooled_size; ++p) {
-        const float *feat = input + (batch_idx * IC + c) * input_size;
         reducer.init();
         for (int s = 0; s < sample_size; ++s) {
           const auto &pc = pre_calc[p * sample_size + s];
@@ -2366,79 +2369,60 @@ static void my_interp(const int channels, const float *data1, const int x1,
                       const int Height1, const int Width1, float *data2,
                       const int x2, const int y2, const int height2,
                       const int width2, const int Height2, const int Width2) {
-  bool packed = false;
-
   assert(x1 >= 0 && y1 >= 0 && height1 > 0 && width1 > 0 && x2 >= 0 &&
          y2 >= 0 && height2 > 0 && width2 > 0);
   assert(Width1 >= width1 + x1 && Height1 >= height1 + y1 &&
          Width2 >= width2 + x2 && Height2 >= height2 + y2);
 
-  // special case: just copy
-  if (height1 == height2 && width1 == width2) {
-    for (int h2 = 0; h2 < height2; ++h2) {
-      const int h1 = h2;
-      for (int w2 = 0; w2 < width2; ++w2) {
-        const int w1 = w2;
-        if (packed) {
-          const float *pos1 =
-              &data1[channels * ((y1 + h1) * Width1 + (x1 + w1))];
-          float *pos2 = &data2[channels * ((y2 + h2) * Width2 + (x2 + w2))];
-          for (int c = 0; c < channels; ++c) {
-            pos2[0] = pos1[0];
-            pos1++;
-            pos2++;
-          }
-        } else {
-          const float *pos1 = &data1[(y1 + h1) * Width1 + (x1 + w1)];
-          float *pos2 = &data2[(y2 + h2) * Width2 + (x2 + w2)];
-          for (int c = 0; c < channels; ++c) {
-            pos2[0] = pos1[0];
-            pos1 += Width1 * Height1;
-            pos2 += Width2 * Height2;
-          }
-        }
-      }
-    }
-    return;
-  }
   const float rheight =
       (height2 > 1) ? static_cast<float>(height1 - 1) / (height2 - 1) : 0.f;
   const float rwidth =
       (width2 > 1) ? static_cast<float>(width1 - 1) / (width2 - 1) : 0.f;
+  // same size is a plain copy, ratio 1 gives lambda 0 for every point
+  bool copy = height1 == height2 && width1 == width2;
+  // index and weights only depend on h2/w2, compute them once for all channels
+  std::vector<int> h1_idx(height2), h1p_off(height2);
+  std::vector<float> h0_lambda(height2), h1_lambda(height2);
   for (int h2 = 0; h2 < height2; ++h2) {
-    const float h1r = rheight * h2;
+    const float h1r = copy ? h2 : rheight * h2;
     const int h1 = h1r;
-    const int h1p = (h1 < height1 - 1) ? 1 : 0;
-    const float h1lambda = h1r - h1;
-    const float h0lambda = float(1.) - h1lambda;
-    for (int w2 = 0; w2 < width2; ++w2) {
-      const float w1r = rwidth * w2;
-      const int w1 = w1r;
-      const int w1p = (w1 < width1 - 1) ? 1 : 0;
-      const float w1lambda = w1r - w1;
-      const float w0lambda = float(1.) - w1lambda;
-      if (packed) {
-        const float *pos1 = &data1[channels * ((y1 + h1) * Width1 + (x1 + w1))];
-        float *pos2 = &data2[channels * ((y2 + h2) * Width2 + (x2 + w2))];
-        for (int c = 0; c < channels; ++c) {
-          pos2[0] =
-              h0lambda *
-                  (w0lambda * pos1[0] + w1lambda * pos1[channels * w1p]) +
-              h1lambda * (w0lambda * pos1[channels * h1p * Width1] +
-                          w1lambda * pos1[channels * (h1p * Width1 + w1p)]);
-          pos1++;
-          pos2++;
-        }
-      } else {
-        const float *pos1 = &data1[(y1 + h1) * Width1 + (x1 + w1)];
-        float *pos2 = &data2[(y2 + h2) * Width2 + (x2 + w2)];
-        for (int c = 0; c < channels; ++c) {
-          pos2[0] = h0lambda * (w0lambda * pos1[0] + w1lambda * pos1[w1p]) +
-                    h1lambda * (w0lambda * pos1[h1p * Width1] +
-                                w1lambda * pos1[h1p * Width1 + w1p]);
-          pos1 += Width1 * Height1;
-          pos2 += Width2 * Height2;
-        }
+    h1_idx[h2] = (y1 + h1) * Width1;
+    h1p_off[h2] = (h1 < height1 - 1) ? Width1 : 0;
+    h1_lambda[h2] = h1r - h1;
+    h0_lambda[h2] = float(1.) - h1_lambda[h2];
+  }
+  std::vector<int> w1_idx(width2), w1p_off(width2);
+  std::vector<float> w0_lambda(width2), w1_lambda(width2);
+  for (int w2 = 0; w2 < width2; ++w2) {
+    const float w1r = copy ? w2 : rwidth * w2;
+    const int w1 = w1r;
+    w1_idx[w2] = x1 + w1;
+    w1p_off[w2] = (w1 < width1 - 1) ? 1 : 0;
+    w1_lambda[w2] = w1r - w1;
+    w0_lambda[w2] = float(1.) - w1_lambda[w2];
+  }
+#pragma omp parallel for schedule(static, omp_schedule(channels))
+  for (int c = 0; c < channels; ++c) {
+    const float *src = data1 + (int64_t)c * Width1 * Height1;
+    float *dst = data2 + (int64_t)c * Width2 * Height2;
+    for (int h2 = 0; h2 < height2; ++h2) {
+      float *out = dst + (y2 + h2) * Width2 + x2;
+      const float *row = src + h1_idx[h2];
+      if (copy) {
+        memcpy(out, row + x1, width2 * sizeof(float));
+        continue;
+      }
+      const int h1p = h1p_off[h2];
+      const float h0lambda = h0_lambda[h2];
+      const float h1lambda = h1_lambda[h2];
+      for (int w2 = 0; w2 < width2; ++w2) {
+        const float *pos1 = row + w1_idx[w2];
+        const int w1p = w1p_off[w2];
+        const float w0lambda = w0_lambda[w2];
+        const float w1lambda = w1_lambda[w2];
+        out[w2] = h0lambda * (w0lambda * pos1[0] + w1lambda * pos1[w1p]) +
+                  h1lambda * (w0lambda * pos1[h1p] +
+                              w1lambda * pos1[h1p + w1p]);
       }
     }
   }
@@ -2546,66 +2530,56 @@ static void upsampleBilinear(int64_t batch_size, int64_t num_channels,
   int64_t output_width = static_cast<int64_t>(input_width * width_scale);
   int64_t output_height = static_cast<int64_t>(input_height * height_scale);
 
-  for (int64_t n = 0; n < batch_size; ++n) {
-    for (int64_t c = 0; c < num_channels; ++c) {
-      for (int64_t y = 0; y < output_height; ++y) {
-        float in_y =
-            std::min(y / height_scale, static_cast<float>(input_height - 1));
-        in_y = height_scale == 1
-                   ? static_cast<float>(y)
-                   : coordinate_transform(static_cast<float>(y), height_scale,
-                                          static_cast<float>(output_height),
-                                          pytorch);
-        in_y = std::max(0.0f,
-                        std::min(in_y, static_cast<float>(input_height - 1)));
-
-        const int64_t in_y1 =
-            std::min(static_cast<int64_t>(in_y), input_height - 1);
-        const int64_t in_y2 = std::min(in_y1 + 1, input_height - 1);
-        float dy1 = fabs(in_y - in_y1);
-        float dy2 = fabs(in_y - in_y2);
-        if (in_y1 == in_y2) {
-          dy1 = 0.5f;
-          dy2 = 0.5f;
-        }
-
-        const int64_t input_width_mul_y1 = input_width * in_y1;
-        const int64_t input_width_mul_y2 = input_width * in_y2;
-
-        for (int64_t x = 0; x < output_width; ++x) {
-          float in_x =
-              std::min(x / width_scale, static_cast<float>(input_width - 1));
-          in_x = width_scale == 1
-                     ? static_cast<float>(x)
-                     : coordinate_transform(static_cast<float>(x), width_scale,
-                                            static_cast<float>(output_width),
-                                            pytorch);
-          in_x = std::max(0.0f,
-                          std::min(in_x, static_cast<float>(input_width - 1)));
-
-          const int64_t in_x1 =
-              std::min(static_cast<int64_t>(in_x), input_width - 1);
-          const int64_t in_x2 = std::min(in_x1 + 1, input_width - 1);
-
-          float dx1 = std::abs(in_x - in_x1);
-          float dx2 = std::abs(in_x - in_x2);
-          if (in_x1 == in_x2) {
-            dx1 = 0.5f;
-            dx2 = 0.5f;
-          }
+  // source index and weights of each output row/column are the same for all
+  // channels, compute them once
+  auto pre_calc = [pytorch](int64_t out_len, int64_t in_len, float scale,
+                            std::vector<int64_t> &idx1,
+                            std::vector<int64_t> &idx2, std::vector<float> &d1,
+                            std::vector<float> &d2) {
+    idx1.resize(out_len);
+    idx2.resize(out_len);
+    d1.resize(out_len);
+    d2.resize(out_len);
+    for (int64_t i = 0; i < out_len; ++i) {
+      float in_i = scale == 1 ? static_cast<float>(i)
+                              : coordinate_transform(static_cast<float>(i),
+                                                     scale,
+                                                     static_cast<float>(out_len),
+                                                     pytorch);
+      in_i = std::max(0.0f, std::min(in_i, static_cast<float>(in_len - 1)));
+      idx1[i] = std::min(static_cast<int64_t>(in_i), in_len - 1);
+      idx2[i] = std::min(idx1[i] + 1, in_len - 1);
+      d1[i] = std::abs(in_i - idx1[i]);
+      d2[i] = std::abs(in_i - idx2[i]);
+      if (idx1[i] == idx2[i]) {
+        d1[i] = 0.5f;
+        d2[i] = 0.5f;
+      }
+    }
+  };
+  std::vector<int64_t> in_y1, in_y2, in_x1, in_x2;
+  std::vector<float> dy1, dy2, dx1, dx2;
+  pre_calc(output_height, input_height, height_scale, in_y1, in_y2, dy1, dy2);
+  pre_calc(output_width, input_width, width_scale, in_x1, in_x2, dx1, dx2);
 
-          T X11 = Xdata[input_width_mul_y1 + in_x1];
-          T X21 = Xdata[input_width_mul_y1 + in_x2];
-          T X12 = Xdata[input_width_mul_y2 + in_x1];
-          T X22 = Xdata[input_width_mul_y2 + in_x2];
+  int64_t nc = batch_size * num_channels;
+#pragma omp parallel for schedule(static, omp_schedule(nc))
+  for (int64_t i = 0; i < nc; ++i) {
+    const T *X = Xdata + i * input_height * input_width;
+    T *Y = Ydata + i * output_height * output_width;
+    for (int64_t y = 0; y < output_height; ++y) {
+      const T *X1 = X + input_width * in_y1[y];
+      const T *X2 = X + input_width * in_y2[y];
+      for (int64_t x = 0; x < output_width; ++x) {
+        T X11 = X1[in_x1[x]];
+        T X21 = X1[in_x2[x]];
+        T X12 = X2[in_x1[x]];
+        T X22 = X2[in_x2[x]];
 
-          Ydata[output_width * y + x] =
-              static_cast<T>(dx2 * dy2 * X11 + dx1 * dy2 * X21 +
-                             dx2 * dy1 * X12 + dx1 * dy1 * X22);
-        }
+        Y[output_width * y + x] =
+            static_cast<T>(dx2[x] * dy2[y] * X11 + dx1[x] * dy2[y] * X21 +
+                           dx2[x] * dy1[y] * X12 + dx1[x] * dy1[y] * X22);
       }
-      Xdata += input_height * input_width;
-      Ydata += output_width * output_height;
     }
   }
 }
@@ -2623,17 +2597,22 @@ static void interp_neast(float *input, float *output, int n, int c, int ih,
   int nc = n * c;
   float scale_h = ((float)ih) / oh;
   float scale_w = ((float)iw) / ow;
+  std::vector<int> h_index(oh), w_index(ow);
+  for (int h = 0; h < oh; h++) {
+    h_index[h] = (int)(half_pixel ? std::ceil((h + 0.5) * scale_h - 1.0)
+                                  : h * scale_h);
+  }
+  for (int w = 0; w < ow; w++) {
+    w_index[w] = (int)(half_pixel ? std::ceil((w + 0.5) * scale_w - 1.0)
+                                  : w * scale_w);
+  }
 #pragma omp parallel for schedule(static, omp_schedule(nc))
   for (int i = 0; i < nc; i++) {
     for (int h = 0; h < oh; h++) {
+      const float *in_row = input + i * ih * iw + h_index[h] * iw;
+      float *out_row = output + i * oh * ow + h * ow;
       for (int w = 0; w < ow; w++) {
-        int o_index = i * oh * ow + h * ow + w;
-        int h_resized = (int)(half_pixel ? std::ceil((h + 0.5) * scale_h - 1.0)
-                                         : h * scale_h);
-        int w_resized = (int)(half_pixel ? std::ceil((w + 0.5) * scale_w - 1.0)
-                                         : w * scale_w);
-        int i_index = i * ih * iw + h_resized * iw + w_resized;
-        output[o_index] = input[i_index];
+        out_row[w] = in_row[w_index[w]];
       }
     }
   }
@@ -2672,14 +2651,19 @@ static void interp_asymmetric(float *input, float *output, int n, int c, int ih,
   int nc = n * c;
   float scale_h = (float)ih / oh;
   float scale_w = (float)iw / ow;
+  std::vector<float> fh_arr(oh), fw_arr(ow);
+  for (int h = 0; h < oh; h++) {
+    fh_arr[h] = std::min(h * scale_h, (float)(ih - 1));
+  }
+  for (int w = 0; w < ow; w++) {
+    fw_arr[w] = std::min(w * scale_w, (float)(iw - 1));
+  }
 #pragma omp parallel for schedule(static, omp_schedule(nc))
   for (int i = 0; i < nc; i++) {
     for (int h = 0; h < oh; h++) {
       for (int w = 0; w < ow; w++) {
         int o_index = i * oh * ow + h * ow + w;
-        float fh = std::min(h * scale_h, (float)(ih - 1));
-        float fw = std::min(w * scale_w, (float)(iw - 1));
-        output[o_index] = value(input + i * ih * iw, iw, fh, fw);
+        output[o_index] = value(input + i * ih * iw, iw, fh_arr[h], fw_arr[w]);
       }
     }
   }
@@ -9,6 +9,8 @@
 
 #include "tpu_mlir/Support/LutFunc.h"
 #include "tpu_mlir/Support/CastUtils.h"
+#include <map>
+#include <mutex>
 
 namespace tpu_mlir {
 
@@ -123,6 +125,29 @@ Value create_lookup_table(Operation *owner, const std::vector<int> &table) {
   return top::WeightOp::create(owner, "table", table, table_type);
 }
 
+void lut_int8(const float *input, float *output, int64_t size,
+              const float *table) {
+  // index -128 ~ -1 maps to 128 ~ 255, the same as uint8
+#pragma omp parallel for schedule(static, omp_schedule(size))
+  for (int64_t i = 0; i < size; ++i) {
+    output[i] = table[static_cast<int>(input[i]) & 0xff];
+  }
+}
+
+void lut_int8_per_channel(const float *input, float *output, int64_t outer,
+                          int64_t channel, int64_t inner, const float *table) {
+  int64_t num = outer * channel;
+#pragma omp parallel for schedule(static, omp_schedule(num))
+  for (int64_t idx = 0; idx < num; ++idx) {
+    auto c_table = table + (idx % channel) * 256;
+    auto in = input + idx * inner;
+    auto out = output + idx * inner;
+    for (int64_t i = 0; i < inner; ++i) {
+      out[i] = c_table[static_cast<int>(in[i]) & 0xff];
+    }
+  }
+}
+
 static void gen_bf16_base_table(float start, float end, int table_hw,
                                 float *table, activate_f &func) {
   int half = table_hw / 2;
@@ -198,6 +223,8 @@ void bf16_lut_slope(float *input, float *output, int size, float *base_table,
   float scale = BF16(256.0 / (range_end - range_start));
   float offset = BF16((range_end + range_start) / 2);
 
+  // rnn/norm ops call this per scalar, keep them out of parallel region
+#pragma omp parallel for if (size > 1024) schedule(static, omp_schedule(size))
   for (int i = 0; i < size; ++i) {
     float rescale_bf16_input = bf16_mul(bf16_add(input[i], -offset), scale);
     // get interger part
@@ -319,22 +346,41 @@ void bf16_gen_exponent_mantissa_table(const std::string &name, float *exp_table,
                                       float *mantissa_table, float param0,
                                       float param1) {
   (void)param1;
-  float range_start = -62;
+  // tables only depend on (name, param0), shared by all ops of a compile
+  static std::mutex cache_mutex;
+  static std::map<std::pair<std::string, float>, std::vector<float>> cache;
   int table_hw = 256;
-  if (name == "pow") {
-    bf16_gen_pow(range_start, table_hw, param0, exp_table);
-    bf16_gen_pow_mantissa(table_hw, param0, mantissa_table);
-  } else if (name == "log") {
-    bf16_gen_log(range_start, table_hw, exp_table);
-    bf16_gen_log_mantissa(table_hw, mantissa_table);
-  } else {
-    llvm::errs() << "unsupported lookup table func:" << name << "\n";
-    llvm_unreachable("Error");
+  auto key = std::make_pair(name, param0);
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  auto it = cache.find(key);
+  if (it == cache.end()) {
+    float range_start = -62;
+    std::vector<float> tables(table_hw * 2, 0);
+    if (name == "pow") {
+      bf16_gen_pow(range_start, table_hw, param0, tables.data());
+      bf16_gen_pow_mantissa(table_hw, param0, tables.data() + table_hw);
+    } else if (name == "log") {
+      bf16_gen_log(range_start, table_hw, tables.data());
+      bf16_gen_log_mantissa(table_hw, tables.data() + table_hw);
+    } else {
+      llvm::errs() << "unsupported lookup table func:" << name << "\n";
+      llvm_unreachable("Error");
+    }
+    it = cache.emplace(key, std::move(tables)).first;
   }
+  auto &tables = it->second;
+  std::copy(tables.begin(), tables.begin() + table_hw, exp_table);
+  std::copy(tables.begin() + table_hw, tables.end(), mantissa_table);
 }
 
 void bf16_lut_mantissa(float *input, float *output, int size, float *exp_table,
                        float *mantissa_table, const std::string &method) {
+  bool is_log = method == "log";
+  if (!is_log && method != "mantissa") {
+    llvm::errs() << "unsupported lookup table func:" << method << "\n";
+    llvm_unreachable("Error");
+  }
+#pragma omp parallel for if (size > 1024) schedule(static, omp_schedule(size))
   for (int i = 0; i < size; i++) {
     float val = input[i];
     uint16_t bf16_val = f32_to_bf16(val, false);
@@ -342,22 +388,17 @@ void bf16_lut_mantissa(float *input, float *output, int size, float *exp_table,
     if (val == 0) {
       exponentIndex = 0;
     } else if (val >= 0) {
-      exponentIndex = floor(log2(val));
+      // ilogb equals floor(log2(val)) without computing log2
+      exponentIndex = std::ilogb(val);
       exponentIndex += 62 + 1; // 62 means start with 2^-62, index from 1
     } else {
-      exponentIndex = floor(log2(-1 * val));
+      exponentIndex = std::ilogb(val);
       exponentIndex += 62 + 129; // 62 means start with 2^-62, index from 129
     }
     float exponent = exp_table[exponentIndex];
     float mantissa = mantissa_table[bf16_val & 0xff];
-    if (method == "mantissa")
-      output[i] = bf16_mul(exponent, mantissa);
-    else if (method == "log")
-      output[i] = bf16_add(exponent, mantissa);
-    else {
-      llvm::errs() << "unsupported lookup table func:" << method << "\n";
-      llvm_unreachable("Error");
-    }
+    output[i] = is_log ? bf16_add(exponent, mantissa)
+                       : bf16_mul(exponent, mantissa);
   }
 }
 
@@ -87,22 +87,27 @@ template <typename T>
 LogicalResult TensorFile::updateTensorData(llvm::StringRef name, const T *data,
                                            size_t count) {
   assert(!readOnly);
-  auto it = map.find(name.str());
-  if (it == map.end()) {
+  auto arr_ptr = getArray(name, false);
+  if (arr_ptr == nullptr) {
     llvm::errs() << "failed to add tensor " << name.str()
                  << ", already exist\n";
     llvm_unreachable("addTensor error!");
     return failure();
   }
-  cnpy::NpyArray &arr = it->second;
+  cnpy::NpyArray &arr = *arr_ptr;
   if (arr.num_bytes() != count * sizeof(T)) {
     llvm::errs() << "size does not match for tensor " << name.str() << " "
                  << count * sizeof(T) << " vs " << arr.num_bytes() << "\n";
     llvm_unreachable("readTensor failed");
     return failure();
   }
+  if (arr.data_holder.use_count() > 1) {
+    // data is shared with clones or identical tensors, copy on write
+    arr.data_holder = std::make_shared<std::vector<char>>(arr.num_bytes());
+  }
   arr.fortran_order = false;
   memcpy(arr.data_holder->data(), data, arr.num_bytes());
+  shareBlob(arr);
   cnt_update++;
   return success();
 }
@@ -110,20 +115,24 @@ LogicalResult TensorFile::updateTensorData(llvm::StringRef name, const T *data,
 LogicalResult TensorFile::cloneTensor(llvm::StringRef name,
                                       llvm::StringRef suffix) {
   assert(!readOnly);
-  auto it = map.find(name.str());
-  if (it == map.end()) {
+  if (!exist(name)) {
     llvm::errs() << "failed to clone tensor " << name.str() << ", not exist\n";
     llvm_unreachable("cloneTensor error!");
     return failure();
   }
   auto new_name = name.str() + "_" + suffix.str();
-  auto new_it = map.find(new_name);
-  if (new_it != map.end()) {
+  if (exist(new_name)) {
     llvm::errs() << "failed to clone tensor " << new_name << ", exist\n";
     llvm_unreachable("cloneTensor error!");
     return failure();
   }
-  cnpy::npz_clone_array(map, name.str(), new_name);
+  auto lazy_it = lazy.find(name.str());
+  if (lazy_it != lazy.end()) {
+    // untouched tensor, the clone refers to the same data in the file
+    lazy[new_name] = lazy_it->second;
+  } else {
+    cnpy::npz_clone_array(map, name.str(), new_name);
+  }
   return success();
 }
 
@@ -134,8 +143,7 @@ LogicalResult TensorFile::addTensor(llvm::StringRef name, const T *data,
                                     RankedTensorType &type, int64_t length) {
   assert(!readOnly);
   assert(check_type<T>(type.getElementType()) == true);
-  auto it = map.find(name.str());
-  if (it != map.end()) {
+  if (exist(name)) {
     llvm::errs() << "failed to add tensor " << name.str()
                  << ", already exist\n";
     llvm_unreachable("addTensor error!");
@@ -151,6 +159,7 @@ LogicalResult TensorFile::addTensor(llvm::StringRef name, const T *data,
     }
   }
   cnpy::npz_add_array(map, name.str(), &data[0], shape_npz);
+  shareBlob(map[name.str()]);
   cnt_add++;
   return success();
 }
@@ -170,8 +179,7 @@ template <typename T>
 LogicalResult TensorFile::addTensor(llvm::StringRef name, const T *data,
                                     std::vector<int64_t> &shape) {
   assert(!readOnly);
-  auto it = map.find(name.str());
-  if (it != map.end()) {
+  if (exist(name)) {
     llvm::errs() << "failed to add tensor " << name.str()
                  << ", already exist\n";
     llvm_unreachable("addTensor error!");
@@ -182,6 +190,7 @@ LogicalResult TensorFile::addTensor(llvm::StringRef name, const T *data,
     shape_npz.push_back((size_t)*it);
   }
   cnpy::npz_add_array(map, name.str(), &data[0], shape_npz);
+  shareBlob(map[name.str()]);
   cnt_add++;
   return success();
 }
@@ -278,13 +287,26 @@ TensorFile::readTensor<unsigned short>(llvm::StringRef name,
 template <typename T>
 LogicalResult TensorFile::readTensor(llvm::StringRef name, T *data,
                                      size_t count, bool isINT4, bool do_compress) {
-  auto it = map.find(name.str());
-  if (it == map.end()) {
+  auto lazy_it = lazy.find(name.str());
+  if (lazy_it != lazy.end() && !lazy_it->second.fortran_order) {
+    // copy straight from the mapped file, no need to keep it in memory
+    auto &entry = lazy_it->second;
+    if (entry.num_bytes != count * sizeof(T) && !isINT4 && !do_compress) {
+      llvm::errs() << "size does not match for tensor " << name.str() << "\n";
+      llvm_unreachable("readTensor failed");
+      return failure();
+    }
+    memcpy(data, mapped->getBufferStart() + entry.offset,
+           isINT4 ? count : entry.num_bytes);
+    return success();
+  }
+  auto arr_ptr = getArray(name);
+  if (arr_ptr == nullptr) {
     llvm::errs() << "failed to find tensor " << name.str() << " to read\n";
     llvm_unreachable("readTensor failed");
     return failure();
   }
-  auto arr = it->second;
+  auto arr = *arr_ptr;
   if (arr.num_bytes() != count * sizeof(T) && !isINT4 && !do_compress) {
     llvm::errs() << "size does not match for tensor " << name.str() << "\n";
     llvm_unreachable("readTensor failed");
@@ -350,12 +372,10 @@ LogicalResult TensorFile::deleteTensor(const llvm::StringRef name) {
   assert(!readOnly);
   if (readOnly)
     return failure();
-  auto it = map.find(name.str());
-  if (it == map.end()) {
+  if (map.erase(name.str()) == 0 && lazy.erase(name.str()) == 0) {
     llvm::errs() << "failed to find tensor " << name.str() << " to delete\n";
     return failure();
   }
-  map.erase(it);
   cnt_del++;
   return success();
 }
@@ -364,6 +384,9 @@ void TensorFile::getAllNames(std::set<StringRef> &names) {
   for (auto &name : map) {
     names.insert(name.first);
   }
+  for (auto &name : lazy) {
+    names.insert(name.first);
+  }
 }
 
 /// read all tensor from file
@@ -372,8 +395,12 @@ LogicalResult
 TensorFile::readAllTensors(std::vector<std::string> &names,
                            std::vector<std::vector<T> *> &tensors,
                            std::vector<std::vector<int64_t>> &shapes) {
-  for (auto it = map.begin(); it != map.end(); it++) {
-    auto arr = it->second;
+  std::set<StringRef> all_names;
+  getAllNames(all_names);
+  for (auto name_ref : all_names) {
+    // materializing a tensor drops its key from the lazy index
+    auto name = name_ref.str();
+    auto arr = *getArray(name);
     assert(arr.type == 'f'); // support float only for now
     assert(arr.word_size == sizeof(float));
     auto count = arr.num_bytes() / arr.word_size;
@@ -385,7 +412,7 @@ TensorFile::readAllTensors(std::vector<std::string> &names,
     assert(count == (size_t)std::accumulate(std::begin(shape), std::end(shape),
                                             1, std::multiplies<>()));
     shapes.push_back(shape);
-    names.push_back(it->first);
+    names.push_back(name);
   }
   return success();
 }
@@ -422,6 +449,15 @@ void TensorFile::save(const std::string &file) {
   if (cnt_add + cnt_del + cnt_update == 0 && same_name) {
     return;
   }
+  std::vector<std::string> fortran_names;
+  for (auto &it : lazy) {
+    if (it.second.fortran_order) {
+      fortran_names.push_back(it.first);
+    }
+  }
+  for (auto &name : fortran_names) {
+    getArray(name);
+  }
   for (auto &it : map) {
     cnpy::NpyArray &array = it.second;
     if (array.fortran_order == true) {
@@ -433,14 +469,89 @@ void TensorFile::save(const std::string &file) {
     }
   }
 
-  cnpy::npz_save_all(filename, map);
+  if (mapped) {
+    // the mapped file may be the target, write aside and replace it; the
+    // mapping stays valid on the old file
+    auto tmp_file = filename + ".tmp";
+    cnpy::npz_save_all(tmp_file, map, lazy, mapped->getBufferStart());
+    auto ec = llvm::sys::fs::rename(tmp_file, filename);
+    if (ec) {
+      llvm::errs() << "failed to save " << filename << ": " << ec.message()
+                   << "\n";
+      llvm_unreachable("TensorFile error!");
+    }
+  } else {
+    cnpy::npz_save_all(filename, map);
+  }
   cnt_add = 0;
   cnt_del = 0;
   cnt_update = 0;
   return;
 }
 
+bool TensorFile::exist(llvm::StringRef name) {
+  return map.count(name.str()) || lazy.count(name.str());
+}
+
+cnpy::NpyArray *TensorFile::getArray(llvm::StringRef name, bool keep_data) {
+  auto it = map.find(name.str());
+  if (it != map.end()) {
+    return &it->second;
+  }
+  auto lazy_it = lazy.find(name.str());
+  if (lazy_it == lazy.end()) {
+    return nullptr;
+  }
+  auto &entry = lazy_it->second;
+  cnpy::NpyArray arr(entry.shape, entry.word_size, entry.type,
+                     entry.fortran_order);
+  if (keep_data) {
+    memcpy(arr.data<char>(), mapped->getBufferStart() + entry.offset,
+           arr.num_bytes());
+  }
+  lazy.erase(lazy_it);
+  return &(map[name.str()] = arr);
+}
+
+void TensorFile::shareBlob(cnpy::NpyArray &arr) {
+  auto &holder = arr.data_holder;
+  auto key = llvm::xxHash64(llvm::ArrayRef<uint8_t>(
+      (const uint8_t *)holder->data(), holder->size()));
+  auto range = blobs.equal_range(key);
+  for (auto it = range.first; it != range.second;) {
+    auto blob = it->second.lock();
+    if (!blob) {
+      it = blobs.erase(it);
+      continue;
+    }
+    if (blob != holder && blob->size() == holder->size() &&
+        memcmp(blob->data(), holder->data(), holder->size()) == 0) {
+      holder = blob;
+      return;
+    }
+    if (blob == holder) {
+      return;
+    }
+    ++it;
+  }
+  blobs.emplace(key, holder);
+}
+
 LogicalResult TensorFile::load(void) {
+  // stored npz is indexed in place, tensors are read on first touch
+  auto buffer = llvm::MemoryBuffer::getFile(filename, /*IsText=*/false,
+                                            /*RequiresNullTerminator=*/false);
+  if (buffer) {
+    cnpy::npz_index_t index;
+    if (cnpy::npz_index((*buffer)->getBufferStart(),
+                        (*buffer)->getBufferSize(), index) &&
+        index.size() > 0) {
+      mapped = std::move(*buffer);
+      lazy = std::move(index);
+      map.clear();
+      return success();
+    }
+  }
   map = cnpy::npz_load(filename);
   if (map.size() > 0) {
     return success();
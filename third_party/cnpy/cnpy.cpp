@@ -15,8 +15,11 @@
 #include<stdint.h>
 #include<stdexcept>
 #include <regex>
+#include <unistd.h>
 
 #define ZIP64_LIMIT  ((((size_t)1) << 31) - 1)
+#define ZIP_FILECOUNT_LIMIT  ((1 << 16) - 1)
+#define ZIP_MAX_FIELD  0xFFFFFFFF
 
 namespace cnpy {
 
@@ -136,7 +139,7 @@ void parse_npy_header(unsigned char* buffer, size_t& word_size,  char& type,
 
     std::string str_shape = header.substr(loc1+1,loc2-loc1-1);
     while(std::regex_search(str_shape, sm, num_regex)) {
-        shape.push_back(std::stoi(sm[0].str()));
+        shape.push_back(std::stoull(sm[0].str()));
         str_shape = sm.suffix().str();
     }
 
@@ -187,7 +190,7 @@ void parse_npy_header(FILE* fp, size_t& word_size, char& type,
 
     std::string str_shape = header.substr(loc1+1,loc2-loc1-1);
     while(std::regex_search(str_shape, sm, num_regex)) {
-        shape.push_back(std::stoi(sm[0].str()));
+        shape.push_back(std::stoull(sm[0].str()));
         str_shape = sm.suffix().str();
     }
 
@@ -210,10 +213,10 @@ void parse_npy_header(FILE* fp, size_t& word_size, char& type,
     word_size = atoi(str_ws.substr(0,loc2).c_str());
 }
 
-void parse_zip_footer(FILE* fp, uint16_t& nrecs, size_t& global_header_size,
+void parse_zip_footer(FILE* fp, size_t& nrecs, size_t& global_header_size,
         size_t& global_header_offset) {
     std::vector<char> footer(22);
-    fseek(fp,-22,SEEK_END);
+    fseeko(fp,-22,SEEK_END);
     size_t res = fread(&footer[0],sizeof(char),22,fp);
     if(res != 22)
         throw std::runtime_error("parse_zip_footer: failed fread");
@@ -231,15 +234,170 @@ void parse_zip_footer(FILE* fp, uint16_t& nrecs, size_t& global_header_size,
     assert(disk_start == 0);
     assert(nrecs_on_disk == nrecs);
     assert(comment_len == 0);
-    if (global_header_offset >= 0xFFFFFFFF) {
-      //get global header offset from extra data
+    if (nrecs == ZIP_FILECOUNT_LIMIT || global_header_size == ZIP_MAX_FIELD ||
+        global_header_offset == ZIP_MAX_FIELD) {
+      //the real values live in the zip64 end of central directory record,
+      //located by the zip64 locator right before the footer
+      std::vector<char> zip64locrec_header(20);
+      fseeko(fp,-42,SEEK_END);
+      res = fread(&zip64locrec_header[0],sizeof(char),20,fp);
+      if(res != 20 || *(uint32_t*) &zip64locrec_header[0] != 0x07064b50)
+        throw std::runtime_error("parse_zip_footer: bad zip64 locator");
+      uint64_t zip64endrec_offset = *(uint64_t*) &zip64locrec_header[8];
+
       std::vector<char> zip64endrec_header(56);
-      fseek(fp,-98,SEEK_END);
-      fread(&zip64endrec_header[0],sizeof(char),56,fp);
+      fseeko(fp,zip64endrec_offset,SEEK_SET);
+      res = fread(&zip64endrec_header[0],sizeof(char),56,fp);
+      if(res != 56 || *(uint32_t*) &zip64endrec_header[0] != 0x06064b50)
+        throw std::runtime_error("parse_zip_footer: bad zip64 end record");
+      nrecs = *(uint64_t*) &zip64endrec_header[32];
+      global_header_size = *(uint64_t*) &zip64endrec_header[40];
       global_header_offset = *(uint64_t*) &zip64endrec_header[48];
     }
 }
 
+static uint32_t npz_crc32(uint32_t crc, const void* data, size_t size) {
+    //zlib takes a uInt length, feed large arrays in pieces
+    const uint8_t* p = (const uint8_t*) data;
+    while (size > 0) {
+        uInt chunk = (uInt) std::min<size_t>(size, (size_t)1 << 30);
+        crc = crc32(crc, p, chunk);
+        p += chunk;
+        size -= chunk;
+    }
+    return crc;
+}
+
+//nbytes is the uncompressed size, compr_bytes only matters when deflated
+static std::vector<char> create_local_header(const std::string& fname,
+        uint32_t crc, size_t nbytes, uint16_t compr_method = 0,
+        size_t compr_bytes = 0) {
+    if (compr_method == 0) compr_bytes = nbytes;
+    bool zip64 = nbytes >= ZIP64_LIMIT || compr_bytes >= ZIP64_LIMIT;
+    std::vector<char> local_header;
+    local_header += "PK"; //first part of sig
+    local_header += (uint16_t) 0x0403; //second part of sig
+    local_header += (uint16_t) (zip64 ? 45 : 20); //min version to extract
+    local_header += (uint16_t) 0; //general purpose bit flag
+    local_header += (uint16_t) compr_method; //compression method
+    local_header += (uint16_t) 0; //file last mod time
+    local_header += (uint16_t) 0;     //file last mod date
+    local_header += (uint32_t) crc; //crc
+    //compressed and uncompressed size, moved to the zip64 extra if too large
+    local_header += zip64 ? (uint32_t) ZIP_MAX_FIELD : (uint32_t) compr_bytes;
+    local_header += zip64 ? (uint32_t) ZIP_MAX_FIELD : (uint32_t) nbytes;
+    local_header += (uint16_t) fname.size(); //fname length
+    local_header += (uint16_t) (zip64 ? 20 : 0); //extra field length
+    local_header += fname;
+    if (zip64) {
+        local_header += (uint16_t) 0x01; //zip64 extra tag
+        local_header += (uint16_t) 16;
+        local_header += (uint64_t) nbytes; //uncompressed size
+        local_header += (uint64_t) compr_bytes; //compressed size
+    }
+    return local_header;
+}
+
+static void append_global_header(std::vector<char>& global_header,
+        const std::string& fname, uint32_t crc, size_t nbytes,
+        size_t offset, uint16_t compr_method = 0, size_t compr_bytes = 0) {
+    if (compr_method == 0) compr_bytes = nbytes;
+    bool zip64_size = nbytes >= ZIP64_LIMIT || compr_bytes >= ZIP64_LIMIT;
+    bool zip64_offset = offset >= ZIP64_LIMIT;
+    //zip64 extra only carries the fields which overflow
+    std::vector<char> extra;
+    if (zip64_size) {
+        extra += (uint64_t) nbytes; //uncompressed size
+        extra += (uint64_t) compr_bytes; //compressed size
+    }
+    if (zip64_offset) extra += (uint64_t) offset;
+
+    global_header += "PK"; //first part of sig
+    global_header += (uint16_t) 0x0201; //second part of sig
+    if (extra.empty()) {
+        global_header += (uint16_t) 20; //version made by
+        global_header += (uint16_t) 20; //min version to extract
+    } else {
+        global_header += (uint8_t) 45; //create_version
+        global_header += (uint8_t) 3; //zinfo.create_system
+        global_header += (uint8_t) 45; //extract_version
+        global_header += (uint8_t) 0; //zinfo.reserved
+    }
+    global_header += (uint16_t) 0; //general purpose bit flag
+    global_header += (uint16_t) compr_method; //compression method
+    global_header += (uint16_t) 0; //file last mod time
+    global_header += (uint16_t) 0; //file last mod date
+    global_header += (uint32_t) crc; //crc
+    global_header += zip64_size ? (uint32_t) ZIP_MAX_FIELD : (uint32_t) compr_bytes;
+    global_header += zip64_size ? (uint32_t) ZIP_MAX_FIELD : (uint32_t) nbytes;
+    global_header += (uint16_t) fname.size(); //fname length
+    global_header += (uint16_t) (extra.empty() ? 0 : extra.size() + 4);
+    global_header += (uint16_t) 0; //file comment length
+    global_header += (uint16_t) 0; //disk number where file starts
+    global_header += (uint16_t) 0; //internal file attributes
+    global_header += (uint32_t) 0; //external file attributes
+    //relative offset of local file header
+    global_header += zip64_offset ? (uint32_t) ZIP_MAX_FIELD : (uint32_t) offset;
+    global_header += fname;
+    if (!extra.empty()) {
+        global_header += (uint16_t) 0x01; //zip64 extra tag
+        global_header += (uint16_t) extra.size();
+        global_header.insert(global_header.end(),extra.begin(),extra.end());
+    }
+}
+
+static void write_zip_footer(FILE* fp, size_t nrecs, size_t global_header_size,
+        size_t global_header_offset) {
+    if (nrecs >= ZIP_FILECOUNT_LIMIT || global_header_size >= ZIP64_LIMIT ||
+        global_header_offset >= ZIP64_LIMIT) {
+      //structEndArchive64 = "<4sQ2H2L4Q"
+      //zip64endrec = struct.pack(
+      //        structEndArchive64, stringEndArchive64,
+      //        44, 45, 45, 0, 0, centDirCount, centDirCount,
+      //        centDirSize, centDirOffset)
+      std::vector<char> zip64endrec_header;
+      zip64endrec_header += "PK";
+      zip64endrec_header += (uint16_t) 0x0606;
+      zip64endrec_header += (uint64_t) 44; //size of the remaining record
+      zip64endrec_header += (uint16_t) 45; //version made by
+      zip64endrec_header += (uint16_t) 45; //version to extract
+      zip64endrec_header += (uint32_t) 0x0;
+      zip64endrec_header += (uint32_t) 0x0;
+      zip64endrec_header += (uint64_t) nrecs; //centDirCount
+      zip64endrec_header += (uint64_t) nrecs; //centDirCount
+      zip64endrec_header += (uint64_t) global_header_size; //centDirSize
+      zip64endrec_header += (uint64_t) global_header_offset; //centDirOffset
+      fwrite(&zip64endrec_header[0],sizeof(char),zip64endrec_header.size(),fp);
+
+      //structEndArchive64Locator = "<4sLQL"
+      std::vector<char> zip64locrec_header;
+      zip64locrec_header += "PK";
+      zip64locrec_header += (uint16_t) 0x0706;
+      zip64locrec_header += (uint32_t) 0x0;
+      //zip64endrec_header offset
+      zip64locrec_header += (uint64_t) (global_header_offset + global_header_size);
+      zip64locrec_header += (uint32_t) 0x1;
+      fwrite(&zip64locrec_header[0],sizeof(char),zip64locrec_header.size(),fp);
+    }
+    //build footer
+    std::vector<char> footer;
+    footer += "PK"; //first part of sig
+    footer += (uint16_t) 0x0605; //second part of sig
+    footer += (uint16_t) 0; //number of this disk
+    footer += (uint16_t) 0; //disk where footer starts
+    //number of records on this disk and in total
+    footer += (uint16_t) std::min<size_t>(nrecs, ZIP_FILECOUNT_LIMIT);
+    footer += (uint16_t) std::min<size_t>(nrecs, ZIP_FILECOUNT_LIMIT);
+    //nbytes of global headers
+    footer += (global_header_size >= ZIP64_LIMIT) ?
+               (uint32_t) ZIP_MAX_FIELD : (uint32_t) global_header_size;
+    //offset of start of global headers
+    footer += (global_header_offset >= ZIP64_LIMIT) ?
+               (uint32_t) ZIP_MAX_FIELD : (uint32_t) global_header_offset;
+    footer += (uint16_t) 0; //zip file comment length
+    fwrite(&footer[0],sizeof(char),footer.size(),fp);
+}
+
 template<typename T>
 void npy_save(std::string fname, const T* data,
         const std::vector<size_t> shape, std::string mode) {
@@ -320,7 +478,7 @@ void npz_save(std::string zipname, std::string fname,
 
     //now, on with the show
     FILE* fp = NULL;
-    uint16_t nrecs = 0;
+    size_t nrecs = 0;
     size_t global_header_offset = 0;
     std::vector<char> global_header;
 
@@ -335,14 +493,14 @@ void npz_save(std::string zipname, std::string fname,
         //header then append the global header and footer below it
         size_t global_header_size;
         parse_zip_footer(fp,nrecs,global_header_size,global_header_offset);
-        fseek(fp,global_header_offset,SEEK_SET);
+        fseeko(fp,global_header_offset,SEEK_SET);
         global_header.resize(global_header_size);
         size_t res = fread(&global_header[0],sizeof(char),global_header_size,fp);
         if(res != global_header_size){
             throw std::runtime_error("npz_save: "
                     "header read error while adding to existing zip");
         }
-        fseek(fp,global_header_offset,SEEK_SET);
+        fseeko(fp,global_header_offset,SEEK_SET);
     }
     else {
         fp = fopen(zipname.c_str(),"wb");
@@ -363,140 +521,22 @@ void npz_save(std::string zipname, std::string fname,
     size_t nbytes = nels*sizeof(T) + npy_header.size();
 
     //get the CRC of the data to be added
-    uint32_t crc = crc32(0L,(uint8_t*)&npy_header[0],npy_header.size());
-    crc = crc32(crc,(const uint8_t*)data,nels*sizeof(T));
-
-    //build the local header
-    std::vector<char> local_header;
-    local_header += "PK"; //first part of sig
-    local_header += (uint16_t) 0x0403; //second part of sig
-    local_header += (uint16_t) 20; //min version to extract
-    local_header += (uint16_t) 0; //general purpose bit flag
-    local_header += (uint16_t) 0; //compression method
-    local_header += (uint16_t) 0; //file last mod time
-    local_header += (uint16_t) 0;     //file last mod date
-    local_header += (uint32_t) crc; //crc
-    local_header += (uint32_t) nbytes; //compressed size
-    local_header += (uint32_t) nbytes; //uncompressed size
-    local_header += (uint16_t) fname.size(); //fname length
-    local_header += (uint16_t) 0; //extra field length
-    local_header += fname;
+    uint32_t crc = npz_crc32(0L,&npy_header[0],npy_header.size());
+    crc = npz_crc32(crc,data,nels*sizeof(T));
 
+    std::vector<char> local_header = create_local_header(fname, crc, nbytes);
     fwrite(&local_header[0],sizeof(char),local_header.size(),fp);
     fwrite(&npy_header[0],sizeof(char),npy_header.size(),fp);
     fwrite(data,sizeof(T),nels,fp);
-    /*
-      Only support global_header_offset is larger than ZIP64_LIMIT.
-      Not support size is larger than ZIP64_LIMIT now.
-    */
-    if (global_header_offset + nbytes + local_header.size() >= ZIP64_LIMIT) {
-      //structCentralDir = "<4s4B4HL2L5H2L"
-      //centdir = struct.pack(structCentralDir,
-      //stringCentralDir, create_version,
-      //zinfo.create_system, extract_version, zinfo.reserved,
-      //flag_bits, zinfo.compress_type, dostime, dosdate,
-      //zinfo.CRC, compress_size, file_size,
-      //len(filename), len(extra_data), len(zinfo.comment),
-      //0, zinfo.internal_attr, zinfo.external_attr,
-      //header_offset)
-
-      //build global header
-      global_header += "PK"; //first part of sig
-      global_header += (uint16_t) 0x0201; //second part of sig
-      global_header += (uint8_t) 45; //create_version
-      global_header += (uint8_t) 3; //zinfo.create_system
-      global_header += (uint8_t) 45; //extract_version
-      global_header += (uint8_t) 0; //zinfo.reserved
-      global_header.insert(global_header.end(),local_header.begin()+6,
-                           local_header.begin()+28);
-      global_header += (uint16_t) 12; //extran data length
-      global_header += (uint16_t) 0; //file comment length
-      global_header += (uint16_t) 0; //disk number where file starts
-      global_header += (uint16_t) 0; //internal file attributes
-      global_header += (uint32_t) 0; //external file attributes
-      //relative offset of local file header
-      //since it begins where the global header used to begin
-      global_header += (uint32_t) 0xFFFFFFFF ; //global_header_offset;
-      global_header += fname;
-      // Append a ZIP64 field to the extra's
-      // extra_data = struct.pack(
-      //         '<HH' + 'Q'*len(extra),
-      //         1, 8*len(extra), *extra) + extra_data
-      // extract_version = max(45, zinfo.extract_version)
-      // create_version = max(45, zinfo.create_version)
-      global_header += (uint16_t) 0x01;
-      global_header += (uint16_t) 0x08;
-      global_header += (uint64_t) global_header_offset;
-    } else {
-      //build global header
-      global_header += "PK"; //first part of sig
-      global_header += (uint16_t) 0x0201; //second part of sig
-      global_header += (uint16_t) 20; //version made by
-      global_header.insert(global_header.end(),local_header.begin()+4,
-                           local_header.begin()+30);
-      global_header += (uint16_t) 0; //file comment length
-      global_header += (uint16_t) 0; //disk number where file starts
-      global_header += (uint16_t) 0; //internal file attributes
-      global_header += (uint32_t) 0; //external file attributes
-      //relative offset of local file header
-      //since it begins where the global header used to begin
-      global_header += (uint32_t) global_header_offset;
-      global_header += fname;
-    }
 
+    //the new record starts where the global header used to begin
+    append_global_header(global_header, fname, crc, nbytes,
+                         global_header_offset);
     fwrite(&global_header[0],sizeof(char),global_header.size(),fp);
 
-    if (global_header_offset >= ZIP64_LIMIT) {
-      //structEndArchive64 = "<4sQ2H2L4Q"
-      //zip64endrec = struct.pack(
-      //        structEndArchive64, stringEndArchive64,
-      //        44, 45, 45, 0, 0, centDirCount, centDirCount,
-      //        centDirSize, centDirOffset)
-      //self.fp.write(zip64endrec)
-      std::vector<char> zip64endrec_header;
-      zip64endrec_header += "PK";
-      zip64endrec_header += (uint16_t) 0x0606;
-      zip64endrec_header += (uint64_t) 0x44;
-      zip64endrec_header += (uint16_t) 0x45;
-      zip64endrec_header += (uint16_t) 0x45;
-      zip64endrec_header += (uint32_t) 0x0;
-      zip64endrec_header += (uint32_t) 0x0;
-      zip64endrec_header += (uint64_t) (nrecs+1); //centDirCount
-      zip64endrec_header += (uint64_t) (nrecs+1); //centDirCount
-      zip64endrec_header += (uint64_t) global_header.size(); //centDirSize
-      zip64endrec_header += (uint64_t) global_header_offset + nbytes + local_header.size(); //centDirOffset
-      fwrite(&zip64endrec_header[0],sizeof(char),zip64endrec_header.size(),fp);
-
-      //structEndArchive64Locator = "<4sLQL"
-      //zip64locrec = struct.pack(
-      //        structEndArchive64Locator,
-      //        stringEndArchive64Locator, 0, pos2, 1)
-      //self.fp.write(zip64locrec)
-      std::vector<char> zip64locrec_header;
-      zip64locrec_header += "PK";
-      zip64locrec_header += (uint16_t) 0x0706;
-      zip64locrec_header += (uint32_t) 0x0;
-      zip64locrec_header += (uint64_t) global_header_offset + nbytes + local_header.size() +
-                             zip64endrec_header.size(); // zip64endrec_header offset
-      zip64locrec_header += (uint32_t) 0x1;
-      fwrite(&zip64locrec_header[0],sizeof(char),zip64locrec_header.size(),fp);
-    }
-    //build footer
-    std::vector<char> footer;
-    footer += "PK"; //first part of sig
-    footer += (uint16_t) 0x0605; //second part of sig
-    footer += (uint16_t) 0; //number of this disk
-    footer += (uint16_t) 0; //disk where footer starts
-    footer += (uint16_t) (nrecs+1); //number of records on this disk
-    footer += (uint16_t) (nrecs+1); //total number of records
-    footer += (uint32_t) global_header.size(); //nbytes of global headers
-    //offset of start of global headers
-    //since global header now starts after newly written array
-    footer += (global_header_offset >= ZIP64_LIMIT) ?
-               (uint32_t) 0xFFFFFFFF : (uint32_t) (global_header_offset + nbytes + local_header.size());
-    footer += (uint16_t) 0; //zip file comment length
-
-    fwrite(&footer[0],sizeof(char),footer.size(),fp);
+    //global header now starts after newly written array
+    write_zip_footer(fp, nrecs + 1, global_header.size(),
+                     global_header_offset + local_header.size() + nbytes);
     fclose(fp);
 }
 
@@ -578,49 +618,348 @@ template void npz_add_array<uint16_t>(npz_t &, std::string,
 template void npz_add_array<int32_t>(npz_t &, std::string,
         const std::vector<int32_t> &);
 
-void npz_save_all(std::string zipname, npz_t &map) {
-    for (auto it = map.begin(); it != map.end(); it++) {
-        std::string mode = (it == map.begin()) ? "w" : "a";
-        NpyArray &arr = it->second;
-        if (arr.type == 'f') {
-            // support float only for now
-            assert(arr.word_size = sizeof(float));
-            npz_save<float>(zipname, it->first, it->second, mode);
-        } else if (arr.type == 'i') {
-            // support int8/int16/int32 only
-            if (arr.word_size == sizeof(int8_t)) {
-                npz_save<int8_t>(zipname, it->first, it->second, mode);
-            } else if (arr.word_size == sizeof(int16_t)) {
-                npz_save<int16_t>(zipname, it->first, it->second, mode);
-            } else if (arr.word_size == sizeof(int32_t)) {
-                npz_save<int32_t>(zipname, it->first, it->second, mode);
-            } else {
-                assert(0);
-            }
-        } else if (arr.type == 'u') {
-            // support uint8/uint16/uint32
-            if (arr.word_size == sizeof(uint8_t)) {
-                npz_save<uint8_t>(zipname, it->first, it->second, mode);
-            } else if (arr.word_size == sizeof(uint16_t)) {
-                npz_save<uint16_t>(zipname, it->first, it->second, mode);
-            } else if (arr.word_size == sizeof(uint32_t)) {
-                npz_save<uint32_t>(zipname, it->first, it->second, mode);
-            } else {
-                assert(0);
-            }
-        } else if (arr.type == 'b') {
-            // not support yet
-            assert(0);
-        } else if (arr.type == 'c') {
-            // not support yet
+static bool npz_check_array(const std::string &name, char type,
+        size_t word_size) {
+    if (type == 'f') {
+        // support float only for now
+        return word_size == sizeof(float);
+    } else if (type == 'i' || type == 'u') {
+        // support int8/int16/int32 and uint8/uint16/uint32
+        return word_size == sizeof(int8_t) ||
+               word_size == sizeof(int16_t) ||
+               word_size == sizeof(int32_t);
+    } else if (type == 'b' || type == 'c') {
+        // not support yet
+        return false;
+    }
+    // invalid type
+    std::cout << "libcnpy error: invalid array type "
+              << type << ", for " << name << "\n";
+    return false;
+}
+
+//raw deflate of the npy header followed by the array data, zip method 8
+static std::vector<unsigned char> npz_deflate(
+        const std::vector<char>& npy_header, const char* data, size_t size) {
+    z_stream c_stream;
+    c_stream.zalloc = Z_NULL;
+    c_stream.zfree = Z_NULL;
+    c_stream.opaque = Z_NULL;
+    if(deflateInit2(&c_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
+                    8, Z_DEFAULT_STRATEGY) != Z_OK)
+        throw std::runtime_error("npz_save_all: deflateInit failed");
+    std::vector<unsigned char> out(
+        deflateBound(&c_stream, npy_header.size() + size));
+    size_t produced = 0;
+    //zlib takes uInt lengths, feed large arrays in pieces
+    auto feed = [&](const char* in, size_t n, bool finish) {
+        while (true) {
+            uInt in_chunk = (uInt) std::min<size_t>(n, (size_t)1 << 30);
+            bool last = finish && in_chunk == n;
+            c_stream.next_in = (Bytef*) in;
+            c_stream.avail_in = in_chunk;
+            int err;
+            do {
+                uInt out_chunk = (uInt) std::min<size_t>(out.size() - produced,
+                                                         (size_t)1 << 30);
+                if (out_chunk == 0)
+                    throw std::runtime_error("npz_save_all: deflate overflow");
+                c_stream.next_out = out.data() + produced;
+                c_stream.avail_out = out_chunk;
+                err = deflate(&c_stream, last ? Z_FINISH : Z_NO_FLUSH);
+                if (err == Z_STREAM_ERROR)
+                    throw std::runtime_error("npz_save_all: deflate failed");
+                produced += out_chunk - c_stream.avail_out;
+            } while (c_stream.avail_in > 0 || (last && err != Z_STREAM_END));
+            in += in_chunk;
+            n -= in_chunk;
+            if (n == 0) break;
+        }
+    };
+    feed(npy_header.data(), npy_header.size(), false);
+    feed(data, size, true);
+    deflateEnd(&c_stream);
+    out.resize(produced);
+    out.shrink_to_fit();
+    return out;
+}
+
+//fwrite which throws on a short write, such as a full disk, so a truncated
+//file is never taken as a good one
+static void npz_fwrite(const void* data, size_t size, FILE* fp) {
+    if (size > 0 && fwrite(data,sizeof(char),size,fp) != size)
+        throw std::runtime_error("npz_save_all: failed fwrite");
+}
+
+void npz_save_all(std::string zipname, npz_t &map, bool compress) {
+    npz_save_all(zipname, map, npz_index_t(), nullptr, compress);
+}
+
+void npz_save_all(std::string zipname, npz_t &map, const npz_index_t &index,
+        const char *base, bool compress) {
+    //write all arrays in a single pass: local headers and data are streamed
+    //sequentially, the central directory is kept in memory and written once
+    struct Entry {
+        const std::string *name;
+        const std::vector<size_t> *shape;
+        size_t word_size;
+        char type;
+        const char *data;
+        size_t num_bytes;
+        std::vector<char> npy_header;
+        uint32_t crc;
+        //data is a whole npy payload from the source file with known crc
+        bool raw;
+    };
+    std::vector<Entry> entries;
+    entries.reserve(map.size() + index.size());
+    auto add_entry = [&](const std::string &name,
+                         const std::vector<size_t> &shape, size_t word_size,
+                         char type, const char *data, size_t num_bytes,
+                         bool raw, uint32_t crc) {
+        if (!npz_check_array(name, type, word_size)) {
             assert(0);
+            return;
+        }
+        if (shape.size() == 0) {
+            std::cerr << "[Warning] zip name: " << name
+                      << ".npy npz shape size is 0, skip it\n";
+            return;
+        }
+        entries.push_back({&name, &shape, word_size, type, data, num_bytes,
+                           {}, crc, raw});
+    };
+    for (auto &it : map) {
+        const NpyArray &arr = it.second;
+        add_entry(it.first, arr.shape, arr.word_size, arr.type,
+                  arr.data_holder->data(), arr.num_bytes(), false, 0);
+    }
+    for (auto &it : index) {
+        const NpzEntry &e = it.second;
+        assert(!e.fortran_order);
+        //untouched arrays are carried over as is, npy header included, so
+        //their crc from the source central directory is still valid
+        add_entry(it.first, e.shape, e.word_size, e.type,
+                  base + e.payload_offset,
+                  e.offset + e.num_bytes - e.payload_offset, true, e.crc);
+    }
+    //keep the name order of a single map
+    if (!index.empty()) {
+        std::sort(entries.begin(), entries.end(),
+                  [](const Entry &a, const Entry &b) { return *a.name < *b.name; });
+    }
+
+    //arrays sharing the same data (clones, deduplicated tensors) only get
+    //their data CRC computed once
+    std::map<std::pair<const char*, size_t>, uint32_t> data_crcs;
+    for (auto &e : entries)
+        if (!e.raw) data_crcs.emplace(std::make_pair(e.data, e.num_bytes), 0);
+    std::vector<std::pair<const std::pair<const char*, size_t>, uint32_t>*> blobs;
+    blobs.reserve(data_crcs.size());
+    for (auto &it : data_crcs) blobs.push_back(&it);
+
+    //headers and CRCs are independent per array
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int64_t i = 0; i < (int64_t)blobs.size(); i++) {
+        blobs[i]->second = npz_crc32(0L, blobs[i]->first.first,
+                                     blobs[i]->first.second);
+    }
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (int64_t i = 0; i < (int64_t)entries.size(); i++) {
+        Entry &e = entries[i];
+        if (e.raw) continue;
+        e.npy_header = create_npy_header(*e.shape, e.word_size, e.type);
+        uint32_t crc = npz_crc32(0L, &e.npy_header[0], e.npy_header.size());
+        uint32_t data_crc = data_crcs.at(std::make_pair(e.data, e.num_bytes));
+        e.crc = crc32_combine(crc, data_crc, e.num_bytes);
+    }
+
+    FILE* fp = fopen(zipname.c_str(),"wb");
+    if(!fp)
+        throw std::runtime_error("npz_save_all: Unable to open file "+zipname);
+    std::vector<char> io_buffer(1 << 20);
+    setvbuf(fp, &io_buffer[0], _IOFBF, io_buffer.size());
+
+    size_t offset = 0;
+    std::vector<char> global_header;
+    auto write_member = [&](const Entry &e,
+                            const std::vector<unsigned char> &deflated) {
+        std::string fname = *e.name + ".npy";
+        size_t nbytes = e.num_bytes + e.npy_header.size();
+
+        uint16_t compr_method = compress ? 8 : 0;
+        size_t compr_bytes = compress ? deflated.size() : nbytes;
+
+        std::vector<char> local_header = create_local_header(fname, e.crc,
+                nbytes, compr_method, compr_bytes);
+        npz_fwrite(&local_header[0],local_header.size(),fp);
+        if (compress) {
+            npz_fwrite(deflated.data(),deflated.size(),fp);
         } else {
-            // invalid type
-            std::cout << "libcnpy error: invalid array type "
-                      << arr.type << ", for " << it->first << "\n";
-            assert(0);
+            npz_fwrite(e.npy_header.data(),e.npy_header.size(),fp);
+            npz_fwrite(e.data,e.num_bytes,fp);
+        }
+
+        append_global_header(global_header, fname, e.crc, nbytes, offset,
+                             compr_method, compr_bytes);
+        offset += local_header.size() + compr_bytes;
+    };
+
+    std::string error;
+    if (compress) {
+        //members are deflated independently, one array per task, and written
+        //in order as soon as the earlier ones are written. a task waits for
+        //its turn, so at most one deflated member per thread is in memory.
+        #pragma omp parallel for ordered schedule(dynamic, 1)
+        for (int64_t i = 0; i < (int64_t)entries.size(); i++) {
+            std::vector<unsigned char> deflated;
+            try {
+                deflated = npz_deflate(entries[i].npy_header,
+                        entries[i].data, entries[i].num_bytes);
+            } catch (const std::exception &e) {
+                #pragma omp critical
+                error = e.what();
+            }
+            #pragma omp ordered
+            {
+                bool failed;
+                #pragma omp critical
+                failed = !error.empty();
+                if (!failed) {
+                    try {
+                        write_member(entries[i], deflated);
+                    } catch (const std::exception &e) {
+                        #pragma omp critical
+                        error = e.what();
+                    }
+                }
+            }
+        }
+    } else {
+        try {
+            for (auto &e : entries)
+                write_member(e, {});
+        } catch (const std::exception &e) {
+            error = e.what();
         }
     }
+    if (error.empty()) {
+        try {
+            npz_fwrite(global_header.data(),global_header.size(),fp);
+        } catch (const std::exception &e) {
+            error = e.what();
+        }
+    }
+    if (!error.empty()) {
+        fclose(fp);
+        throw std::runtime_error(error);
+    }
+    write_zip_footer(fp, entries.size(), global_header.size(), offset);
+
+    //buffered writes may only fail when flushed
+    bool write_failed = ferror(fp) != 0;
+    if (fclose(fp) != 0 || write_failed)
+        throw std::runtime_error("npz_save_all: failed to write "+zipname);
+}
+
+bool npz_index(const char *buf, size_t size, npz_index_t &index) {
+    index.clear();
+    //locate the end of central directory record, allowing a trailing comment
+    if (size < 22) return false;
+    size_t eocd = size - 22;
+    size_t lowest = size > 22 + 0xFFFF ? size - 22 - 0xFFFF : 0;
+    while (*(uint32_t*) &buf[eocd] != 0x06054b50) {
+        if (eocd == lowest) return false;
+        eocd--;
+    }
+    size_t nrecs = *(uint16_t*) &buf[eocd + 10];
+    size_t global_header_size = *(uint32_t*) &buf[eocd + 12];
+    size_t global_header_offset = *(uint32_t*) &buf[eocd + 16];
+    if (nrecs == ZIP_FILECOUNT_LIMIT || global_header_size == ZIP_MAX_FIELD ||
+        global_header_offset == ZIP_MAX_FIELD) {
+        if (eocd < 20 || *(uint32_t*) &buf[eocd - 20] != 0x07064b50)
+            return false;
+        size_t zip64endrec = *(uint64_t*) &buf[eocd - 20 + 8];
+        if (zip64endrec + 56 > size ||
+            *(uint32_t*) &buf[zip64endrec] != 0x06064b50)
+            return false;
+        nrecs = *(uint64_t*) &buf[zip64endrec + 32];
+        global_header_size = *(uint64_t*) &buf[zip64endrec + 40];
+        global_header_offset = *(uint64_t*) &buf[zip64endrec + 48];
+    }
+    if (global_header_offset + global_header_size > size) return false;
+
+    size_t pos = global_header_offset;
+    for (size_t i = 0; i < nrecs; i++) {
+        if (pos + 46 > size || *(uint32_t*) &buf[pos] != 0x02014b50)
+            return false;
+        uint16_t compr_method = *(uint16_t*) &buf[pos + 10];
+        uint32_t crc = *(uint32_t*) &buf[pos + 16];
+        size_t compr_bytes = *(uint32_t*) &buf[pos + 20];
+        size_t uncompr_bytes = *(uint32_t*) &buf[pos + 24];
+        uint16_t name_len = *(uint16_t*) &buf[pos + 28];
+        uint16_t extra_len = *(uint16_t*) &buf[pos + 30];
+        uint16_t comment_len = *(uint16_t*) &buf[pos + 32];
+        size_t local_offset = *(uint32_t*) &buf[pos + 42];
+        if (pos + 46 + name_len + extra_len > size) return false;
+        std::string fname(&buf[pos + 46], name_len);
+        //the zip64 extra only carries the fields which overflow, in order
+        const char *extra = &buf[pos + 46 + name_len];
+        for (size_t e = 0; e + 4 <= extra_len;) {
+            uint16_t tag = *(uint16_t*) &extra[e];
+            uint16_t len = *(uint16_t*) &extra[e + 2];
+            if (tag == 0x01) {
+                size_t field = e + 4;
+                if (uncompr_bytes == ZIP_MAX_FIELD && field + 8 <= e + 4 + len) {
+                    uncompr_bytes = *(uint64_t*) &extra[field];
+                    field += 8;
+                }
+                if (compr_bytes == ZIP_MAX_FIELD && field + 8 <= e + 4 + len) {
+                    compr_bytes = *(uint64_t*) &extra[field];
+                    field += 8;
+                }
+                if (local_offset == ZIP_MAX_FIELD && field + 8 <= e + 4 + len) {
+                    local_offset = *(uint64_t*) &extra[field];
+                }
+            }
+            e += 4 + len;
+        }
+        pos += 46 + name_len + extra_len + comment_len;
+
+        //only stored npy members can be used in place
+        if (compr_method != 0 || compr_bytes != uncompr_bytes) return false;
+        if (fname.size() < 4 || fname.compare(fname.size() - 4, 4, ".npy") != 0)
+            return false;
+        fname.erase(fname.end() - 4, fname.end());
+
+        if (local_offset + 30 > size ||
+            *(uint32_t*) &buf[local_offset] != 0x04034b50)
+            return false;
+        size_t data_start = local_offset + 30 +
+                            *(uint16_t*) &buf[local_offset + 26] +
+                            *(uint16_t*) &buf[local_offset + 28];
+        //npy format version 1.0 only
+        if (data_start + 10 > size || buf[data_start + 6] != 0x01 ||
+            memcmp(&buf[data_start + 1], "NUMPY", 5) != 0)
+            return false;
+        size_t header_len = *(uint16_t*) &buf[data_start + 8];
+        if (data_start + 10 + header_len > size) return false;
+
+        NpzEntry entry;
+        parse_npy_header((unsigned char*) &buf[data_start], entry.word_size,
+                         entry.type, entry.shape, entry.fortran_order);
+        size_t num_vals = 1;
+        for (auto n : entry.shape) num_vals *= n;
+        entry.crc = crc;
+        entry.payload_offset = data_start;
+        entry.offset = data_start + 10 + header_len;
+        entry.num_bytes = num_vals * entry.word_size;
+        if (entry.num_bytes + 10 + header_len != uncompr_bytes ||
+            entry.offset + entry.num_bytes > size)
+            return false;
+        index[fname] = entry;
+    }
+    return true;
 }
 
 static NpyArray load_the_npy_file(FILE* fp) {
@@ -637,97 +976,160 @@ static NpyArray load_the_npy_file(FILE* fp) {
     return arr;
 }
 
-static NpyArray load_the_npz_array(FILE* fp, uint32_t compr_bytes,
-        uint32_t uncompr_bytes) {
-    std::vector<unsigned char> buffer_compr(compr_bytes);
-    std::vector<unsigned char> buffer_uncompr(uncompr_bytes);
-    size_t nread = fread(&buffer_compr[0],1,compr_bytes,fp);
-    if(nread != compr_bytes)
-        throw std::runtime_error("load_the_npy_file: failed fread");
+//positional read which does not disturb the stream, safe across threads
+static void npz_pread(int fd, void* dst, size_t size, size_t offset) {
+    char* out = (char*) dst;
+    while (size > 0) {
+        ssize_t res = pread(fd, out, size, offset);
+        if (res <= 0)
+            throw std::runtime_error("npz_load: failed pread");
+        out += res;
+        size -= res;
+        offset += res;
+    }
+}
 
-    int err;
-    z_stream d_stream;
+//inflate a deflated member straight from the file into the destination,
+//reading the compressed stream in chunks by positional reads, so members
+//of one file can be inflated concurrently
+struct NpzInflater {
+    NpzInflater(int fd, size_t offset, size_t compr_bytes)
+        : fd(fd), offset(offset), left(compr_bytes),
+          buffer(std::min(compr_bytes, (size_t)1 << 20)) {
+        d_stream.zalloc = Z_NULL;
+        d_stream.zfree = Z_NULL;
+        d_stream.opaque = Z_NULL;
+        d_stream.avail_in = 0;
+        d_stream.next_in = Z_NULL;
+        if(inflateInit2(&d_stream, -MAX_WBITS) != Z_OK)
+            throw std::runtime_error("load_the_npz_array: inflateInit failed");
+    }
+    ~NpzInflater() { inflateEnd(&d_stream); }
+
+    void read(void* dst, size_t size) {
+        unsigned char* out = (unsigned char*) dst;
+        while (size > 0) {
+            if (d_stream.avail_in == 0 && left > 0) {
+                size_t chunk = std::min(left, buffer.size());
+                npz_pread(fd, &buffer[0], chunk, offset);
+                offset += chunk;
+                left -= chunk;
+                d_stream.next_in = &buffer[0];
+                d_stream.avail_in = (uInt) chunk;
+            }
+            uInt out_chunk = (uInt) std::min<size_t>(size, (size_t)1 << 30);
+            d_stream.next_out = out;
+            d_stream.avail_out = out_chunk;
+            int err = inflate(&d_stream, Z_NO_FLUSH);
+            size_t produced = out_chunk - d_stream.avail_out;
+            if ((err != Z_OK && err != Z_STREAM_END) ||
+                (err == Z_STREAM_END && produced < size))
+                throw std::runtime_error("load_the_npz_array: inflate failed");
+            out += produced;
+            size -= produced;
+        }
+    }
 
-    d_stream.zalloc = Z_NULL;
-    d_stream.zfree = Z_NULL;
-    d_stream.opaque = Z_NULL;
-    d_stream.avail_in = 0;
-    d_stream.next_in = Z_NULL;
-    err = inflateInit2(&d_stream, -MAX_WBITS);
-    assert(err = 0);
+    int fd;
+    size_t offset;
+    size_t left;
+    std::vector<unsigned char> buffer;
+    z_stream d_stream;
+};
 
-    d_stream.avail_in = compr_bytes;
-    d_stream.next_in = &buffer_compr[0];
-    d_stream.avail_out = uncompr_bytes;
-    d_stream.next_out = &buffer_uncompr[0];
+static NpyArray load_the_npz_array(int fd, size_t offset, size_t compr_bytes,
+        size_t uncompr_bytes) {
+    NpzInflater inflater(fd, offset, compr_bytes);
 
-    err = inflate(&d_stream, Z_FINISH);
-    assert(err = 0);
-    err = inflateEnd(&d_stream);
-    assert(err = 0);
+    //preamble is 10 bytes, then the dict of header_len bytes
+    std::vector<unsigned char> npy_header(10);
+    inflater.read(&npy_header[0], 10);
+    uint16_t header_len = *reinterpret_cast<uint16_t*>(&npy_header[8]);
+    npy_header.resize(10 + header_len);
+    inflater.read(&npy_header[10], header_len);
 
     std::vector<size_t> shape;
     size_t word_size;
     char type;
     bool fortran_order;
-    parse_npy_header(&buffer_uncompr[0],word_size,type,shape,fortran_order);
+    parse_npy_header(&npy_header[0],word_size,type,shape,fortran_order);
 
     NpyArray array(shape, word_size, type, fortran_order);
+    if (npy_header.size() + array.num_bytes() != uncompr_bytes)
+        throw std::runtime_error("load_the_npz_array: size mismatch");
+    inflater.read(array.data<unsigned char>(), array.num_bytes());
+    return array;
+}
 
-    size_t offset = uncompr_bytes - array.num_bytes();
-    memcpy(array.data<unsigned char>(),&buffer_uncompr[0]+offset,array.num_bytes());
-
+static NpyArray load_the_npz_array(FILE* fp, size_t compr_bytes,
+        size_t uncompr_bytes) {
+    size_t offset = ftello(fp);
+    NpyArray array = load_the_npz_array(fileno(fp), offset, compr_bytes,
+                                        uncompr_bytes);
+    //leave fp at the end of this member
+    fseeko(fp, offset + compr_bytes, SEEK_SET);
     return array;
 }
 
-npz_t npz_load(std::string fname) {
-    npz_t arrays;
-    arrays.clear();
+//read the next local file header, return false once the central directory
+//is reached. sizes come from the zip64 extra field when they overflow.
+static bool read_local_header(FILE* fp, std::string& varname,
+        uint16_t& compr_method, size_t& compr_bytes, size_t& uncompr_bytes) {
+    std::vector<char> local_header(30);
+    size_t headerres = fread(&local_header[0],sizeof(char),30,fp);
+    if(headerres != 30)
+        return false;
+
+    //if we've reached the global header, stop reading
+    if(local_header[2] != 0x03 || local_header[3] != 0x04) return false;
+
+    //read in the variable name
+    uint16_t name_len = *(uint16_t*) &local_header[26];
+    varname.assign(name_len,' ');
+    size_t vname_res = fread(&varname[0],sizeof(char),name_len,fp);
+    if(vname_res != name_len)
+        throw std::runtime_error("npz_load: failed fread");
+
+    //erase the lagging .npy
+    varname.erase(varname.end()-4,varname.end());
+
+    compr_method = *reinterpret_cast<uint16_t*>(&local_header[0]+8);
+    compr_bytes = *reinterpret_cast<uint32_t*>(&local_header[0]+18);
+    uncompr_bytes = *reinterpret_cast<uint32_t*>(&local_header[0]+22);
+
+    //read in the extra field
+    uint16_t extra_field_len = *(uint16_t*) &local_header[28];
+    if(extra_field_len > 0) {
+        std::vector<char> buff(extra_field_len);
+        size_t efield_res = fread(&buff[0],sizeof(char),extra_field_len,fp);
+        if(efield_res != extra_field_len)
+            throw std::runtime_error("npz_load: failed fread");
+        for (size_t pos = 0; pos + 4 <= buff.size();) {
+            uint16_t tag = *(uint16_t*) &buff[pos];
+            uint16_t size = *(uint16_t*) &buff[pos + 2];
+            if (tag == 0x01) {
+                size_t field = pos + 4;
+                if (uncompr_bytes == ZIP_MAX_FIELD && field + 8 <= pos + 4 + size) {
+                    uncompr_bytes = *(uint64_t*) &buff[field];
+                    field += 8;
+                }
+                if (compr_bytes == ZIP_MAX_FIELD && field + 8 <= pos + 4 + size) {
+                    compr_bytes = *(uint64_t*) &buff[field];
+                }
+            }
+            pos += 4 + size;
+        }
+    }
+    return true;
+}
 
+npz_t npz_load(std::string fname) {
     FILE* fp = fopen(fname.c_str(),"rb");
     if(!fp) {
         //throw std::runtime_error("npz_load: Error! Unable to open file "+fname+"!");
-        return arrays;
-    }
-
-    while(1) {
-        std::vector<char> local_header(30);
-        size_t headerres = fread(&local_header[0],sizeof(char),30,fp);
-        if(headerres != 30)
-            break;
-
-        //if we've reached the global header, stop reading
-        if(local_header[2] != 0x03 || local_header[3] != 0x04) break;
-
-        //read in the variable name
-        uint16_t name_len = *(uint16_t*) &local_header[26];
-        std::string varname(name_len,' ');
-        size_t vname_res = fread(&varname[0],sizeof(char),name_len,fp);
-        if(vname_res != name_len)
-            throw std::runtime_error("npz_load: failed fread");
-
-        //erase the lagging .npy
-        varname.erase(varname.end()-4,varname.end());
-
-        //read in the extra field
-        uint16_t extra_field_len = *(uint16_t*) &local_header[28];
-        if(extra_field_len > 0) {
-            std::vector<char> buff(extra_field_len);
-            size_t efield_res = fread(&buff[0],sizeof(char),extra_field_len,fp);
-            if(efield_res != extra_field_len)
-                throw std::runtime_error("npz_load: failed fread");
-        }
-
-        uint16_t compr_method = *reinterpret_cast<uint16_t*>(&local_header[0]+8);
-        uint32_t compr_bytes = *reinterpret_cast<uint32_t*>(&local_header[0]+18);
-        uint32_t uncompr_bytes = *reinterpret_cast<uint32_t*>(&local_header[0]+22);
-
-        if(compr_method == 0) {arrays[varname] = load_the_npy_file(fp);}
-        else {arrays[varname] = load_the_npz_array(fp,compr_bytes,uncompr_bytes);}
+        return npz_t();
     }
-
-    fclose(fp);
-    return arrays;
+    return npz_load(fp);
 }
 
 npz_t npz_load(FILE* fp) {
@@ -739,43 +1141,63 @@ npz_t npz_load(FILE* fp) {
         return arrays;
     }
 
-    while(1) {
-        std::vector<char> local_header(30);
-        size_t headerres = fread(&local_header[0],sizeof(char),30,fp);
-        if(headerres != 30)
-            break;
-
-        //if we've reached the global header, stop reading
-        if(local_header[2] != 0x03 || local_header[3] != 0x04) break;
-
-        //read in the variable name
-        uint16_t name_len = *(uint16_t*) &local_header[26];
-        std::string varname(name_len,' ');
-        size_t vname_res = fread(&varname[0],sizeof(char),name_len,fp);
-        if(vname_res != name_len)
-            throw std::runtime_error("npz_load: failed fread");
-
-        //erase the lagging .npy
-        varname.erase(varname.end()-4,varname.end());
-
-        //read in the extra field
-        uint16_t extra_field_len = *(uint16_t*) &local_header[28];
-        if(extra_field_len > 0) {
-            std::vector<char> buff(extra_field_len);
-            size_t efield_res = fread(&buff[0],sizeof(char),extra_field_len,fp);
-            if(efield_res != extra_field_len)
-                throw std::runtime_error("npz_load: failed fread");
+    //walk the local headers to locate every member first, then read and
+    //inflate the members in parallel
+    struct Member {
+        std::string varname;
+        uint16_t compr_method;
+        size_t compr_bytes;
+        size_t uncompr_bytes;
+        size_t offset; //offset of the array data or of the deflated stream
+        std::vector<size_t> shape;
+        size_t word_size;
+        char type;
+        bool fortran_order;
+    };
+    std::vector<Member> members;
+    Member m;
+    while(read_local_header(fp,m.varname,m.compr_method,m.compr_bytes,
+                            m.uncompr_bytes)) {
+        if(m.compr_method == 0) {
+            parse_npy_header(fp,m.word_size,m.type,m.shape,m.fortran_order);
+            m.offset = ftello(fp);
+            size_t num_vals = 1;
+            for(auto n : m.shape) num_vals *= n;
+            fseeko(fp,num_vals * m.word_size,SEEK_CUR);
+        } else {
+            m.offset = ftello(fp);
+            fseeko(fp,m.compr_bytes,SEEK_CUR);
         }
+        members.push_back(m);
+    }
 
-        uint16_t compr_method = *reinterpret_cast<uint16_t*>(&local_header[0]+8);
-        uint32_t compr_bytes = *reinterpret_cast<uint32_t*>(&local_header[0]+18);
-        uint32_t uncompr_bytes = *reinterpret_cast<uint32_t*>(&local_header[0]+22);
-
-        if(compr_method == 0) {arrays[varname] = load_the_npy_file(fp);}
-        else {arrays[varname] = load_the_npz_array(fp,compr_bytes,uncompr_bytes);}
+    int fd = fileno(fp);
+    std::vector<NpyArray> loaded(members.size());
+    std::string error;
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int64_t i = 0; i < (int64_t)members.size(); i++) {
+        const Member &member = members[i];
+        try {
+            if(member.compr_method == 0) {
+                NpyArray arr(member.shape, member.word_size, member.type,
+                             member.fortran_order);
+                npz_pread(fd,arr.data<char>(),arr.num_bytes(),member.offset);
+                loaded[i] = arr;
+            } else {
+                loaded[i] = load_the_npz_array(fd,member.offset,
+                        member.compr_bytes,member.uncompr_bytes);
+            }
+        } catch (const std::exception &e) {
+            #pragma omp critical
+            error = e.what();
+        }
     }
 
     fclose(fp);
+    if(!error.empty())
+        throw std::runtime_error(error);
+    for(size_t i = 0; i < members.size(); i++)
+        arrays[members[i].varname] = loaded[i];
     return arrays;
 }
 
@@ -784,31 +1206,10 @@ NpyArray npz_load(std::string fname, std::string varname) {
 
     if(!fp) throw std::runtime_error("npz_load: Unable to open file "+fname);
 
-    while(1) {
-        std::vector<char> local_header(30);
-        size_t header_res = fread(&local_header[0],sizeof(char),30,fp);
-        if(header_res != 30)
-            throw std::runtime_error("npz_load: failed fread");
-
-        //if we've reached the global header, stop reading
-        if(local_header[2] != 0x03 || local_header[3] != 0x04) break;
-
-        //read in the variable name
-        uint16_t name_len = *(uint16_t*) &local_header[26];
-        std::string vname(name_len,' ');
-        size_t vname_res = fread(&vname[0],sizeof(char),name_len,fp);
-        if(vname_res != name_len)
-            throw std::runtime_error("npz_load: failed fread");
-        vname.erase(vname.end()-4,vname.end()); //erase the lagging .npy
-
-        //read in the extra field
-        uint16_t extra_field_len = *(uint16_t*) &local_header[28];
-        fseek(fp,extra_field_len,SEEK_CUR); //skip past the extra field
-
-        uint16_t compr_method = *reinterpret_cast<uint16_t*>(&local_header[0]+8);
-        uint32_t compr_bytes = *reinterpret_cast<uint32_t*>(&local_header[0]+18);
-        uint32_t uncompr_bytes = *reinterpret_cast<uint32_t*>(&local_header[0]+22);
-
+    std::string vname;
+    uint16_t compr_method;
+    size_t compr_bytes, uncompr_bytes;
+    while(read_local_header(fp,vname,compr_method,compr_bytes,uncompr_bytes)) {
         if(vname == varname) {
             NpyArray array  = (compr_method == 0) ? load_the_npy_file(fp)
                               : load_the_npz_array(fp,compr_bytes,uncompr_bytes);
@@ -817,8 +1218,7 @@ NpyArray npz_load(std::string fname, std::string varname) {
         }
         else {
             //skip past the data
-            uint32_t size = *(uint32_t*) &local_header[22];
-            fseek(fp,size,SEEK_CUR);
+            fseeko(fp,compr_bytes,SEEK_CUR);
         }
     }
 
@@ -65,13 +65,27 @@ struct NpyArray {
 
 using npz_t = std::map<std::string, NpyArray>;
 
+//location of a stored (uncompressed) array inside an npz file
+struct NpzEntry {
+    std::vector<size_t> shape;
+    size_t word_size;
+    char type;
+    bool fortran_order;
+    size_t offset; //offset of the array data from the start of the file
+    size_t num_bytes;
+    size_t payload_offset; //offset of the npy header
+    uint32_t crc; //crc of the npy header and data
+};
+
+using npz_index_t = std::map<std::string, NpzEntry>;
+
 std::vector<char> create_npy_header(const std::vector<size_t>& shape,
     size_t word_size, char type);
 void parse_npy_header(FILE* fp,size_t& word_size, char& type,
         std::vector<size_t>& shape, bool& fortran_order);
 void parse_npy_header(unsigned char* buffer, size_t& word_size, char& type,
         std::vector<size_t>& shape, bool& fortran_order);
-void parse_zip_footer(FILE* fp, uint16_t& nrecs, size_t& global_header_size,
+void parse_zip_footer(FILE* fp, size_t& nrecs, size_t& global_header_size,
         size_t& global_header_offset);
 npz_t npz_load(FILE* fp);
 npz_t npz_load(std::string fname);
@@ -113,7 +127,14 @@ void npz_add_array(npz_t &map, std::string fname,
 
 void npz_clone_array(npz_t &map, std::string fname, std::string new_name);
 
-void npz_save_all(std::string zipname, npz_t &map);
+//compress deflates the arrays in parallel, as numpy.savez_compressed
+void npz_save_all(std::string zipname, npz_t &map, bool compress = false);
+//save arrays from map and arrays indexed in the npz file mapped at base
+void npz_save_all(std::string zipname, npz_t &map, const npz_index_t &index,
+        const char *base, bool compress = false);
+//index the arrays of an npz file held in memory, return false if any member
+//can not be used in place (compressed or not npy 1.0)
+bool npz_index(const char *buf, size_t size, npz_index_t &index);
 
 } // namespace cnpy
 
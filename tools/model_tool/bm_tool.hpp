@@ -11,12 +11,16 @@
 #include <fstream>
 #include <unistd.h>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <set>
 #include <string>
+#include <tuple>
 #include <vector>
 #include <sys/stat.h>
 #include "tpu_mlir/Builder/BM168x/bmodel.hpp"
 #include "flatbuffers/idl.h"
+#include "flatbuffers/reflection.h"
 #include "flatbuffers/util.h"
 #include "tpu_mlir/Builder/BM168x/bmodel_fbs.h"
 
@@ -321,10 +325,46 @@ void bm_show_dynamic(const string &filename) {
   }
 }
 
-// update binary data when copy one net to new flatbuffers
+// bmodel schema, parsed once and shared by all reflection users
+static Parser &bmodel_parser() {
+  static Parser parser;
+  static bool parsed = false;
+  if (parsed == false) {
+    if (true != parser.Parse(schema_text)) {
+      FATAL("parse schema failed");
+    }
+    // binary schema for CopyTable
+    parser.Serialize();
+    parsed = true;
+  }
+  return parser;
+}
+
+// copy one net parameter to new flatbuffers directly, without the
+// UnPack/Pack round trip through object api
+static Offset<NetParameter> copy_net_parameter(FlatBufferBuilder &builder,
+                                               const NetParameter *param) {
+  auto schema =
+      reflection::GetSchema(bmodel_parser().builder_.GetBufferPointer());
+  auto object = schema->objects()->LookupByKey("bmodel.NetParameter");
+  if (object == NULL) {
+    FATAL("NetParameter not found in schema");
+  }
+  auto offset = CopyTable(builder, *schema, *object,
+                          *reinterpret_cast<const Table *>(param));
+  return Offset<NetParameter>(offset.o);
+}
+
+typedef struct {
+  Binary *binary;      // binary in new flatbuffers, start to be updated
+  ModelCtx *model_ctx; // bmodel the binary data comes from
+} BINARY_REF_T;
+
+// collect binaries when copy one net to new flatbuffers
 // it's a little complicated, using reflection of flatbuffers
-static void update_table(Table *table, const StructDef *struct_def,
-                         ModelGen &model_gen, ModelCtx &model_ctx) {
+static void collect_binary(Table *table, const StructDef *struct_def,
+                           ModelCtx &model_ctx,
+                           vector<BINARY_REF_T> &binary_refs) {
   for (auto fd : struct_def->fields.vec) {
     if (false == table->CheckField(fd->value.offset)) {
       continue;
@@ -335,16 +375,12 @@ static void update_table(Table *table, const StructDef *struct_def,
       if (next_def->fixed) {
         if (next_def->name == "Binary") {
           auto binary = table->GetStruct<Binary *>(fd->value.offset);
-          uint8_t *data = new uint8_t[binary->size()];
-          model_ctx.read_binary(binary, data);
-          auto new_binary = model_gen.WriteBinary(binary->size(), data);
-          binary->mutate_start(new_binary.start());
-          delete[] data;
+          binary_refs.push_back({binary, &model_ctx});
         }
       } else {
         auto next_pointer = table->GetPointer<void *>(fd->value.offset);
         auto next_table = reinterpret_cast<Table *>(next_pointer);
-        update_table(next_table, next_def, model_gen, model_ctx);
+        collect_binary(next_table, next_def, model_ctx, binary_refs);
       }
       break;
     }
@@ -362,11 +398,7 @@ static void update_table(Table *table, const StructDef *struct_def,
                next_id++) {
             auto next_pointer = vector_pointer->GetMutableObject(next_id);
             auto binary = reinterpret_cast<Binary *>(next_pointer);
-            uint8_t *data = new uint8_t[binary->size()];
-            model_ctx.read_binary(binary, data);
-            auto new_binary = model_gen.WriteBinary(binary->size(), data);
-            binary->mutate_start(new_binary.start());
-            delete[] data;
+            binary_refs.push_back({binary, &model_ctx});
           }
         }
         break;
@@ -374,7 +406,7 @@ static void update_table(Table *table, const StructDef *struct_def,
       for (uint32_t next_id = 0; next_id < vector_pointer->size(); next_id++) {
         auto next_pointer = vector_pointer->GetMutableObject(next_id);
         auto next_table = reinterpret_cast<Table *>(next_pointer);
-        update_table(next_table, next_def, model_gen, model_ctx);
+        collect_binary(next_table, next_def, model_ctx, binary_refs);
       }
       break;
     }
@@ -385,21 +417,70 @@ static void update_table(Table *table, const StructDef *struct_def,
   }
 }
 
+// copy binary data of collected binaries to model_gen, and update start.
+// data is read from mapped bmodels without copy, hashed in parallel, then
+// written in order, so the result is the same as writing one by one.
+// binaries with same content are stored once, even across bmodels.
+static void update_binary(ModelGen &model_gen,
+                          vector<BINARY_REF_T> &binary_refs) {
+  size_t num = binary_refs.size();
+  vector<const uint8_t *> data(num);
+  vector<uint64_t> hash(num);
+  vector<Binary> new_binary(num);
+  // the same source binary referenced again, e.g. coeff shared by stages
+  vector<size_t> first(num);
+  map<std::tuple<const ModelCtx *, uint64_t, uint64_t>, size_t> source;
+  vector<unique_ptr<uint8_t[]>> buffers;
+  for (size_t i = 0; i < num; i++) {
+    auto &ref = binary_refs[i];
+    auto key = std::make_tuple(ref.model_ctx, ref.binary->start(),
+                               ref.binary->size());
+    first[i] = source.emplace(key, i).first->second;
+    if (first[i] != i) {
+      continue;
+    }
+    data[i] = ref.model_ctx->binary_data(ref.binary);
+    if (data[i] == NULL) { // bmodel not mapped, read from file
+      buffers.emplace_back(new uint8_t[ref.binary->size()]);
+      ref.model_ctx->read_binary(ref.binary, buffers.back().get());
+      data[i] = buffers.back().get();
+    }
+  }
+#pragma omp parallel for schedule(dynamic)
+  for (size_t i = 0; i < num; i++) {
+    if (first[i] == i) {
+      hash[i] = ModelGen::HashBinary(data[i], binary_refs[i].binary->size());
+    }
+  }
+  for (size_t i = 0; i < num; i++) {
+    auto binary = binary_refs[i].binary;
+    if (first[i] == i) {
+      new_binary[i] = model_gen.WriteBinary(
+          binary->size(), const_cast<uint8_t *>(data[i]), hash[i]);
+    }
+  }
+  // update start after all written, source keys above use the old start
+  for (size_t i = 0; i < num; i++) {
+    binary_refs[i].binary->mutate_start(new_binary[first[i]].start());
+  }
+}
+
 // update whole model binary data
 static void update_model(ModelGen &model_gen, ModelCtx &model_ctx) {
-  Parser parser;
-  parser.Parse(schema_text);
+  auto &parser = bmodel_parser();
   auto buffer = model_gen.GetBufferPointer();
   auto root = GetMutableRoot<Table>(buffer);
   auto root_def = parser.root_struct_def_;
-  update_table(root, root_def, model_gen, model_ctx);
+  vector<BINARY_REF_T> binary_refs;
+  collect_binary(root, root_def, model_ctx, binary_refs);
+  update_binary(model_gen, binary_refs);
 }
 
-// update one net binary data
-static void update_net(ModelGen &model_gen, ModelCtx &model_ctx,
-                       uint32_t net_idx = 0, uint32_t sub_idx = 0) {
-  Parser parser;
-  parser.Parse(schema_text);
+// collect binaries of one net
+static void collect_net_binary(ModelGen &model_gen, ModelCtx &model_ctx,
+                               uint32_t net_idx, uint32_t sub_idx,
+                               vector<BINARY_REF_T> &binary_refs) {
+  auto &parser = bmodel_parser();
   auto buffer = model_gen.GetBufferPointer();
   auto root_table = GetMutableRoot<Table>(buffer);
   auto root_def = parser.root_struct_def_;
@@ -416,7 +497,15 @@ static void update_net(ModelGen &model_gen, ModelCtx &model_ctx,
   auto sub_net_pointer = reinterpret_cast<Vector<Offset<void>> *>(sub_pointer)
                              ->GetMutableObject(sub_idx);
   auto sub_net_table = reinterpret_cast<Table *>(sub_net_pointer);
-  update_table(sub_net_table, sub_net_def, model_gen, model_ctx);
+  collect_binary(sub_net_table, sub_net_def, model_ctx, binary_refs);
+}
+
+// update one net binary data
+static void update_net(ModelGen &model_gen, ModelCtx &model_ctx,
+                       uint32_t net_idx = 0, uint32_t sub_idx = 0) {
+  vector<BINARY_REF_T> binary_refs;
+  collect_net_binary(model_gen, model_ctx, net_idx, sub_idx, binary_refs);
+  update_binary(model_gen, binary_refs);
 }
 
 // extract multi-net bmodel to multi one-net bmodels
@@ -547,13 +636,18 @@ static void combine_bmodels(ModelGen &model_gen,
       auto km = model->kernel_module();
       if (km) {
         auto binary = km->binary();
-        uint8_t *data = new uint8_t[binary->size()];
-        model_info->model_ctx->read_binary(binary, data);
-        auto new_binary = model_gen.WriteBinary(binary->size(), data);
+        std::unique_ptr<uint8_t[]> buffer;
+        auto data = model_info->model_ctx->binary_data(binary);
+        if (data == NULL) {
+          buffer.reset(new uint8_t[binary->size()]);
+          model_info->model_ctx->read_binary(binary, buffer.get());
+          data = buffer.get();
+        }
+        auto new_binary =
+            model_gen.WriteBinary(binary->size(), const_cast<uint8_t *>(data));
         auto filename = km->file_name()->str();
         model_gen.AddKernelModule(filename, new_binary);
         kernel_load = true;
-        delete[] data;
       }
     }
     for (uint32_t net_idx = 0; net_idx < model->net()->size(); net_idx++) {
@@ -574,24 +668,27 @@ static void combine_bmodels(ModelGen &model_gen,
           read_input_output_ref(net->parameter()->Get(idx), model_info->input_f,
                                 model_info->output_f, net_idx.get());
         }
-        auto netT = net->parameter()->Get(idx)->UnPack();
-        auto net_offset = NetParameter::Pack(builder, netT);
+        auto net_offset =
+            copy_net_parameter(builder, net->parameter()->Get(idx));
         model_gen.AddNet(net_name, net_offset, &net_idx->net_idx,
                          &net_idx->stage_idx, cascade, addr_mode);
-        delete netT;
         model_info->net_index_v.push_back(net_idx);
       }
     }
   }
   model_gen.AddNumDevice(device_num);
   model_gen.Finish();
+  // relocate binaries of all nets at once, so they are deduplicated across
+  // bmodels and hashed in one parallel pass
+  vector<BINARY_REF_T> binary_refs;
   for (uint32_t idx = 0; idx < model_vec.size(); idx++) {
     auto &model_info = model_vec[idx];
     for (auto &net_index : model_info->net_index_v) {
-      update_net(model_gen, *model_info->model_ctx, net_index->net_idx,
-                 net_index->stage_idx);
+      collect_net_binary(model_gen, *model_info->model_ctx, net_index->net_idx,
+                         net_index->stage_idx, binary_refs);
     }
   }
+  update_binary(model_gen, binary_refs);
   if (is_dir) {
     write_input_output_ref(model_vec);
   }
@@ -713,11 +810,15 @@ void bm_dump_binary(int argc, char **argv) {
   if (!ofile) {
     FATAL("save file[%s] failed\n", argv[5]);
   }
-  uint8_t *data = new uint8_t[size];
   Binary binary(start, size);
-  model.read_binary(&binary, data);
-  ofile.write((char *)data, size);
+  std::unique_ptr<uint8_t[]> buffer;
+  auto data = model.binary_data(&binary);
+  if (data == NULL) {
+    buffer.reset(new uint8_t[size]);
+    model.read_binary(&binary, buffer.get());
+    data = buffer.get();
+  }
+  ofile.write((const char *)data, size);
   ofile.close();
-  delete[] data;
   printf("save file[%s] success\n", argv[5]);
 }
@@ -93,7 +93,7 @@ static void update_weight(int argc, char **argv) {
   auto src_net = argv[6];
   auto src_offset = str2ull(argv[7]);
   printf("read dst model:%s ...\n", dst_model);
-  ModelCtx dst_model_ctx(dst_model);
+  ModelCtx dst_model_ctx(dst_model, true);
   if (!dst_model_ctx) {
     FATAL("file[%s] is not correct", dst_model);
   }
@@ -120,10 +120,14 @@ static void update_weight(int argc, char **argv) {
     FATAL("weight not the same");
   }
   printf("update weight ...\n");
-  auto src_weight = new uint8_t[src_bin.size()];
-  src_model_ctx.read_binary(&src_bin, src_weight);
-  dst_model_ctx.write_binary(&dst_bin, src_weight);
-  delete[] src_weight;
+  std::unique_ptr<uint8_t[]> buffer;
+  auto src_weight = src_model_ctx.binary_data(&src_bin);
+  if (src_weight == NULL) {
+    buffer.reset(new uint8_t[src_bin.size()]);
+    src_model_ctx.read_binary(&src_bin, buffer.get());
+    src_weight = buffer.get();
+  }
+  dst_model_ctx.write_binary(&dst_bin, (uint8_t *)src_weight);
   printf("update success\n");
 }
 
@@ -293,9 +297,14 @@ static void dump_kernel_module(int argc, char **argv) {
     if (!ofile) {
       FATAL("save file[%s] failed\n", save_name.c_str());
     }
-    std::unique_ptr<uint8_t> binary(new uint8_t[binary_size]);
-    model_ctx.read_binary(module_binary, binary.get());
-    ofile.write((char *)binary.get(), binary_size);
+    std::unique_ptr<uint8_t[]> buffer;
+    auto binary = model_ctx.binary_data(module_binary);
+    if (binary == NULL) {
+      buffer.reset(new uint8_t[binary_size]);
+      model_ctx.read_binary(module_binary, buffer.get());
+      binary = buffer.get();
+    }
+    ofile.write((const char *)binary, binary_size);
     cout << "Success: dump kernel_module to [" << save_name << "]." << endl;
     ofile.close();
   } else {
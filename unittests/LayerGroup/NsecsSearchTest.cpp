@@ -0,0 +1,104 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// TPU-MLIR is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tpu_mlir/Dialect/Tpu/Transforms/LayerGroup/NsecsSearch.h"
+#include "gtest/gtest.h"
+#include <functional>
+#include <random>
+#include <vector>
+
+using namespace tpu_mlir::tpu;
+
+namespace {
+
+// nsecs tried one by one, as update_data_split did before bisection
+int64_t linearNsecs(int64_t max_nsecs,
+                    const std::function<int64_t(int64_t)> &need) {
+  for (int64_t nsecs = 1; nsecs <= max_nsecs; ++nsecs) {
+    int64_t secs = need(nsecs);
+    if (secs <= 0) {
+      return -1;
+    }
+    if (secs <= nsecs || nsecs == max_nsecs) {
+      return nsecs;
+    }
+  }
+  return -1;
+}
+
+void expectSameAsLinear(int64_t max_nsecs,
+                        const std::function<int64_t(int64_t)> &need) {
+  int64_t last = 1;
+  int64_t calls = 0;
+  int64_t secs = need(1);
+  int64_t nsecs = search_min_nsecs(max_nsecs, secs, [&](int64_t n) {
+    last = n;
+    calls++;
+    return need(n);
+  });
+  EXPECT_EQ(nsecs, linearNsecs(max_nsecs, need));
+  if (nsecs <= 0) {
+    return;
+  }
+  // the last call is the one of the result, so state kept for it is valid
+  EXPECT_EQ(last, nsecs);
+  EXPECT_EQ(secs, need(nsecs));
+  // about log2 of the need without split, plus one call to restore
+  EXPECT_LE(calls, 2 + 64 - __builtin_clzll(need(1)));
+}
+
+} // namespace
+
+TEST(NsecsSearch, ProportionalNeed) {
+  for (int64_t total = 1; total <= 64; ++total) {
+    for (int64_t max_nsecs = 1; max_nsecs <= 70; ++max_nsecs) {
+      expectSameAsLinear(max_nsecs, [total](int64_t n) {
+        return (total + n - 1) / n;
+      });
+    }
+  }
+}
+
+// need with a part that split of n does not reduce, as weights
+TEST(NsecsSearch, NeedWithFixedPart) {
+  for (int64_t fixed = 0; fixed <= 8; ++fixed) {
+    for (int64_t total = 1; total <= 40; ++total) {
+      for (int64_t max_nsecs = 1; max_nsecs <= 50; ++max_nsecs) {
+        expectSameAsLinear(max_nsecs, [=](int64_t n) {
+          return fixed + (total + n - 1) / n;
+        });
+      }
+    }
+  }
+}
+
+TEST(NsecsSearch, RandomMonotoneNeed) {
+  std::mt19937 gen(20221);
+  for (int iter = 0; iter < 2000; ++iter) {
+    int64_t max_nsecs = gen() % 100 + 1;
+    // any non increasing need, not only ceil(total / n)
+    std::vector<int64_t> need(max_nsecs + 1);
+    need[1] = gen() % 200 + 1;
+    for (int64_t n = 2; n <= max_nsecs; ++n) {
+      need[n] = std::max<int64_t>(1, need[n - 1] - (int64_t)(gen() % 5));
+    }
+    expectSameAsLinear(max_nsecs, [&](int64_t n) { return need[n]; });
+  }
+}
+
+// slicing fails from some nsecs on, the result is only valid below it
+TEST(NsecsSearch, FailFromNsecs) {
+  for (int64_t total = 1; total <= 64; ++total) {
+    for (int64_t fail = 2; fail <= 40; ++fail) {
+      expectSameAsLinear(32, [=](int64_t n) {
+        return n >= fail ? (int64_t)-1 : (total + n - 1) / n;
+      });
+    }
+  }
+}
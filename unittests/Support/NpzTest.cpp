@@ -0,0 +1,315 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// TPU-MLIR is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "cnpy.h"
+#include "gtest/gtest.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+std::string tempPath(const std::string &name) {
+  const char *dir = getenv("TMPDIR");
+  return std::string(dir ? dir : "/tmp") + "/tpu_mlir_npz_test_" +
+         std::to_string(getpid()) + "_" + name;
+}
+
+std::vector<char> readFile(const std::string &path) {
+  FILE *fp = fopen(path.c_str(), "rb");
+  EXPECT_NE(fp, nullptr);
+  fseeko(fp, 0, SEEK_END);
+  std::vector<char> buf(ftello(fp));
+  fseeko(fp, 0, SEEK_SET);
+  EXPECT_EQ(fread(buf.data(), 1, buf.size(), fp), buf.size());
+  fclose(fp);
+  return buf;
+}
+
+std::string memberName(int i) { return "t" + std::to_string(i); }
+
+// one small float array per member, value derived from the index
+cnpy::npz_t makeManyMembers(int num) {
+  cnpy::npz_t map;
+  for (int i = 0; i < num; i++) {
+    std::vector<float> data = {(float)i, (float)-i};
+    cnpy::npz_add_array<float>(map, memberName(i), data);
+  }
+  return map;
+}
+
+void expectManyMembers(const cnpy::npz_t &map, int num) {
+  ASSERT_EQ(map.size(), (size_t)num);
+  for (int i = 0; i < num; i += 997) {
+    auto iter = map.find(memberName(i));
+    ASSERT_NE(iter, map.end());
+    auto data = iter->second.as_vec<float>();
+    ASSERT_EQ(data.size(), 2);
+    EXPECT_EQ(data[0], (float)i);
+    EXPECT_EQ(data[1], (float)-i);
+  }
+}
+
+template <typename T>
+void put(std::vector<char> &buf, T value) {
+  buf.insert(buf.end(), (char *)&value, (char *)&value + sizeof(T));
+}
+
+void put(std::vector<char> &buf, const std::string &str) {
+  buf.insert(buf.end(), str.begin(), str.end());
+}
+
+void pwriteAll(int fd, const std::vector<char> &buf, size_t offset) {
+  ASSERT_EQ(pwrite(fd, buf.data(), buf.size(), offset), (ssize_t)buf.size());
+}
+
+} // namespace
+
+// more than 65535 members need the zip64 end of central directory record
+TEST(Npz, ManyMembersRoundTrip) {
+  const int num = 70000;
+  auto path = tempPath("many.npz");
+  auto map = makeManyMembers(num);
+  cnpy::npz_save_all(path, map);
+
+  size_t nrecs, global_header_size, global_header_offset;
+  FILE *fp = fopen(path.c_str(), "rb");
+  ASSERT_NE(fp, nullptr);
+  cnpy::parse_zip_footer(fp, nrecs, global_header_size, global_header_offset);
+  fclose(fp);
+  EXPECT_EQ(nrecs, (size_t)num);
+
+  expectManyMembers(cnpy::npz_load(path), num);
+  auto one = cnpy::npz_load(path, memberName(num - 1));
+  EXPECT_EQ(one.as_vec<float>()[0], (float)(num - 1));
+  remove(path.c_str());
+}
+
+// members indexed in place are carried over when the file is saved again
+TEST(Npz, ManyMembersIndexAndResave) {
+  const int num = 70000;
+  auto path = tempPath("index.npz");
+  auto resaved = tempPath("resaved.npz");
+  auto map = makeManyMembers(num);
+  cnpy::npz_save_all(path, map);
+
+  auto buf = readFile(path);
+  cnpy::npz_index_t index;
+  ASSERT_TRUE(cnpy::npz_index(buf.data(), buf.size(), index));
+  ASSERT_EQ(index.size(), (size_t)num);
+  auto &entry = index.at(memberName(12345));
+  EXPECT_EQ(*(float *)&buf[entry.offset], 12345.0f);
+
+  // replace one member, keep the others from the index
+  index.erase(memberName(7));
+  cnpy::npz_t changed;
+  std::vector<float> data = {100.0f, 200.0f};
+  cnpy::npz_add_array<float>(changed, memberName(7), data);
+  cnpy::npz_save_all(resaved, changed, index, buf.data());
+
+  auto loaded = cnpy::npz_load(resaved);
+  expectManyMembers(loaded, num);
+  EXPECT_EQ(loaded.at(memberName(7)).as_vec<float>()[1], 200.0f);
+  EXPECT_EQ(loaded.at(memberName(8)).as_vec<float>()[0], 8.0f);
+  remove(path.c_str());
+  remove(resaved.c_str());
+}
+
+// a hand made archive whose second member and central directory live above
+// 4GB, the gap is a sparse stored member so the file takes little disk
+TEST(Npz, Zip64OffsetFixture) {
+  auto path = tempPath("zip64.npz");
+  int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  ASSERT_GE(fd, 0);
+
+  const size_t big_num = ((size_t)1 << 32) + 4096;
+  std::vector<char> big_npy = cnpy::create_npy_header({big_num}, 1, 'u');
+  size_t big_bytes = big_npy.size() + big_num;
+  std::string big_name = "big.npy";
+  std::vector<char> big_local;
+  put<uint32_t>(big_local, 0x04034b50);
+  put<uint16_t>(big_local, 45);
+  put<uint16_t>(big_local, 0);
+  put<uint16_t>(big_local, 0);
+  put<uint32_t>(big_local, 0);
+  put<uint32_t>(big_local, 0); // crc, not checked by the readers below
+  put<uint32_t>(big_local, 0xFFFFFFFF);
+  put<uint32_t>(big_local, 0xFFFFFFFF);
+  put<uint16_t>(big_local, big_name.size());
+  put<uint16_t>(big_local, 20);
+  put(big_local, big_name);
+  put<uint16_t>(big_local, 0x01);
+  put<uint16_t>(big_local, 16);
+  put<uint64_t>(big_local, big_bytes);
+  put<uint64_t>(big_local, big_bytes);
+  big_local.insert(big_local.end(), big_npy.begin(), big_npy.end());
+  pwriteAll(fd, big_local, 0);
+
+  std::vector<float> small = {1.5f, -2.5f, 3.5f};
+  std::vector<char> small_npy = cnpy::create_npy_header({3}, 4, 'f');
+  size_t small_bytes = small_npy.size() + small.size() * sizeof(float);
+  uint32_t small_crc = crc32(0, (Bytef *)small_npy.data(), small_npy.size());
+  small_crc = crc32(small_crc, (Bytef *)small.data(), 3 * sizeof(float));
+  std::string small_name = "small.npy";
+  size_t small_offset = big_local.size() + big_num;
+  ASSERT_GT(small_offset, (size_t)0xFFFFFFFF);
+  std::vector<char> small_local;
+  put<uint32_t>(small_local, 0x04034b50);
+  put<uint16_t>(small_local, 20);
+  put<uint16_t>(small_local, 0);
+  put<uint16_t>(small_local, 0);
+  put<uint32_t>(small_local, 0);
+  put<uint32_t>(small_local, small_crc);
+  put<uint32_t>(small_local, small_bytes);
+  put<uint32_t>(small_local, small_bytes);
+  put<uint16_t>(small_local, small_name.size());
+  put<uint16_t>(small_local, 0);
+  put(small_local, small_name);
+  small_local.insert(small_local.end(), small_npy.begin(), small_npy.end());
+  small_local.insert(small_local.end(), (char *)small.data(),
+                     (char *)(small.data() + small.size()));
+  pwriteAll(fd, small_local, small_offset);
+
+  // central directory, sizes of big and the offset of small overflow
+  std::vector<char> central;
+  auto put_central = [&](const std::string &name, uint32_t crc, size_t bytes,
+                         size_t offset) {
+    bool big_size = bytes >= 0xFFFFFFFF;
+    bool big_offset = offset >= 0xFFFFFFFF;
+    std::vector<char> extra;
+    if (big_size) {
+      put<uint64_t>(extra, bytes);
+      put<uint64_t>(extra, bytes);
+    }
+    if (big_offset) {
+      put<uint64_t>(extra, offset);
+    }
+    put<uint32_t>(central, 0x02014b50);
+    put<uint16_t>(central, 45);
+    put<uint16_t>(central, 45);
+    put<uint16_t>(central, 0);
+    put<uint16_t>(central, 0);
+    put<uint32_t>(central, 0);
+    put<uint32_t>(central, crc);
+    put<uint32_t>(central, big_size ? 0xFFFFFFFF : bytes);
+    put<uint32_t>(central, big_size ? 0xFFFFFFFF : bytes);
+    put<uint16_t>(central, name.size());
+    put<uint16_t>(central, extra.empty() ? 0 : extra.size() + 4);
+    put<uint16_t>(central, 0);
+    put<uint16_t>(central, 0);
+    put<uint16_t>(central, 0);
+    put<uint32_t>(central, 0);
+    put<uint32_t>(central, big_offset ? 0xFFFFFFFF : offset);
+    put(central, name);
+    if (!extra.empty()) {
+      put<uint16_t>(central, 0x01);
+      put<uint16_t>(central, extra.size());
+      central.insert(central.end(), extra.begin(), extra.end());
+    }
+  };
+  put_central(big_name, 0, big_bytes, 0);
+  put_central(small_name, small_crc, small_bytes, small_offset);
+  size_t central_offset = small_offset + small_local.size();
+
+  std::vector<char> tail = central;
+  put<uint32_t>(tail, 0x06064b50);
+  put<uint64_t>(tail, 44);
+  put<uint16_t>(tail, 45);
+  put<uint16_t>(tail, 45);
+  put<uint32_t>(tail, 0);
+  put<uint32_t>(tail, 0);
+  put<uint64_t>(tail, 2);
+  put<uint64_t>(tail, 2);
+  put<uint64_t>(tail, central.size());
+  put<uint64_t>(tail, central_offset);
+  put<uint32_t>(tail, 0x07064b50);
+  put<uint32_t>(tail, 0);
+  put<uint64_t>(tail, central_offset + central.size());
+  put<uint32_t>(tail, 1);
+  put<uint32_t>(tail, 0x06054b50);
+  put<uint16_t>(tail, 0);
+  put<uint16_t>(tail, 0);
+  put<uint16_t>(tail, 2);
+  put<uint16_t>(tail, 2);
+  put<uint32_t>(tail, central.size());
+  put<uint32_t>(tail, 0xFFFFFFFF);
+  put<uint16_t>(tail, 0);
+  pwriteAll(fd, tail, central_offset);
+  size_t file_size = central_offset + tail.size();
+
+  // zip64 footer
+  FILE *fp = fdopen(dup(fd), "rb");
+  ASSERT_NE(fp, nullptr);
+  size_t nrecs, global_header_size, global_header_offset;
+  cnpy::parse_zip_footer(fp, nrecs, global_header_size, global_header_offset);
+  fclose(fp);
+  EXPECT_EQ(nrecs, 2);
+  EXPECT_EQ(global_header_size, central.size());
+  EXPECT_EQ(global_header_offset, central_offset);
+
+  // sequential reader skips the big member by its zip64 size
+  auto loaded = cnpy::npz_load(path, "small");
+  EXPECT_EQ(loaded.as_vec<float>(), small);
+
+  // in place index takes the offset from the zip64 extra
+  void *base = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ASSERT_NE(base, MAP_FAILED);
+  cnpy::npz_index_t index;
+  EXPECT_TRUE(cnpy::npz_index((const char *)base, file_size, index));
+  ASSERT_EQ(index.size(), 2);
+  EXPECT_EQ(index.at("big").num_bytes, big_num);
+  auto &entry = index.at("small");
+  EXPECT_GT(entry.offset, (size_t)0xFFFFFFFF);
+  EXPECT_EQ(entry.crc, small_crc);
+  EXPECT_EQ(memcmp((const char *)base + entry.offset, small.data(),
+                   entry.num_bytes),
+            0);
+  munmap(base, file_size);
+  close(fd);
+  remove(path.c_str());
+}
+
+// deflated members, one larger than the inflater chunk so it is read in
+// several pieces, and more than 65535 of them through the zip64 footer
+TEST(Npz, CompressedRoundTrip) {
+  auto path = tempPath("compressed.npz");
+  const int num = 70000;
+  auto map = makeManyMembers(num);
+  // pseudo random words barely compress, so the stream spans many chunks
+  std::vector<int32_t> noise(1 << 20);
+  uint32_t seed = 12345;
+  for (auto &v : noise) {
+    seed = seed * 1664525u + 1013904223u;
+    v = seed;
+  }
+  cnpy::npz_add_array<int32_t>(map, "noise", noise);
+  cnpy::npz_save_all(path, map, true);
+
+  size_t nrecs, global_header_size, global_header_offset;
+  FILE *fp = fopen(path.c_str(), "rb");
+  ASSERT_NE(fp, nullptr);
+  cnpy::parse_zip_footer(fp, nrecs, global_header_size, global_header_offset);
+  fclose(fp);
+  EXPECT_EQ(nrecs, (size_t)num + 1);
+
+  // compressed members can not be used in place
+  auto buf = readFile(path);
+  cnpy::npz_index_t index;
+  EXPECT_FALSE(cnpy::npz_index(buf.data(), buf.size(), index));
+
+  auto loaded = cnpy::npz_load(path);
+  EXPECT_EQ(loaded.at("noise").as_vec<int32_t>(), noise);
+  loaded.erase("noise");
+  expectManyMembers(loaded, num);
+
+  EXPECT_EQ(cnpy::npz_load(path, "noise").as_vec<int32_t>(), noise);
+  auto one = cnpy::npz_load(path, memberName(num - 1));
+  EXPECT_EQ(one.as_vec<float>()[1], (float)-(num - 1));
+  remove(path.c_str());
+}